@@ -3,13 +3,17 @@
 #include "ure_application.h"
 #include "ure_resources_collector.h"
 #include "ure_resources_fetcher.h"
+#include "ure_image_decoder.h"
+#include "ure_texture_loader.h"
 #include "ure_websocket.h"
 #include "ure_window.h"
 #include "ure_window_options.h"
 #include "ure_scene_graph.h"
 #include "ure_scene_layer_node.h"
 #include "ure_view_port.h"
+#include "ure_texture_residency.h"
 #include "widgets/ure_layer.h"
+#include "widgets/ure_tile_map_layer.h"
 #include "ure_utils.h"
 
 #include "core/utils.h"
@@ -19,6 +23,8 @@
 # include "imgui.h"
 #endif
 
+#define OSM_ENDPOINT "https://tile.openstreetmap.org/{z}/{x}/{y}.png"
+
 class OglGui : public ure::ApplicationEvents, public ure::WindowEvents, public ure::ResourcesFetcherEvents, public ure::WebSocketEvents
 {
 public:
@@ -75,6 +81,9 @@ private:
 
     layer->set_visible( true );
     layer->set_enabled( true );
+    layer->set_batching( true );
+    // Content is static, so it is rendered once and then drawn as a single quad.
+    layer->set_cached( true );
 
     layer->set_position( -1.0f*m_size.width/2, -1.0f*m_size.height/2, true );
 
@@ -92,8 +101,38 @@ private:
     pNode->set_model_matrix( mModel );
     pNode->get_model_matrix().translate( 0, 0, 0 );
 
+    if ( m_view_port->has_scene_graph() )
+      m_layer1 = m_view_port->get_scene().add_scene_node( pNode );    
+  }
+
+  void addMapLayer()
+  {
+    /* A local tile server can be used in place of OSM */
+    const char* url = std::getenv( "URE_TILE_SERVER" );
+
+    std::shared_ptr<ure::widgets::TileMapLayer> layer = std::make_shared<ure::widgets::TileMapLayer>( *m_view_port, (url != nullptr)?url:OSM_ENDPOINT );
+    
+    m_window->connect( layer->get_windows_events() );
+
+    layer->set_visible( true );
+    layer->set_enabled( true );
+    layer->set_batching( true );
+
+    layer->set_position( -1.0f*m_size.width/2, -1.0f*m_size.height/2, true );
+    layer->set_size( m_size.width/2, m_size.height, true );
+    layer->set_center( 12.4964, 41.9028 );
+    layer->set_zoom( 5.0 );
+
+    ure::SceneLayerNode* pNode = new(std::nothrow) ure::SceneLayerNode( "Map", layer );
+   
+    glm::mat4 mModel =  glm::ortho( -1.0f*(float)m_size.width/2, (float)m_size.width/2, (float)m_size.height/2, -1.0f*(float)m_size.height/2, 0.1f, 500.0f );
+
+    pNode->set_model_matrix( mModel );
+
     if ( m_view_port->has_scene_graph() )
       m_view_port->get_scene().add_scene_node( pNode );    
+
+    m_map = layer;
   }
 
   void init( [[__maybe_unused__]] int argc, [[__maybe_unused__]] char** argv )
@@ -101,6 +140,7 @@ private:
     const std::string sShadersPath( "./resources/shaders/" );
     const std::string sMediaPath( "./resources/media/" );
     ure::Application::initialize( core::unique_ptr<ure::ApplicationEvents>(this,false), sShadersPath );
+    ure::Application::get_instance()->set_idle_timeout( k_idle_timeout );
 
     //
     m_window = std::make_unique<ure::Window>();
@@ -163,11 +203,12 @@ private:
 
     addWallLayer();
 
-    ure::ResourcesFetcher::get_instance()->fetch( *this, "", "map-0-0-0", typeid(ure::Texture), "https://tile.openstreetmap.org/0/0/0.png",
-                                                  ure::customer_request_t::Get,
-                                                  ure::ResourcesFetcher::http_headers_t{ "Application", "json" },
-                                                  ure::ResourcesFetcher::http_body_t{}
-                                                );
+    addMapLayer();
+
+    /* Remote textures are downloaded, decoded and uploaded by the loader, "wall" is shown until then */
+    auto placeholder = m_rc->find<ure::Texture>("wall");
+    m_loader = std::make_unique<ure::TextureLoader>( placeholder.has_value()?placeholder.value():nullptr, m_rc.get() );
+    m_tile   = m_loader->load( "map-0-0-0", "https://tile.openstreetmap.org/0/0/0.png" );
   }
 
 public:
@@ -193,12 +234,20 @@ protected:
   virtual ure::void_t on_initialize() noexcept(true) override
   {
     m_rc = std::make_unique<ure::ResourcesCollector>();
+    m_rc->set_budget( 64*1024*1024 );
 
     /* If your application requires external resources than resource fetcher 
        will make this easier.
        In order to control singleton lifetime it is strongly suggested to create
        and destroy it with the application lifetim, so using on_initialize() and on_finalize() events. */
     ure::ResourcesFetcher::initialize();
+    /* Keep downloaded resources across restarts */
+    ure::ResourcesFetcher::get_instance()->set_cache( "./.ure_cache" );
+    /* Completions are notified by dispatch() in on_run(), so no lock is required */
+    ure::ResourcesFetcher::get_instance()->set_dispatch( true );
+
+    /* Images downloaded by the fetcher are decoded off the main thread. */
+    ure::ImageDecoder::initialize();
   }
   /***/
   virtual ure::void_t on_initialized() noexcept(true) override
@@ -208,8 +257,15 @@ protected:
   /***/
   virtual ure::void_t on_finalize() noexcept(true) override
   {
+    /* Pending downloads are cancelled by the loader */
+    m_loader.reset();
+    m_map.reset();
+
     /* Finalize Resource Fetcher */
     ure::ResourcesFetcher::get_instance()->finalize();
+
+    /* Finalize Image Decoder after the fetcher, so no more requests will be submitted */
+    ure::ImageDecoder::get_instance()->finalize();
   }
   /***/
   virtual ure::void_t on_finalized() noexcept(true) override
@@ -223,20 +279,31 @@ protected:
       return;
     }
 
+    // Notify downloads completed since last frame, spending at most 2ms
+    ure::ResourcesFetcher::get_instance()->dispatch( 0, 2000 );
+
+    // Move remote textures through the pipeline, spending at most 2ms on uploads
+    if ( m_loader != nullptr )
+      m_loader->update( 2000 );
+
+    /* Release expendable resources no longer in use */
+    m_rc->trim();
+
+    // Collect images decoded by worker threads, they are only shown to be ready here
+    ure::ImageDecoder::decoded_t decoded;
+    while ( ure::ImageDecoder::get_instance()->pop( decoded ) )
+    {
+      decoded.image.reset();
+    }
+
     m_window->get_framebuffer_size( m_fb_size );
     
     ///////////////
     m_view_port->set_area( 0, 0, m_fb_size.width, m_fb_size.height );
-    m_view_port->use();
 
-    // Update background color
-    if ( m_view_port->has_scene_graph() )
+    if ( m_view_port->has_scene_graph() && m_spin )
     {
-      ure::SceneGraph& sgr = m_view_port->get_scene();
-      
-      sgr.set_background( 0.2f, 0.2f, 0.2f, 0.0f );
-
-      ure::SceneLayerNode* pLayer1 = sgr.get_scene_node<ure::SceneLayerNode>("SceneNode","Layer1");
+      ure::SceneLayerNode* pLayer1 = m_view_port->get_scene().get_scene_node<ure::SceneLayerNode>( m_layer1 );
       if ( pLayer1 != nullptr )
       {
         pLayer1->get_model_matrix().rotateX(0.01);
@@ -245,11 +312,75 @@ protected:
       }
     }
 
+    // Same frame as the previous one, Application::run() waits for events instead of drawing it again.
+    if ( is_idle() )
+    {
+      m_window->process_message();
+      update_websocket();
+      return;
+    }
+
+    m_view_port->use();
+
+    // Update background color
+    if ( m_view_port->has_scene_graph() )
+    {
+      m_view_port->get_scene().set_background( 0.2f, 0.2f, 0.2f, 0.0f );
+    }
+
     ///////////////
-    m_view_port->clear_buffer( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT );
+    // Stencil is used to clip rotated layers.
+    m_view_port->clear_buffer( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT );
  
 #if defined(_IMGUI_ENABLED)
     ImGui::ShowDemoWindow(); // Show demo window! :)
+
+    // Counters collected during previous frame.
+    if ( m_window->get_state_cache() != nullptr )
+    {
+      const ure::StateCache::stats_t& stats = m_window->get_state_cache()->get_stats();
+
+      ImGui::Begin( "Renderer" );
+      ImGui::Text( "GL state calls: %u issued, %u skipped", stats.issued, stats.skipped );
+      ImGui::Text( "Widget vertices: %u bytes uploaded", ure::VertexSlab::get_instance()->get_stats().uploaded_bytes );
+      ImGui::Text( "Transforms: %u, %u world updates", ure::TransformSystem::get_instance()->get_stats().transforms, ure::TransformSystem::get_instance()->get_stats().updates );
+      ImGui::Text( "Scene nodes: %u visible, %u culled", m_view_port->get_scene().get_cull_stats().visible, m_view_port->get_scene().get_cull_stats().culled );
+      ImGui::Text( "Render queue: %u items, %u us sort", m_view_port->get_scene().get_render_queue().get_stats().items, m_view_port->get_scene().get_render_queue().get_stats().sort_us );
+
+      const ure::TextureResidency::stats_t& textures = ure::TextureResidency::get_instance()->get_stats();
+      ImGui::Text( "Textures: %u resident, %llu bytes", textures.textures, (unsigned long long)textures.resident_bytes );
+      ImGui::Text( "Textures: %u uploads, %u evictions", textures.uploads, textures.evictions );
+
+      const ure::ResourcesFetcher::stats_t  fetcher = ure::ResourcesFetcher::get_instance()->get_stats();
+      ImGui::Text( "Connections: %u new, %u reused", fetcher.new_connections, fetcher.reused_connections );
+      ImGui::Text( "HTTP cache: %u hits, %u revalidated", fetcher.cache_hits, fetcher.cache_revalidations );
+
+      if ( m_loader != nullptr )
+      {
+        const ure::TextureLoader::stats_t loader = m_loader->get_stats();
+        ImGui::Text( "Loader: %u waiting, %u failed", loader.waiting, loader.failed );
+        ImGui::Text( "Loader fetch : %u queued, %llu us max", loader.fetch.depth , (unsigned long long)loader.fetch.max_us  );
+        ImGui::Text( "Loader decode: %u queued, %llu us max", loader.decode.depth, (unsigned long long)loader.decode.max_us );
+        ImGui::Text( "Loader upload: %u queued, %llu us max", loader.upload.depth, (unsigned long long)loader.upload.max_us );
+      }
+
+      const ure::ResourcesCollector::stats_t collector = m_rc->get_stats();
+      ImGui::Text( "Resources: %u, %llu bytes, %u evicted", collector.resources, (unsigned long long)collector.usage, collector.evictions );
+
+      if ( m_map != nullptr )
+      {
+        const ure::widgets::TileMapLayer::stats_t map = m_map->get_stats();
+        ImGui::Text( "Map zoom %.2f: %u visible, %u fallback", m_map->get_zoom(), map.visible, map.fallback );
+        ImGui::Text( "Map cache: %u tiles, %u evicted", map.cached, map.evicted );
+        m_map->reset_stats();
+      }
+      ImGui::End();
+
+      m_window->get_state_cache()->reset_stats();
+      ure::VertexSlab::get_instance()->reset_stats();
+      ure::TransformSystem::get_instance()->reset_stats();
+      ure::TextureResidency::get_instance()->reset_stats();
+    }
 #endif
 
     ///////////////
@@ -267,6 +398,25 @@ protected:
     //std::cout << "fps: " << (double(1000) / m_sw.peek()) << std::endl;
     m_sw.reset();
 
+    update_websocket();
+  }
+
+  /**
+   * Frames can be skipped when nothing changed and no texture is loading.
+   * ImGui needs a frame for each event, so it is never idle.
+   */
+  virtual ure::bool_t is_idle() const noexcept(true) override
+  {
+#if defined(_IMGUI_ENABLED)
+    return false;
+#else
+    return ( m_view_port->needs_render() == false ) && ( ( m_loader == nullptr ) || m_loader->is_idle() ) &&
+           ( ( m_map == nullptr ) || ( m_map->is_retry_due() == false ) );
+#endif
+  }
+
+  void update_websocket()
+  {
 #ifdef _USE_WEBSOCKETS
     static bool _ws_init = false;
     static bool _ws_sent = false;
@@ -313,6 +463,12 @@ protected:
   {
     switch (key)
     {
+      case ure::key_t::KEY_SPACE:
+      {
+        // Layer rotation keeps rendering at full rate, stop it to see idle frames skipped.
+        m_spin = !m_spin;
+      }; break;
+
       case ure::key_t::KEY_C:
       {
         //glm::mat4 view_matrix = glm::mat4(1);
@@ -330,6 +486,12 @@ protected:
     
   }
 
+  virtual ure::void_t  on_refresh( [[maybe_unused]] ure::Window* window ) noexcept(true) override
+  {
+    // Window content was damaged by the system.
+    m_view_port->invalidate();
+  }
+
 /* ure::ResourcesFetcherEvents implementation */
 protected:  
   virtual ure::void_t on_download_succeeded(
@@ -341,11 +503,8 @@ protected:
                                              [[maybe_unused]] ure::uint_t length
                                            ) noexcept(true) override
   {
-    ure::Image image;
-    if ( image.create( ure::Image::loader_t::eStb, data, length ) )
-    {
-      std::cout << "Well done " << name << std::endl;
-    }
+    // Decoding will be completed in background, image will be available in on_run()
+    ure::ImageDecoder::get_instance()->decode( ure::Image::loader_t::eStb, std::string(name), data, length );
 
   }
 
@@ -373,6 +532,9 @@ protected:
   { std::cout << __FUNCTION__ << ":" << __LINE__ << std::endl; return true; }
 
 private:
+  /* Websockets are serviced by Application::run() between calls to on_run(), so idle waits must be bounded */
+  static constexpr double     k_idle_timeout = 0.5;
+
   using resources_collector_t = std::unique_ptr<ure::ResourcesCollector>;
 #ifdef _USE_WEBSOCKETS
   using websocket_t_ptr       = std::unique_ptr<ure::WebSocket>;
@@ -384,6 +546,11 @@ private:
   ure::Size                   m_fb_size;
 
   resources_collector_t       m_rc;                   /* resource collector */
+  std::unique_ptr<ure::TextureLoader>  m_loader;      /* remote textures     */
+  ure::TextureLoader::handle_t         m_tile;
+  std::shared_ptr<ure::widgets::TileMapLayer>  m_map;  /* slippy map          */
+  ure::node_handle_t                   m_layer1 = ure::k_invalid_handle;
+  bool                                 m_spin   = true;
 
   std::unique_ptr<ure::Window>      m_window;
   std::unique_ptr<ure::ViewPort>    m_view_port;
@@ -397,9 +564,6 @@ private:
 };
 
 
-#define OSM_ENDPOINT_SD "https://%s.tile.openstreetmap.org/%s/%s/%s.png"
-#define OSM_ENDPOINT "https://tile.openstreetmap.org/%s/%s/%s.png"
-
 int main(int argc, char** argv)
 {
   OglGui _oglgui(argc, argv);
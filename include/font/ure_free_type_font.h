@@ -26,6 +26,10 @@
 
 #include "ure_common_defs.h"
 #include "ure_font.h"
+#include "ure_glyph_atlas.h"
+
+#include <map>
+#include <memory>
 
 /**
  *  Forward declaration will avoid FT includes.
@@ -65,10 +69,17 @@ public:
   /***/
   virtual void_t            set_margins( sizei_t  left, sizei_t  top, sizei_t  right, sizei_t  bottom ) noexcept override;
   /**
+   * Glyphs are rasterized only the first time they are used with current size,
+   * then they are taken from the glyph atlas for the size.
+   * 
    * @param sText   widechar text used to generate GLText instance.
    * @param frColor foreground  color.
    */
   virtual Text*             get_text( const std::wstring& sText, const glm::vec4& frColor ) override;
+  /**
+   * Glyph atlases created for each size.
+   */
+  virtual std::size_t       get_memory_usage() const noexcept(true) override;
  
 protected:
   /***/
@@ -76,9 +87,24 @@ protected:
   { return m_face; }
   
 private:
-  FT_Face  m_face;
-  Size     m_size;
-  sizei_t  m_left, m_top, m_right, m_bottom;
+  /**
+   * Return atlas for current size, creating it if needed.
+   */
+  GlyphAtlas*               get_atlas() noexcept;
+  /**
+   * Return glyph for \param code from \param atlas, rasterizing it if needed.
+   */
+  const GlyphAtlas::glyph_t* get_glyph( GlyphAtlas& atlas, uint32_t code ) noexcept;
+  /***/
+  int_t                     get_kerning( GlyphAtlas& atlas, uint_t left, uint_t right ) noexcept;
+
+private:
+  using atlas_map_t = std::map<uint64_t, std::unique_ptr<GlyphAtlas>>;
+
+  FT_Face      m_face;
+  Size         m_size;
+  sizei_t      m_left, m_top, m_right, m_bottom;
+  atlas_map_t  m_mapAtlas;
 
   friend class FreeTypeFontLoader; // Required for the private constructor.
 };
@@ -2,11 +2,17 @@
 #ifndef IMAGES_UTILS_H
 #define IMAGES_UTILS_H
 
+/**
+ * All loaders return pixels with 8 bits for each channel, with the same channels
+ * count of the source image when supported (1 gray, 2 gray and alpha, 3 RGB, 4 RGBA),
+ * that will be stored in \param channels.
+ */
+
 #ifdef _USE_STB
 extern "C"
 {
-uint8_t* stb_load            ( const char* filename, unsigned int* size, int* width, int* height );
-uint8_t* stb_load_from_memory( const uint8_t* mem  , unsigned int* size, int* width, int* height );
+uint8_t* stb_load            ( const char* filename, unsigned int* size, int* width, int* height, int* channels );
+uint8_t* stb_load_from_memory( const uint8_t* mem  , unsigned int* size, int* width, int* height, int* channels );
 }
 #endif
 
@@ -17,13 +23,13 @@ extern "C"
  * Used to load an image using freeimage library.
  * returned buffer must be released with free() function.
  */
-uint8_t* fi_load( const char* filename, unsigned int* size, int* width, int* height );
+uint8_t* fi_load( const char* filename, unsigned int* size, int* width, int* height, int* channels );
 }
 #endif 
 
 #ifdef _USE_AVCPP
 bool     av_init();
-uint8_t* av_load( const char* filename, unsigned int* size, int* width, int* height );
+uint8_t* av_load( const char* filename, unsigned int* size, int* width, int* height, int* channels );
 bool     av_final();
 #endif 
 
@@ -31,7 +37,7 @@ bool     av_final();
 extern "C"
 {
 bool     il_init();
-uint8_t* il_load( const char* filename, unsigned int* size, int* width, int* height );
+uint8_t* il_load( const char* filename, unsigned int* size, int* width, int* height, int* channels );
 bool     il_final();
 }
 #endif 
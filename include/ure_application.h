@@ -86,6 +86,29 @@ public:
   void_t                    poll_events() noexcept(true);
   /***/
   void_t                    wait_events() noexcept(true);
+  /**
+   * Block until an event is received or \param timeout seconds are elapsed,
+   * used in place of poll_events() when there is nothing to render.
+   */
+  void_t                    wait_events( double_t timeout ) noexcept(true);
+  /**
+   * Wake up wait_events() from any thread, e.g. when background work completes.
+   */
+  void_t                    post_empty_event() noexcept(true);
+  /**
+   * Same as post_empty_event() but safe to call from worker threads while the application
+   * is initialized or finalized, wake ups are dropped once finalization has started.
+   */
+  static void_t             wake_up() noexcept(true);
+  /**
+   * Maximum time in seconds run() waits for events when ApplicationEvents::is_idle(),
+   * so that timed work such as retries is not delayed for longer.
+   */
+  constexpr void_t          set_idle_timeout( double_t timeout ) noexcept(true)
+  { m_idle_timeout = timeout; }
+  /***/
+  constexpr double_t        get_idle_timeout() const noexcept(true)
+  { return m_idle_timeout; }
   /***/ 
   std::string               get_version() const noexcept(true);
   
@@ -122,6 +145,7 @@ private:
   core::unique_ptr<ApplicationEvents>  m_events;
   mutable Monitor::monitor_map_t       m_mapMonitors;  
   bool_t                               m_exit;
+  double_t                             m_idle_timeout;
 };
 
 }
@@ -44,6 +44,12 @@ public:
   virtual void_t on_finalized() noexcept(true) = 0;
   /***/
   virtual void_t on_run() noexcept(true) = 0;
+  /**
+   * Checked by Application::run() after each on_run(), return true when there is nothing
+   * to render so that the loop blocks in wait_events() instead of spinning.
+   */
+  virtual bool_t is_idle() const noexcept(true)
+  { return false; }
   /***/
   virtual void_t on_initialize_error(/* @todo */) noexcept(true) = 0;
   /***/
@@ -0,0 +1,82 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_BOUNDS_H
+#define URE_BOUNDS_H
+
+#include "ure_common_defs.h"
+
+#include "glm/glm.hpp"
+
+namespace ure {
+
+/**
+ * Axis aligned bounding box in object coordinates.
+ */
+struct aabb_t {
+  glm::vec3   min;
+  glm::vec3   max;
+};
+
+/**
+ * Per frame culling counters.
+ */
+struct cull_stats_t {
+  uint32_t    visible;            /* drawn                        */
+  uint32_t    culled;             /* rejected before any GL work  */
+};
+
+/**
+ * Test \param box against clip volume after transformation with \param mvp.
+ * Box is rejected only when all its corners are outside the same clip plane, 
+ * that is when GL would clip all of its primitives, so the test is conservative.
+ * @return true if \param box is entirely outside the view frustum.
+ */
+inline bool_t is_outside_frustum( const glm::mat4& mvp, const aabb_t& box ) noexcept(true)
+{
+  uint32_t _outside = 0x3F;
+
+  for ( uint32_t i = 0; ( i < 8 ) && ( _outside != 0 ); ++i )
+  {
+    const glm::vec4 corner = mvp * glm::vec4( ( i & 1 )?box.max.x:box.min.x, 
+                                              ( i & 2 )?box.max.y:box.min.y, 
+                                              ( i & 4 )?box.max.z:box.min.z, 
+                                              1.0f );
+    uint32_t _planes = 0;
+
+    if ( corner.x < -corner.w ) _planes |= 0x01;
+    if ( corner.x >  corner.w ) _planes |= 0x02;
+    if ( corner.y < -corner.w ) _planes |= 0x04;
+    if ( corner.y >  corner.w ) _planes |= 0x08;
+    if ( corner.z < -corner.w ) _planes |= 0x10;
+    if ( corner.z >  corner.w ) _planes |= 0x20;
+
+    _outside &= _planes;
+  }
+
+  return ( _outside != 0 );
+}
+
+}
+
+#endif // URE_BOUNDS_H
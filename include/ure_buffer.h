@@ -25,6 +25,8 @@
 #define URE_BUFFER_H
 
 #include "ure_common_defs.h"
+#include <cstdlib>
+#include <cstring>
 #include <type_traits>
 
 namespace ure {
@@ -50,9 +52,42 @@ public:
     }
   }
 
+  /***/
+  buffer_t( const buffer_t& ) = delete;
+  /***/
+  buffer_t& operator=( const buffer_t& ) = delete;
+
+  /**
+   * Memory is moved from \param rhs, that is left empty.
+   */
+  constexpr buffer_t( buffer_t&& rhs ) noexcept
+    : m_length(rhs.m_length), m_data(rhs.m_data)
+  {
+    rhs.m_data   = nullptr;
+    rhs.m_length = 0;
+  }
+  /***/
+  constexpr buffer_t& operator=( buffer_t&& rhs ) noexcept
+  {
+    if ( this != &rhs )
+    {
+      if (m_data!=nullptr)
+        free(m_data);
+
+      m_data       = rhs.m_data;
+      m_length     = rhs.m_length;
+      rhs.m_data   = nullptr;
+      rhs.m_length = 0;
+    }
+    return *this;
+  }
+
   /***/
   constexpr data_size_t length() const noexcept
   { return m_length; }
+  /***/
+  constexpr const data_t* data() const noexcept
+  { return m_data; }
   /**
    * @brief 
    * 
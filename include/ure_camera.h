@@ -53,13 +53,32 @@ public:
    */
   constexpr bool_t                is_active() const noexcept(true)
   { return m_active; }
-  /***/
-  constexpr bool_t                set_active( bool_t active ) noexcept(true)
+  /**
+   * Scene graphs caching their active camera are invalidated by any change.
+   */
+  inline bool_t                   set_active( bool_t active ) noexcept(true)
   {
     bool_t    _old_value = m_active;
     m_active = active;
+    if ( _old_value != active )
+    {
+      s_activations++;
+      s_changes++;
+    }
     return  _old_value;
   }
+  /**
+   * Counter incremented each time a camera changes its active state.
+   */
+  static inline uint32_t          get_activations() noexcept(true)
+  { return s_activations; }
+  /**
+   * Counter incremented each time any camera changes its active state or view matrix
+   * through setters. Changes made on the reference returned by get_view_matrix() are
+   * not counted, so they require an explicit ViewPort::invalidate().
+   */
+  static inline uint32_t          get_changes() noexcept(true)
+  { return s_changes; }
 
   /**
    * glm::vec3 cameraPosition = glm::vec3(4,3,3); // Camera is at (4,3,3), in World Space
@@ -77,8 +96,8 @@ public:
 
   template<typename data_t>
     requires std::same_as<data_t,xform_matrix_t> || std::same_as<data_t,glm::mat4>
-  constexpr void_t                set_view_matrix( const data_t& tmat ) noexcept(true)
-  { m_view_matrix = tmat; }
+  inline void_t                   set_view_matrix( const data_t& tmat ) noexcept(true)
+  { m_view_matrix = tmat; s_changes++; }
   
   /***/  
   constexpr const Position3D&     get_position() const noexcept(true)
@@ -113,8 +132,12 @@ public:
 private:
   /***/
   inline void_t lookAt() noexcept(true)
-  { m_view_matrix = glm::lookAt( m_camera_position, m_camera_center, m_camera_top ); }
+  { m_view_matrix = glm::lookAt( m_camera_position, m_camera_center, m_camera_top ); s_changes++; }
   
+private:
+  static inline uint32_t s_activations = 0;
+  static inline uint32_t s_changes     = 0;
+
 protected:
   bool_t          m_active;
   xform_matrix_t  m_view_matrix;
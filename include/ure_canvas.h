@@ -26,16 +26,34 @@
 
 #include "ure_object.h"
 #include "ure_text.h"
+#include "ure_vertex_slab.h"
+#include "ure_rect.h"
 
+#include <array>
 #include <vector>
 
 namespace ure {
 
 class Program;
+class DrawList;
+struct program_ref_t;
 
 class Canvas : public Object
 {
 public:
+  /**
+   * Entry in the clip stack, see push_clip().
+   */
+  struct clip_t {
+    bool_t                  scissor;      /* scissor test enabled at this level        */
+    std::array<int_t, 4>    box;          /* scissor box in window coordinates         */
+    uint32_t                stencil;      /* stencil reference, number of stencil clips */
+    bool_t                  own_stencil;  /* stencil incremented by this entry         */
+    glm::mat4               mvp;          /* used to remove own stencil area           */
+    std::vector<glm::vec2>  vertices;
+  };
+  using clips_t = std::vector<clip_t>;
+
   /***/
   Canvas() noexcept;
   /***/
@@ -48,6 +66,43 @@ public:
   constexpr const glm::mat4& get_mvp() const noexcept
   { return m_mvp; }
   
+  /**
+   * Set the draw list that will collect all following draw_*() calls, from
+   * any Canvas, in place of issuing them immediately; nullptr restores the
+   * immediate mode.
+   * @return previous draw list, so that callers can restore it once done.
+   */
+  static DrawList*           set_draw_list( DrawList* pDrawList ) noexcept;
+  /***/
+  static DrawList*           get_draw_list() noexcept
+  { return s_pDrawList; }
+
+  /**
+   * Limit following draws, from any Canvas, to \param rect, that has the same layout of
+   * Widget::get_client_area(), transformed by current mvp and intersected with current
+   * clip area. Scissor test is used when the rect stays axis aligned on screen, otherwise 
+   * the rect is written in the stencil buffer, that should be cleared at frame start.
+   * Commands collected by the active draw list are flushed at each change.
+   * @return false when the clipped area is empty, pop_clip() must not be called then.
+   */
+  bool_t                     push_clip( const Recti& rect ) noexcept;
+  /**
+   * Same as above with a box in window coordinates, only scissor test is used.
+   */
+  static bool_t              push_scissor( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept;
+  /**
+   * Restore clip area active before last push_clip() or push_scissor().
+   */
+  void_t                     pop_clip() noexcept;
+  /**
+   * Disable clipping and return the clip stack, used before drawing on a different target.
+   */
+  static clips_t             suspend_clips() noexcept;
+  /**
+   * Restore a clip stack returned by suspend_clips().
+   */
+  static void_t              resume_clips( clips_t&& clips ) noexcept;
+  
   /***/
   void_t  draw_points( const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness = 1.0f ) noexcept;
   /***/
@@ -59,14 +114,42 @@ public:
   /***/
   void_t  draw_text  ( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept;
   
+  /**
+   * Same as above but vertices, texture coordinates and color are taken from 
+   * a quad in the VertexSlab, so nothing is uploaded if the quad did not change.
+   * Solid quads use the quad color.
+   */
+  void_t  draw_rect  ( VertexSlab::quad_t quad ) noexcept;
+  /**
+   * Texture will be modulated with quad color.
+   */
+  void_t  draw_rect  ( VertexSlab::quad_t quad, Texture& texture, int_t tws, int_t twt ) noexcept;
+  /**
+   * One quad for each glyph in \param text. Text alpha will be applied to quad color, 
+   * so quad color should be the text color.
+   */
+  void_t  draw_text  ( const std::vector<VertexSlab::quad_t>& quads, const Text& text, int_t tws, int_t twt ) noexcept;
+  
 private:
   /***/
   void_t  draw( enum_t mode, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept;
   /***/
   void_t  draw( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept;
+  /***/
+  void_t  draw( const VertexSlab::quad_t* pQuads, std::size_t count, program_ref_t& program, Texture* pTexture, int_t tws, int_t twt ) noexcept;
  
+private:
+  /***/
+  static void_t              flush_draw_list() noexcept;
+  /**
+   * Apply scissor and stencil state for \param pClip, nullptr to disable clipping.
+   */
+  static void_t              apply_clip( const clip_t* pClip ) noexcept;
+
 private:  
-  glm::mat4     m_mvp;
+  static DrawList*  s_pDrawList;
+  static clips_t    s_vClips;
+  glm::mat4         m_mvp;
   
 };
 
@@ -207,10 +207,19 @@
 #define URE_VERTEX_SHADER     GL_VERTEX_SHADER
 #define URE_FRAGMENT_SHADER   GL_FRAGMENT_SHADER
 
+#define URE_ALPHA             GL_ALPHA
+#define URE_LUMINANCE         GL_LUMINANCE
+#define URE_LUMINANCE_ALPHA   GL_LUMINANCE_ALPHA
+#define URE_RED               GL_RED
+#define URE_RG                GL_RG
 #define URE_RGB               GL_RGB
 #define URE_RGBA              GL_RGBA
+#define URE_RGB565            GL_RGB565
+#define URE_RGBA4             GL_RGBA4
 
-#define URE_UNSIGNED_BYTE     GL_UNSIGNED_BYTE
+#define URE_UNSIGNED_BYTE           GL_UNSIGNED_BYTE
+#define URE_UNSIGNED_SHORT_5_6_5    GL_UNSIGNED_SHORT_5_6_5
+#define URE_UNSIGNED_SHORT_4_4_4_4  GL_UNSIGNED_SHORT_4_4_4_4
 #define URE_INVALID_HANDLE    GL_INVALID_VALUE
 
 namespace ure {
@@ -0,0 +1,13 @@
+#ifndef URE_CONFIG_H
+#define URE_CONFIG_H
+
+#define LIB_VERSION_MAJOR           0
+#define LIB_VERSION_MINOR           1
+#define LIB_VERSION_PATCH           0
+
+#define LIB_VERSION   v0_1_0
+
+#define URE_CONTEXT_VERSION_MAJOR   3
+#define URE_CONTEXT_VERSION_MINOR   2
+
+#endif //URE_CONFIG_H
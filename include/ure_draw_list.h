@@ -0,0 +1,200 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_DRAW_LIST_H
+#define URE_DRAW_LIST_H
+
+#include "ure_object.h"
+#include "ure_vertex_slab.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ure {
+
+class Texture;
+class Text;
+
+/**
+ * Deferred 2D renderer used by Canvas.
+ * While a DrawList is active all Canvas::draw_*() calls are appended to a per-frame
+ * vertex stream instead of being sent to the driver; on flush() the commands are sorted
+ * by program, texture and blend state and submitted with the fewest possible draws.
+ * Commands that overlap keep their submission order, so layering is preserved.
+ * Quads stored in the VertexSlab are referenced in place, so only their indices 
+ * are streamed.
+ */
+class DrawList final : public Object
+{
+public:
+  struct stats_t {
+    uint32_t   commands;        /* Canvas calls recorded in the list                   */
+    uint32_t   draws;           /* draw calls issued to the driver                     */
+    uint32_t   merged;          /* commands merged into an already issued draw call    */
+    uint32_t   vertices;        /* vertices uploaded, quads from VertexSlab excluded   */
+    uint32_t   indices;         /* indices uploaded                                    */
+  };
+
+  /***/
+  DrawList() noexcept(true);
+  /***/
+  virtual ~DrawList() noexcept(true);
+
+  /**
+   * @return FALSE if \param points can't be addressed with 16 bits indices, in that case 
+   *         nothing is recorded and the caller is expected to draw them in immediate mode.
+   */
+  bool_t  add_points( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept(true);
+  /**
+   * @return FALSE on too many points, same as add_points().
+   */
+  bool_t  add_lines ( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept(true);
+  /***/
+  void_t  add_rect  ( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color ) noexcept(true);
+  /**
+   * @return FALSE on too many vertices, same as add_points().
+   */
+  bool_t  add_rect  ( const glm::mat4& mvp, const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, Texture& texture, int_t tws, int_t twt ) noexcept(true);
+  /***/
+  void_t  add_text  ( const glm::mat4& mvp, const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept(true);
+  /***/
+  void_t  add_rect  ( const glm::mat4& mvp, VertexSlab::quad_t quad ) noexcept(true);
+  /***/
+  void_t  add_rect  ( const glm::mat4& mvp, VertexSlab::quad_t quad, Texture& texture, int_t tws, int_t twt ) noexcept(true);
+  /***/
+  void_t  add_text  ( const glm::mat4& mvp, VertexSlab::quad_t quad, const Text& text, int_t tws, int_t twt ) noexcept(true);
+
+  /**
+   * @return TRUE if there are no pending commands.
+   */
+  inline bool_t                 empty() const noexcept(true)
+  { return m_vCommands.empty(); }
+
+  /**
+   * Sort pending commands, merge them and send them to the driver.
+   * The list will be empty once the call returns.
+   */
+  bool_t                        flush() noexcept(true);
+
+  /**
+   * Counters accumulated by flush() since last call to reset_stats().
+   */
+  constexpr const stats_t&      get_stats() const noexcept(true)
+  { return m_stats; }
+  /***/
+  constexpr void_t              reset_stats() noexcept(true)
+  { m_stats = {}; }
+
+private:
+  enum class program_t : uint8_t {
+    eSolid,
+    eTexture,
+    eText
+  };
+
+  struct state_t {
+    enum_t      mode;           /* GL_TRIANGLES, GL_LINES or GL_POINTS */
+    program_t   program;
+    Texture*    texture;
+    bool_t      blend;
+    float_t     thickness;
+    uint32_t    mvp;            /* index in m_vMVP */
+    int_t       tws;
+    int_t       twt;
+    uint32_t    source;         /* 0 for vertex stream, VertexSlab page + 1 otherwise */
+
+    bool operator==( const state_t& ) const = default;
+  };
+
+  /***/
+  struct state_hash_t {
+    std::size_t operator()( const state_t& state ) const noexcept(true);
+  };
+
+  using vertex_t = VertexSlab::vertex_t;
+
+  struct command_t {
+    uint32_t    state;          /* index in m_vStates */
+    uint32_t    depth;          /* commands at lower depth are never covered by commands at higher depth */
+    enum_t      primitive;      /* GL_TRIANGLE_STRIP, GL_LINE_STRIP or GL_POINTS */
+    uint32_t    first;          /* first vertex in m_vVertices or in VertexSlab page */
+    uint32_t    count;          /* number of vertices */
+    glm::vec2   min;            /* bounding box used to detect overlapping commands */
+    glm::vec2   max;
+  };
+
+  /* Union of commands at the same depth, used to compute depth of next commands */
+  struct level_t {
+    glm::vec2   min;
+    glm::vec2   max;
+    uint32_t    state;          /* state shared by all commands, when not mixed */
+    uint32_t    mvp;            /* matrix shared by all commands, when not mixed */
+    bool_t      mixed_state;
+    bool_t      mixed_mvp;
+  };
+
+  struct run_t {
+    uint32_t    state;
+    uint32_t    first;          /* first index in m_vIndices */
+    uint32_t    count;
+  };
+
+  /**
+   * @return FALSE, without recording anything, if \param points exceed the 16 bits index range.
+   */
+  bool_t    add( enum_t primitive, state_t& state, const glm::mat4& mvp,
+                 const std::vector<glm::vec2>& points, const std::vector<glm::vec2>* texCoord,
+                 const glm::vec4& color ) noexcept(true);
+  /***/
+  void_t    add( state_t& state, const glm::mat4& mvp, VertexSlab::quad_t quad ) noexcept(true);
+  /**
+   * Intern matrix and state then append \param cmd computing its depth.
+   */
+  void_t    push( state_t& state, const glm::mat4& mvp, command_t& cmd ) noexcept(true);
+  /**
+   * Bind vertex stream or VertexSlab page for state.source.
+   */
+  void_t    bind_source( uint32_t source, uint32_t previous ) noexcept(true);
+  /***/
+  void_t    apply( const state_t& state ) noexcept(true);
+  /***/
+  void_t    clear() noexcept(true);
+
+private:
+  std::vector<glm::mat4>    m_vMVP;
+  std::vector<state_t>      m_vStates;
+  std::unordered_map<state_t, uint32_t, state_hash_t>  m_mapStates;   /* index in m_vStates */
+  std::vector<command_t>    m_vCommands;
+  std::vector<level_t>      m_vLevels;
+  std::vector<vertex_t>     m_vVertices;
+  std::vector<word_t>       m_vIndices;
+  std::vector<uint32_t>     m_vOrder;
+  std::vector<run_t>        m_vRuns;
+  uint_t                    m_vbo;
+  uint_t                    m_ibo;
+  stats_t                   m_stats;
+};
+
+}
+
+#endif // URE_DRAW_LIST_H
@@ -0,0 +1,123 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_GLYPH_ATLAS_H
+#define URE_GLYPH_ATLAS_H
+
+#include "ure_object.h"
+#include "ure_texture.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ure {
+
+/**
+ * Single channel texture caching rasterized glyphs for a font at a given size.
+ * Glyphs are packed on shelves, each one as tall as the first glyph that opened
+ * it, so glyphs with similar heights share the same shelf. When there is no more
+ * room the texture height is doubled, previous texture is left untouched since 
+ * existing Text instances still reference it.
+ * Metrics and kerning are cached too, so font rasterization happens only once
+ * for each glyph.
+ */
+class GlyphAtlas final : public Object
+{
+public:
+  /**
+   * Glyph metrics in pixels, y axis pointing down.
+   */
+  struct glyph_t {
+    uint_t      index;              /* glyph index in the font              */
+    int_t       x;                  /* position in the atlas                */
+    int_t       y;
+    sizei_t     width;              /* bitmap size, zero for blank glyphs   */
+    sizei_t     height;
+    int_t       left;               /* bearing from pen position            */
+    int_t       top;                /* bearing from baseline                */
+    int_t       advance;            /* horizontal advance                   */
+  };
+
+  /***/
+  GlyphAtlas( sizei_t width, sizei_t height, sizei_t max_height ) noexcept(true);
+  /***/
+  virtual ~GlyphAtlas() noexcept(true);
+
+  /**
+   * @return cached glyph for \param code or nullptr if not in the atlas.
+   */
+  const glyph_t*   find( uint32_t code ) const noexcept(true);
+  /**
+   * Pack \param pBitmap, one byte per pixel, in the atlas and cache metrics.
+   * @param glyph    metrics, x and y will be updated with the position in the atlas.
+   * @param pitch    bytes between rows in \param pBitmap.
+   * @return cached glyph or nullptr if there is no room also after growing.
+   */
+  const glyph_t*   insert( uint32_t code, const glyph_t& glyph, const uint8_t* pBitmap, int_t pitch ) noexcept(true);
+
+  /**
+   * @return true and kerning in \param value if already cached for the pair.
+   */
+  bool_t           find_kerning( uint_t left, uint_t right, int_t& value ) const noexcept(true);
+  /***/
+  void_t           set_kerning( uint_t left, uint_t right, int_t value ) noexcept(true);
+
+  /**
+   * Current atlas texture, it changes only when the atlas grows.
+   */
+  inline const std::shared_ptr<Texture>& get_texture() const noexcept(true)
+  { return m_texture; }
+
+  /**
+   * Current texture only, textures left by previous growths are owned by Text instances.
+   */
+  virtual std::size_t  get_memory_usage() const noexcept(true) override;
+
+private:
+  /***/
+  struct shelf_t {
+    int_t       y;
+    sizei_t     height;
+    int_t       x;                  /* first free column */
+  };
+
+  /***/
+  bool_t     allocate( sizei_t width, sizei_t height, int_t& x, int_t& y ) noexcept(true);
+  /***/
+  bool_t     grow() noexcept(true);
+
+private:
+  static constexpr sizei_t  k_padding = 1;
+
+  std::shared_ptr<Texture>                  m_texture;
+  sizei_t                                   m_max_height;
+  std::vector<shelf_t>                      m_vShelves;
+  int_t                                     m_next_y;
+  std::unordered_map<uint32_t, glyph_t>     m_mapGlyphs;
+  std::unordered_map<uint64_t, int_t>       m_mapKerning;
+};
+
+}
+
+#endif // URE_GLYPH_ATLAS_H
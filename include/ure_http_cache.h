@@ -0,0 +1,198 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_HTTP_CACHE_H
+#define URE_HTTP_CACHE_H
+
+#include "ure_common_defs.h"
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ure {
+
+/**
+ * On-disk cache for HTTP responses.
+ * Bodies are stored as content addressed blobs, so identical responses for 
+ * different urls share the same file, while a compact index keeps for each url
+ * the blob, validators and expiration time. Blobs are shared only when size and
+ * content match, a hash collision just gives the new body another blob.
+ * Entries are keyed by url and by the credentials sent with the request, while
+ * headers listed in the Vary response header must match the ones stored.
+ * Least recently used entries are evicted when blobs exceed the size budget.
+ * Instances are not thread safe, they are meant to be used by a single I/O thread.
+ */
+class HttpCache
+{
+public:
+  /**
+   * Request headers as name, value pairs.
+   */
+  using headers_t = std::vector<const char*>;
+
+  /**
+   * Response information required to reuse or revalidate a cached body.
+   */
+  struct entry_t {
+    uint64_t      hash;               /* blob identifier, hash of the body       */
+    std::string   vary;               /* digests of request headers in Vary      */
+    uint64_t      size;               /* body size in bytes                      */
+    std::time_t   expires;            /* fresh until this time, 0 to revalidate  */
+    std::time_t   last_access;        /* used for LRU eviction                   */
+    std::string   etag;               /* ETag header, empty if not provided      */
+    std::string   last_modified;      /* Last-Modified header as received        */
+  };
+
+  /**
+   * Read only view of a cached body, file is mapped in memory so the body
+   * can be delivered without any copy.
+   */
+  class mapped_t
+  {
+  public:
+    /***/
+    mapped_t() noexcept(true)
+      : m_data( nullptr ), m_size( 0 )
+    {}
+    /***/
+    mapped_t( const mapped_t& ) = delete;
+    /***/
+    mapped_t& operator=( const mapped_t& ) = delete;
+    /***/
+    ~mapped_t() noexcept(true)
+    { close(); }
+
+    /***/
+    bool_t              open( const std::string& filename ) noexcept(true);
+    /***/
+    void_t              close() noexcept(true);
+
+    /***/
+    constexpr const byte_t* data() const noexcept(true)
+    { return m_data; }
+    /***/
+    constexpr uint64_t  size() const noexcept(true)
+    { return m_size; }
+
+  private:
+    byte_t*     m_data;
+    uint64_t    m_size;
+  };
+
+  static constexpr uint64_t k_default_budget = 256 * 1024 * 1024;
+
+  /**
+   * Load index stored in \param path, directory will be created if missing.
+   */
+  HttpCache( const std::string& path, uint64_t budget = k_default_budget ) noexcept(true);
+  /**
+   * Index is saved before releasing the instance.
+   */
+  ~HttpCache() noexcept(true);
+
+  /**
+   * @return true if cache directory is available.
+   */
+  constexpr bool_t    is_valid() const noexcept(true)
+  { return m_valid; }
+
+  /**
+   * @return entry for \param url requested with \param headers or nullptr if not cached.
+   */
+  const entry_t*      find( const std::string& url, const headers_t& headers ) const noexcept(true);
+  /**
+   * Map body cached for \param url into \param mapped and mark it as used.
+   */
+  bool_t              open( const std::string& url, const headers_t& headers, mapped_t& mapped ) noexcept(true);
+
+  /**
+   * Store \param size bytes from \param data as response for \param url,
+   * validators and expiration are taken from \param entry, while \param vary
+   * is the Vary response header.
+   * @return false if response cannot be stored, as with "Vary: *".
+   */
+  bool_t              store( const std::string& url, const headers_t& headers, const std::string& vary, 
+                             const entry_t& entry, const byte_t* data, uint64_t size ) noexcept(true);
+  /**
+   * Update validators and expiration for \param url after a successful revalidation.
+   */
+  void_t              refresh( const std::string& url, const headers_t& headers, const entry_t& entry ) noexcept(true);
+  /***/
+  void_t              remove( const std::string& url, const headers_t& headers ) noexcept(true);
+
+  /**
+   * Save index if modified.
+   */
+  void_t              flush() noexcept(true);
+
+  /**
+   * @return bytes currently used by blobs.
+   */
+  constexpr uint64_t  get_size() const noexcept(true)
+  { return m_size; }
+
+private:
+  /**
+   * @return index key for \param url, credentials in \param headers are
+   *         added as digests so that they are never written to disk.
+   */
+  static std::string  make_key( const std::string& url, const headers_t& headers ) noexcept(true);
+  /**
+   * @return digests of \param headers listed in \param names, a comma separated
+   *         list in the same format used by Vary or by entry_t::vary.
+   */
+  static std::string  select( const std::string& names, const headers_t& headers ) noexcept(true);
+  /***/
+  void_t              remove_key( const std::string& key ) noexcept(true);
+  /***/
+  std::string         blob_path( uint64_t hash ) const noexcept(true);
+  /***/
+  bool_t              is_blob_equal( uint64_t hash, const byte_t* data, uint64_t size ) const noexcept(true);
+  /***/
+  void_t              load() noexcept(true);
+  /***/
+  void_t              release_blob( uint64_t hash ) noexcept(true);
+  /***/
+  void_t              evict() noexcept(true);
+
+private:
+  /***/
+  struct blob_t {
+    uint64_t    size;
+    uint32_t    refs;
+  };
+
+  std::string                                 m_path;
+  uint64_t                                    m_budget;
+  uint64_t                                    m_size;
+  bool_t                                      m_valid;
+  bool_t                                      m_dirty;
+  std::unordered_map<std::string, entry_t>    m_entries;
+  std::unordered_map<uint64_t, blob_t>        m_blobs;
+};
+
+}
+
+#endif // URE_HTTP_CACHE_H
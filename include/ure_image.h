@@ -51,10 +51,20 @@ public:
     eDevIL
   };
 
+  /**
+   * Loaders keep the channels of the source image, so gray images are loaded 
+   * as eLuminance or eLuminanceAlpha. Packed formats use 16 bits for each pixel
+   * and are available only through convert().
+   */
   enum class format_t : int32_t {
     eUndefined,
-    eRGB  = URE_RGB,
-    eRGBA = URE_RGBA
+    eAlpha          = URE_ALPHA,
+    eLuminance      = URE_LUMINANCE,
+    eLuminanceAlpha = URE_LUMINANCE_ALPHA,
+    eRGB            = URE_RGB,
+    eRGBA           = URE_RGBA,
+    eRGB565         = URE_RGB565,
+    eRGBA4444       = URE_RGBA4
   };
   
   /***/
@@ -71,13 +81,41 @@ public:
   /***/
   bool                     create( loader_t il, const byte_t* data, uint32_t datasize ) noexcept; 
   
+  /**
+   * Convert pixels to \param format, supported conversions are:
+   * eRGB or eRGBA to eRGB565, eRGBA to eRGBA4444, eLuminance or eRGBA to eAlpha.
+   * @return false if conversion is not supported, current data are not modified.
+   */
+  bool                     convert( format_t format ) noexcept;
+  
   /***/
   constexpr format_t       get_format() const noexcept
   { return m_format; }
+  /**
+   * @return bytes for each pixel in \param format.
+   */
+  static constexpr uint32_t get_bytes_per_pixel( format_t format ) noexcept
+  {
+    switch ( format )
+    {
+      case format_t::eAlpha         : 
+      case format_t::eLuminance     : return 1;
+      case format_t::eLuminanceAlpha:
+      case format_t::eRGB565        :
+      case format_t::eRGBA4444      : return 2;
+      case format_t::eRGB           : return 3;
+      case format_t::eRGBA          : return 4;
+      default: break;
+    }
+    return 0;
+  }
   /***/
   constexpr const Size&    get_size() const noexcept
   { return m_size; }
   /***/
+  virtual std::size_t      get_memory_usage() const noexcept(true) override
+  { return m_uiDataSize; }
+  /***/
   constexpr const byte_t*  get_data( uint32_t* datasize ) const noexcept
   { 
     if ( datasize != nullptr )
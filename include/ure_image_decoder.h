@@ -0,0 +1,178 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_IMAGE_DECODER_H
+#define URE_IMAGE_DECODER_H
+
+#include "ure_common_defs.h"
+#include "ure_buffer.h"
+#include "ure_image.h"
+
+#include <core/singleton.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ure {
+
+class ImageDecoderEvents;
+
+/**
+ * Singleton decoding images on a fixed pool of worker threads.
+ * Requests are taken from file paths or from memory buffers, then decoded images
+ * are queued and handed back to the caller through pop(), that is meant to be 
+ * called from the main loop, so that textures can be created on the thread 
+ * owning the context.
+ * When no worker is available, as with emscripten without pthreads, images are 
+ * decoded on the calling thread but still delivered through pop().
+ */
+class ImageDecoder final : public core::singleton_t<ImageDecoder>
+{
+  friend class singleton_t<ImageDecoder>;
+public:
+  using request_id_t = uint64_t;
+  using data_t       = buffer_t<byte_t, uint_t>;
+
+  static constexpr request_id_t k_invalid_request = 0;
+
+  /***/
+  struct decoded_t {
+    request_id_t            id;
+    std::string             name;         /* name provided with the request        */
+    std::unique_ptr<Image>  image;        /* nullptr if decoding failed            */
+  };
+
+  /**
+   * Decode \param filename with loader \param il.
+   * @return request identifier or k_invalid_request in case of failure.
+   */
+  request_id_t      decode( Image::loader_t il, const std::string& name, const std::string& filename ) noexcept(true);
+  /**
+   * Decode \param data, that will be moved into the request.
+   */
+  request_id_t      decode( Image::loader_t il, const std::string& name, std::vector<byte_t>&& data ) noexcept(true);
+  /**
+   * Decode a copy of \param length bytes from \param data, so the buffer can be 
+   * released as soon as the call returns.
+   */
+  request_id_t      decode( Image::loader_t il, const std::string& name, const byte_t* data, uint32_t length ) noexcept(true);
+  /**
+   * Decode \param data, then hand the result to \param events from the worker thread 
+   * instead of queuing it for pop(). Events are kept alive until the request is completed.
+   */
+  request_id_t      decode( Image::loader_t il, const std::string& name, std::vector<byte_t>&& data, 
+                            std::shared_ptr<ImageDecoderEvents> events ) noexcept(true);
+  /**
+   * Same as above with memory allocated by malloc(), as bodies moved by ResourcesFetcher,
+   * so that a download can be decoded without any copy.
+   */
+  request_id_t      decode( Image::loader_t il, const std::string& name, data_t&& data, 
+                            std::shared_ptr<ImageDecoderEvents> events ) noexcept(true);
+
+  /**
+   * Take the oldest decoded image, if any.
+   * @return false if completion queue is empty.
+   */
+  bool_t            pop( decoded_t& decoded ) noexcept(true);
+
+  /**
+   * @return number of requests waiting for a worker or being decoded.
+   */
+  std::size_t       get_pending() const noexcept(true);
+  /***/
+  inline std::size_t get_workers() const noexcept(true)
+  { return m_vWorkers.size(); }
+
+protected:
+  /**
+   * \param workers number of threads, 0 to use one thread for each available core
+   *        but the one used by the main loop.
+   */
+  ImageDecoder( uint32_t workers = 0 ) noexcept(true);
+
+  /***/
+  void_t on_initialize() noexcept(true);
+  /**
+   * Stop all workers. Requests not yet decoded are notified as failed, with a null image, 
+   * to their ImageDecoderEvents; the others, as well as images not taken with pop(), are dropped.
+   */
+  void_t on_finalize() noexcept(true);
+
+private:
+  /***/
+  struct request_t {
+    request_id_t            id;
+    Image::loader_t         loader;
+    std::string             name;
+    std::string             filename;     /* empty when decoding from memory */
+    std::vector<byte_t>     data;
+    std::shared_ptr<ImageDecoderEvents> events; /* nullptr to queue result for pop() */
+    data_t                  memory;       /* used in place of data when not empty */
+  };
+
+  /***/
+  request_id_t      push( request_t&& request ) noexcept(true);
+  /***/
+  void_t            run( request_t& request ) noexcept(true);
+  /***/
+  void_t            worker() noexcept(true);
+
+private:
+  uint32_t                        m_workers;
+  std::vector<std::thread>        m_vWorkers;
+
+  mutable std::mutex              m_mtxRequests;
+  std::condition_variable         m_cvRequests;
+  std::deque<request_t>           m_requests;
+  std::size_t                     m_running;
+  bool_t                          m_exit;
+  request_id_t                    m_next_id;
+
+  std::mutex                      m_mtxDecoded;
+  std::deque<decoded_t>           m_decoded;
+};
+
+/**
+ * Receiver for images decoded on behalf of a specific consumer.
+ */
+class ImageDecoderEvents
+{
+public:
+  /***/
+  virtual ~ImageDecoderEvents() noexcept(true)
+  {}
+
+  /**
+   * Called from a worker thread, or from the caller of decode() when there are no workers.
+   */
+  virtual void_t    on_image_decoded( ImageDecoder::decoded_t&& decoded ) noexcept(true) = 0;
+};
+
+}
+
+#endif // URE_IMAGE_DECODER_H
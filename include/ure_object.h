@@ -38,6 +38,13 @@ public:
   /***/
   constexpr virtual ~Object() noexcept(true)
   {}
+
+  /**
+   * @return bytes held by the object, both in RAM and video memory. 
+   *         Used by ResourcesCollector to enforce its memory budget.
+   */
+  virtual std::size_t get_memory_usage() const noexcept(true)
+  { return 0; }
   
 };
 
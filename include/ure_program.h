@@ -29,6 +29,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <array>
 
 namespace ure {
 
@@ -38,15 +39,54 @@ class FragmentShader;
 class Program final : public HandledObject
 {
 public:
+  /**
+   * Tags for uniforms shared by built-in shaders; slots for those uniforms 
+   * are resolved once at link time so that the hot path is just an array index.
+   */
+  enum class uniform_t : uint8_t {
+    eMVP,                           /* u_m4MVP      */
+    eColor,                         /* u_v4Color    */
+    eThickness,                     /* u_fThickness */
+    eTexture,                       /* u_2dTexture  */
+    eCount
+  };
+
+  /**
+   * Active uniform as reflected after link().
+   */
+  struct uniform_info_t {
+    std::string   name;
+    int_t         location;
+    enum_t        type;
+    int_t         size;
+  };
+
+  /**
+   * Active attribute as reflected after link().
+   */
+  struct attribute_info_t {
+    std::string   name;
+    int_t         location;
+    enum_t        type;
+    int_t         size;
+  };
+
+  /* Returned when a uniform or attribute is not active in the program. */
+  static constexpr int_t  k_invalid_slot = -1;
+
   /***/
   Program() noexcept;
   /***/
   Program( const Program& program ) noexcept
-   : HandledObject(program)
+   : HandledObject(program),
+     m_vUniforms( program.m_vUniforms ), m_vCache( program.m_vCache ),
+     m_vAttributes( program.m_vAttributes ), m_aTags( program.m_aTags )
   {}
   /***/
   Program( Program&& program ) noexcept
-   : HandledObject( std::move(program) )
+   : HandledObject( std::move(program) ),
+     m_vUniforms( std::move(program.m_vUniforms) ), m_vCache( std::move(program.m_vCache) ),
+     m_vAttributes( std::move(program.m_vAttributes) ), m_aTags( program.m_aTags )
   {}
   /***/
   ~Program() noexcept;
@@ -93,6 +133,55 @@ public:
 
   int_t   getAttachedShaders() const noexcept;
   
+  /**
+   * Return slot for the active uniform with \param name or k_invalid_slot.
+   * Slots are stable until next link(), so they are meant to be resolved 
+   * once and then reused.
+   */
+  int_t   get_uniform_slot( const std::string& name ) const noexcept;
+  /***/
+  constexpr int_t  get_uniform_slot( uniform_t tag ) const noexcept
+  { return m_aTags[static_cast<std::size_t>(tag)]; }
+  /***/
+  inline int_t     get_uniform_location( int_t slot ) const noexcept
+  { return is_slot(slot)?m_vUniforms[slot].location:-1; }
+  /***/
+  inline int_t     get_uniform_location( uniform_t tag ) const noexcept
+  { return get_uniform_location( get_uniform_slot(tag) ); }
+  /***/
+  inline const std::vector<uniform_info_t>&   get_uniforms() const noexcept
+  { return m_vUniforms; }
+
+  /**
+   * Return slot for the active attribute with \param name or k_invalid_slot.
+   */
+  int_t   get_attribute_slot( const std::string& name ) const noexcept;
+  /***/
+  inline int_t     get_attribute_location( int_t slot ) const noexcept
+  { return ((slot >= 0) && (slot < (int_t)m_vAttributes.size()))?m_vAttributes[slot].location:-1; }
+  /***/
+  inline const std::vector<attribute_info_t>& get_attributes() const noexcept
+  { return m_vAttributes; }
+
+  /**
+   * Upload uniform value only if it differs from last value uploaded for
+   * the same slot, so the program must be in use as for glUniform*().
+   * Invalid slots are ignored.
+   * @return true if glUniform*() has been called, false if the value was 
+   *         already there or slot is invalid.
+   */
+  bool_t  set_uniform( int_t slot, int_t value ) noexcept;
+  /***/
+  bool_t  set_uniform( int_t slot, float_t value ) noexcept;
+  /***/
+  bool_t  set_uniform( int_t slot, const glm::vec4& value ) noexcept;
+  /***/
+  bool_t  set_uniform( int_t slot, const glm::mat4& value ) noexcept;
+  /***/
+  template<typename value_t>
+  inline bool_t  set_uniform( uniform_t tag, const value_t& value ) noexcept
+  { return set_uniform( get_uniform_slot(tag), value ); }
+  
   /**
    * Can be used to retrieve log informations generated at 
    * load time.
@@ -110,8 +199,33 @@ protected:
   uint_t 	query( enum_t e ) const noexcept;  
   
 private:
+  /**
+   * Collect active uniforms and attributes, called on each successful link().
+   */
+  void_t    reflect() noexcept;
+  /***/
+  constexpr bool_t is_slot( int_t slot ) const noexcept
+  { return ( (slot >= 0) && (slot < (int_t)m_vUniforms.size()) ); }
+  /**
+   * Compare \param pValue with cached value for \param slot and store it 
+   * if different.
+   * @return true if cached value has been updated.
+   */
+  bool_t    update_cache( int_t slot, const float_t* pValue, std::size_t count ) noexcept;
+
+private:
+  /* CPU copy of the last value uploaded, enough for a mat4. */
+  struct uniform_cache_t {
+    std::array<float_t,16>  value;
+    bool_t                  valid;
+  };
+
   std::vector<std::shared_ptr<VertexShader>>    m_vecVertex;
   std::vector<std::shared_ptr<FragmentShader>>  m_vecFragment;
+  std::vector<uniform_info_t>                   m_vUniforms;
+  std::vector<uniform_cache_t>                  m_vCache;
+  std::vector<attribute_info_t>                 m_vAttributes;
+  std::array<int_t,static_cast<std::size_t>(uniform_t::eCount)>  m_aTags;
 };
 
 }
@@ -36,6 +36,23 @@ namespace ure {
 
 #define DEFAULT_SHADER_PATH  "./shaders"
 
+/**
+ * Cached lookup for a program in the ProgramsCollector.
+ * Meant to be kept as static or member by callers on the render path, so that 
+ * the name is hashed again only after programs have been attached or detached.
+ */
+struct program_ref_t
+{
+  /***/
+  constexpr program_ref_t( const char* name ) noexcept
+    : name( name ), generation( 0 ), program( nullptr )
+  {}
+
+  const char*  name;
+  uint32_t     generation;
+  Program*     program;
+};
+
 /**
  * Singleton used in order to store shared programs.
  */
@@ -60,6 +77,11 @@ public:
    *                   does not exist. 
    */
   Program*        find( const std::string& name ) noexcept;
+  /**
+   * @brief Same as find() by name, but result is cached in \param ref and 
+   *        reused until the content of the collector change.
+   */
+  Program*        find( program_ref_t& ref ) noexcept;
   /**
    * @brief Check if specified program name is already present in the collector.
    * 
@@ -108,10 +130,14 @@ public:
 protected:
   /***/
   void_t on_initialize() noexcept
-  { m_sShadersPath = DEFAULT_SHADER_PATH; }
+  { 
+    m_sShadersPath = DEFAULT_SHADER_PATH; 
+    s_generation++;
+  }
   /***/
   void_t on_finalize() noexcept
   {
+    s_generation++;
     while ( m_mapPrograms.empty() == false )
     {
       m_mapPrograms.extract(m_mapPrograms.begin());
@@ -124,6 +150,9 @@ private:
 private:
   std::string      m_sShadersPath;
   map_programs_t   m_mapPrograms;
+  /* shared by every instance and never reset, so that a program_ref_t resolved before a
+     finalize() can not match again once the singleton has been initialized again */
+  inline static uint32_t s_generation = 0;
   
 };
 
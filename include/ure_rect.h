@@ -51,7 +51,7 @@ public:
 
   /***/
   constexpr rect_t& operator=(const rect_t& other)
-  { left = other.left; top = other.top; right = other.right; bottom = other.bottom; }
+  { left = other.left; top = other.top; right = other.right; bottom = other.bottom; return *this; }
   /***/
   constexpr bool operator==(const rect_t& other) const
   { return ((left  == other.left ) && (top    == other.top   ) &&
@@ -0,0 +1,140 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_RENDER_QUEUE_H
+#define URE_RENDER_QUEUE_H
+
+#include "ure_common_defs.h"
+#include "ure_camera.h"
+
+#include "glm/glm.hpp"
+#include <vector>
+
+namespace ure {
+
+class SceneNodeBase;
+
+/**
+ * Per frame list of scene nodes to be drawn, each one with a 64 bits sort key.
+ * Keys are built by make_key() so that a plain ascending sort gives, for each 
+ * render order, opaque items front to back grouped by program and texture and 
+ * then translucent items back to front.
+ * Items are sorted with a stable LSD radix sort, so items with the same key keep
+ * their submission order.
+ */
+class RenderQueue final
+{
+public:
+  /***/
+  struct item_t {
+    uint64_t          key;
+    SceneNodeBase*    node;
+    uint32_t          matrix;         /* index of model view projection matrix */
+  };
+
+  /***/
+  struct stats_t {
+    uint32_t    items;                /* items submitted by last frame      */
+    uint32_t    translucent;          /* translucent items in last frame    */
+    uint32_t    sort_us;              /* time spent by last sort()          */
+    uint32_t    max_sort_us;          /* highest sort() time since reset    */
+  };
+
+  static constexpr uint32_t k_program_bits = 10;
+  static constexpr uint32_t k_texture_bits = 16;
+  static constexpr uint32_t k_depth_bits   = 24;
+
+  /***/
+  RenderQueue() noexcept(true)
+    : m_stats{}
+  {}
+
+  /**
+   * @param order        render order, lower values are drawn first.
+   * @param translucent  true for items that require blending.
+   * @param program      program id, only low k_program_bits are used.
+   * @param texture      texture id, only low k_texture_bits are used.
+   * @param depth        normalized device depth in range [-1,1].
+   */
+  static constexpr uint64_t  make_key( uint8_t order, bool_t translucent, uint32_t program, uint32_t texture, float_t depth ) noexcept(true)
+  {
+    const uint64_t _max   = ( uint64_t(1) << k_depth_bits ) - 1;
+    const float_t  _depth = ( depth < -1.0f )? -1.0f : ( ( depth > 1.0f )? 1.0f : depth );
+    const uint64_t _d     = static_cast<uint64_t>( ( _depth + 1.0f ) * 0.5f * _max );
+    const uint64_t _p     = program & ( ( 1u << k_program_bits ) - 1 );
+    const uint64_t _t     = texture & ( ( 1u << k_texture_bits ) - 1 );
+
+    uint64_t _key = ( uint64_t(order) << 56 );
+
+    if ( translucent == false )
+      /* state first to minimize switches, then front to back */
+      _key |= ( _p << 45 ) | ( _t << 29 ) | ( _d << 5 );
+    else
+      /* back to front first, then state */
+      _key |= ( uint64_t(1) << 55 ) | ( ( _max - _d ) << 31 ) | ( _p << 21 ) | ( _t << 5 );
+
+    return _key;
+  }
+  /***/
+  static constexpr bool_t    is_translucent( uint64_t key ) noexcept(true)
+  { return ( key >> 55 ) & 1; }
+
+  /***/
+  void_t          clear() noexcept(true);
+  /**
+   * Append \param node to be drawn with \param mvp.
+   */
+  void_t          push( uint64_t key, SceneNodeBase* node, const glm::mat4& mvp ) noexcept(true);
+  /**
+   * Sort items by key, radix passes on bytes shared by all keys are skipped.
+   */
+  void_t          sort() noexcept(true);
+  /**
+   * Draw items in current order.
+   */
+  void_t          submit( const camera_ptr& camera ) noexcept(true);
+
+  /***/
+  inline const std::vector<item_t>&  get_items() const noexcept(true)
+  { return m_vItems; }
+  /***/
+  inline const glm::mat4&            get_matrix( const item_t& item ) const noexcept(true)
+  { return m_vMatrices[item.matrix]; }
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /***/
+  constexpr void_t         reset_stats() noexcept(true)
+  { m_stats.max_sort_us = 0; }
+
+private:
+  std::vector<item_t>     m_vItems;
+  std::vector<item_t>     m_vScratch;
+  std::vector<glm::mat4>  m_vMatrices;
+  stats_t                 m_stats;
+};
+
+}
+
+#endif // URE_RENDER_QUEUE_H
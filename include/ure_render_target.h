@@ -0,0 +1,88 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_RENDER_TARGET_H
+#define URE_RENDER_TARGET_H
+
+#include "ure_texture.h"
+#include "ure_rect.h"
+
+namespace ure {
+
+/**
+ * Framebuffer object with a color texture and a depth stencil buffer attached, 
+ * used to render once and then draw the result as a regular texture.
+ * Content is premultiplied by alpha, see StateCache::blend_alpha().
+ */
+class RenderTarget : public HandledObject
+{
+public:
+  /***/
+  RenderTarget( sizei_t width, sizei_t height ) noexcept(true);
+  /***/
+  ~RenderTarget() noexcept(true);
+
+  /***/
+  constexpr const Size& get_size() const noexcept(true)
+  { return m_texture.get_size(); }
+
+  /***/
+  constexpr Texture&    get_texture() noexcept(true)
+  { return m_texture; }
+
+  /**
+   * @return video memory used by the color attachment.
+   */
+  virtual std::size_t   get_memory_usage() const noexcept(true) override
+  { return m_texture.get_memory_usage(); }
+
+  /**
+   * Redirect following draws to the target, cleared to transparent black, with a
+   * viewport that covers the whole texture. Framebuffer, viewport and clear color 
+   * in use are taken from the StateCache in order to be restored by end().
+   * @param pArea  when not null, only this area, in texture pixels with the same
+   *               layout of Widget::get_client_area(), is cleared and drawn, while
+   *               the rest of the texture keeps previous content.
+   * @return false if the framebuffer is not complete, end() must not be called.
+   */
+  bool_t                begin( const Recti* pArea = nullptr ) noexcept(true);
+  /***/
+  void_t                end() noexcept(true);
+
+private:
+  /***/
+  bool_t                create() noexcept(true);
+
+private:
+  Texture     m_texture;
+  uint_t      m_depth_stencil;
+  bool_t      m_scissor;
+  bool_t      m_prev_premultiplied;
+  uint_t      m_prev_fbo;
+  int_t       m_prev_viewport[4];
+  float_t     m_prev_clear_color[4];
+};
+
+}
+
+#endif // URE_RENDER_TARGET_H
@@ -26,8 +26,11 @@
 
 #include "ure_object.h"
 #include "ure_common_defs.h"
+#include "ure_slot_map.h"
 
 #include <core/singleton.h>
+#include <algorithm>
+#include <list>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -38,8 +41,13 @@ namespace ure {
 
 #define DEFAULT_RESOURCES_PATH  "./media"
 
+class ResourcesCollectorEvents;
+
 /**
- * 
+ * Resources are kept by name and released with the collector.
+ * When a memory budget is set, least recently used EXPENDABLE resources that are 
+ * not referenced outside the collector are released until usage is within the 
+ * budget, connected listeners are notified so that owners can reload them on demand.
  */
 class ResourcesCollector final 
 {
@@ -49,8 +57,17 @@ public:
     PRESERVE   = 0x0001,         /* Resource will not be removed if not explicity requested.            */
   };
 
+  /***/
+  struct stats_t {
+    uint32_t    resources;          /* resources in the collector              */
+    std::size_t usage;              /* bytes held by resources in the collector */
+    std::size_t peak;               /* highest usage since reset               */
+    uint32_t    evictions;          /* resources released since reset          */
+    std::size_t evicted_bytes;      /* bytes released since reset              */
+  };
+
   ResourcesCollector( const std::string_view& path = DEFAULT_RESOURCES_PATH ) noexcept(true)
-    : m_resources_path(path)
+    : m_resources_path(path), m_budget(0), m_stats{}
   {}
 
   ~ResourcesCollector() noexcept(true)
@@ -80,8 +97,28 @@ public:
     if ( iter == m_mapResources.end() )
       return std::nullopt;
 
+    m_lstLRU.splice( m_lstLRU.begin(), m_lstLRU, iter->second->_lru );
+
     return std::static_pointer_cast<derived_t>( iter->second->_obj );
   }
+  /**
+   * @brief Find resource with \param handle returned by attach(), an index plus a 
+   *        generation check, to be preferred on hot paths.
+   * 
+   * @return std::nullopt if the resource has been detached or released.
+   */
+  template<class derived_t>
+    requires std::is_nothrow_convertible_v<derived_t*,Object*>
+  std::optional<std::shared_ptr<derived_t>>   find( const node_handle_t& handle ) const noexcept(true)
+  {
+    item_t* const* ppItem = m_slots.get( handle );
+    if ( ppItem == nullptr )
+      return std::nullopt;
+
+    m_lstLRU.splice( m_lstLRU.begin(), m_lstLRU, (*ppItem)->_lru );
+
+    return std::static_pointer_cast<derived_t>( (*ppItem)->_obj );
+  }
 
   /**
    * @brief Check if specified resource name is already present in the collector.
@@ -92,31 +129,88 @@ public:
    */
   inline bool_t  contains( const std::string& name ) const noexcept(true)
   { return m_mapResources.contains(name); }
+
+  /**
+   * @brief Set memory budget in bytes, 0 means no limit. Usage is trimmed immediately.
+   */
+  void_t          set_budget( std::size_t bytes ) noexcept(true);
+  /***/
+  constexpr std::size_t  get_budget() const noexcept(true)
+  { return m_budget; }
+  /**
+   * @brief Release least recently used EXPENDABLE resources not referenced elsewhere 
+   *        until usage is within the budget, nothing is done while usage is within it.
+   *        Called on attach(), it should also be called periodically, e.g. once per frame,
+   *        since resources become releasable when other owners drop them.
+   * 
+   * @return number of released resources.
+   */
+  uint32_t        trim() noexcept(true);
+  /**
+   * @brief Account a new cost for a resource whose memory usage changed after attach(),
+   *        e.g. a font whose glyph atlas has grown.
+   * 
+   * @param size   cost in bytes, 0 to take it from Object::get_memory_usage().
+   * @return false if \param handle does not refer to a resource of the collector.
+   */
+  bool_t          update_cost( const node_handle_t& handle, std::size_t size = 0 ) noexcept(true);
+  /***/
+  bool_t          update_cost( const std::string& name, std::size_t size = 0 ) noexcept(true);
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /***/
+  constexpr void_t  reset_stats() noexcept(true)
+  { m_stats.peak = m_stats.usage; m_stats.evictions = 0; m_stats.evicted_bytes = 0; }
+
+  /**
+   * @brief Listeners notified when resources are released by trim().
+   */
+  bool_t          connect( ResourcesCollectorEvents* pEvents ) noexcept(true);
+  /***/
+  bool_t          disconnect( ResourcesCollectorEvents* pEvents ) noexcept(true);
   
   /**
    * @brief Store specified resource inside the collector, but only if does not exist already a 
    *        resource with the same name.
    * 
    * @param name             unique identifier for the resource 
-   * @param resource         pointer to a Resource(Object). If the method return true ownership of 
-   *                         this pointer will be taken from the collector.
-   * @return true,nullptr    in case a resource with \param name is not already stored in the collector.
-   * @return false,resource  in case the collector already contains a resource with \param name.
+   * @param resource         pointer to a Resource(Object). If the method return a valid handle 
+   *                         ownership of this pointer will be taken from the collector.
+   * @param flags            resource_flag_t values.
+   * @param size             cost in bytes, 0 to take it from Object::get_memory_usage().
+   * @return handle,nullptr  in case a resource with \param name is not already stored in the collector.
+   * @return k_invalid_handle,resource  
+   *                         in case the collector already contains a resource with \param name.
    */
   template<class derived_t, typename pointer_t = std::shared_ptr<derived_t> >
     requires std::is_nothrow_convertible_v<derived_t*,Object*> && 
              ( std::same_as<pointer_t,std::shared_ptr<derived_t>> || std::same_as<pointer_t,std::unique_ptr<derived_t>> )
-  constexpr std::pair<bool,pointer_t>   attach(  const std::string& name, 
-                                                 pointer_t resource, 
-                                                 word_t flags = ure::word_t(ure::ResourcesCollector::resource_flag_t::EXPENDABLE) 
-                                              ) noexcept(true)
+  constexpr std::pair<node_handle_t,pointer_t>   attach(  const std::string& name, 
+                                                          pointer_t resource, 
+                                                          word_t flags = ure::word_t(ure::ResourcesCollector::resource_flag_t::EXPENDABLE),
+                                                          std::size_t size = 0
+                                                       ) noexcept(true)
   {
     if ( m_mapResources.contains( name ) == true )
-      return std::make_pair(false, std::move(resource));
-  
-    m_mapResources[name] = std::make_unique<item_t>( flags, std::move(resource) ); 
+      return std::make_pair(k_invalid_handle, std::move(resource));
   
-    return std::make_pair(true, nullptr);
+    m_lstLRU.push_front( name );
+
+    std::unique_ptr<item_t>& item = m_mapResources[name];
+    item          = std::make_unique<item_t>( flags, std::move(resource), size, m_lstLRU.begin() ); 
+    item->_handle = m_slots.insert( item.get() );
+    item->_cost   = item->get_cost();
+    m_stats.resources++;
+    m_stats.usage += item->_cost;
+    m_stats.peak   = std::max( m_stats.peak, m_stats.usage );
+
+    const node_handle_t handle = item->_handle;
+
+    trim();
+
+    return std::make_pair(handle, nullptr);
   }
 
   /**
@@ -135,26 +229,79 @@ public:
     if ( iter == m_mapResources.end() )
       return nullptr;
     
-    return std::static_pointer_cast<derived_t>( m_mapResources.extract(iter).mapped()->_obj );
+    std::unique_ptr<item_t> item = std::move( m_mapResources.extract(iter).mapped() );
+
+    m_slots.erase( item->_handle );
+    m_lstLRU.erase( item->_lru );
+    m_stats.resources--;
+    m_stats.usage -= item->_cost;
+
+    return std::static_pointer_cast<derived_t>( item->_obj );
+  }
+  /**
+   * @brief Detach resource with \param handle returned by attach().
+   */
+  template<class derived_t>
+    requires std::is_nothrow_convertible_v<derived_t*,Object*>
+  std::shared_ptr<derived_t>      detach( const node_handle_t& handle ) noexcept(true)
+  {
+    item_t** ppItem = m_slots.get( handle );
+    if ( ppItem == nullptr )
+      return nullptr;
+
+    /* Name is kept by the LRU entry */
+    return detach<derived_t>( std::string( *(*ppItem)->_lru ) );
   }
  
 private:
+  using lru_t = std::list<std::string>;
+
   struct item_t {
-    item_t( word_t flags, std::shared_ptr<Object> obj )
-    : _flags(flags), _obj(std::move(obj))
+    item_t( word_t flags, std::shared_ptr<Object> obj, std::size_t size, lru_t::iterator lru )
+    : _flags(flags), _obj(std::move(obj)), _size(size), _cost(0), _lru(lru), _handle(k_invalid_handle)
     {}
+
+    /***/
+    std::size_t    get_cost() const noexcept(true)
+    { return ( _size != 0 )?_size:_obj->get_memory_usage(); }
     
     word_t                   _flags;
     std::shared_ptr<Object>  _obj;
+    std::size_t              _size;       /* explicit cost, 0 when taken from the object */
+    std::size_t              _cost;       /* cost accounted in usage                     */
+    lru_t::iterator          _lru;        /* entry in the LRU, it holds the resource name */
+    node_handle_t            _handle;
   };
 
   typedef std::unordered_map<std::string, std::unique_ptr<item_t>>  map_resources_t;
 private:
-  std::string      m_resources_path;
-  map_resources_t  m_mapResources;
+  std::string                              m_resources_path;
+  map_resources_t                          m_mapResources;
+  mutable lru_t                            m_lstLRU;          /* most recently used first */
+  slot_map<item_t*>                        m_slots;
+  std::size_t                              m_budget;
+  stats_t                                  m_stats;
+  std::vector<ResourcesCollectorEvents*>   m_vEvents;
   
 };
 
+/**
+ * Notifications from ResourcesCollector.
+ */
+class ResourcesCollectorEvents
+{
+public:
+  /***/
+  virtual ~ResourcesCollectorEvents() noexcept(true)
+  {}
+
+  /**
+   * Called by trim() after \param name has been released from the collector.
+   * @param size   bytes released.
+   */
+  virtual void_t    on_resource_evicted( const std::string& name, std::size_t size ) noexcept(true) = 0;
+};
+
 }
 
 #endif // URE_RESOURCES_COLLECTOR_H
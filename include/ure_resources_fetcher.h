@@ -30,9 +30,13 @@
 #include <core/utils.h>
 #include <core/singleton.h>
 #include <core/unique_ptr.h>
+#include <mailbox.h>
 
+#include <atomic>
+#include <mutex>
 #include <string>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ure {
 
@@ -42,13 +46,33 @@ namespace ure {
 class ResourcesFetcher final: public core::singleton_t<ResourcesFetcher>
 {
   friend class singleton_t<ResourcesFetcher>;
+  friend class resource_t;
 protected:
 
   /***/
   ResourcesFetcher() noexcept(true)
+    : m_last_request( k_invalid_request ),
+      m_max_transfers( k_default_max_transfers ), m_max_host_transfers( k_default_max_host_transfers ),
+      m_dispatch( false ), m_mbxCompletions( "Fetcher Completions" )
   {}
 
 public:
+  /***/
+  struct stats_t {
+    uint32_t    new_connections;      /* transfers that required a new connection    */
+    uint32_t    reused_connections;   /* transfers served by an existing connection  */
+    uint32_t    cache_hits;           /* requests served from disk without network   */
+    uint32_t    cache_revalidations;  /* requests served from disk after a 304       */
+  };
+
+  /* Handle returned by fetch(), never reused during application lifetime */
+  using request_t          = uint64_t;
+
+  static constexpr request_t k_invalid_request           = 0;
+  static constexpr uint32_t k_default_max_transfers      = 16;
+  static constexpr uint32_t k_default_max_host_transfers = 6;
+  static constexpr uint64_t k_default_cache_size         = 256 * 1024 * 1024;
+
   using http_headers_t     = std::vector<std::string>; 
   using http_body_t        = std::string; 
 
@@ -80,8 +104,16 @@ public:
             parameters such as name, url, headers and body can be used in a separate thread.
             
             Note: this call should be used, for example, with headers that do not change in time.
+            
+            \param delivery combination of delivery_flags_t used to notify data to \param events.
+            \param priority requests with higher priority are started first.
+            \param deadline milliseconds, from now, after which the request will be dropped and 
+                   notified as failed; 0 means no deadline.
+            
+            Return request handle or k_invalid_request on failure; if the same request is still
+            in progress its handle will be returned.
    */
-  bool_t            fetch ( ResourcesFetcherEvents&  events,
+  request_t         fetch ( ResourcesFetcherEvents&  events,
                             const std::string&       app_id,
                             const std::string&       name,  
                             const std::type_info&    type,
@@ -89,13 +121,16 @@ public:
                             customer_request_t       cr,
                             const http_headers_t&    headers,
                             const http_body_t&       body,
-                            bool                     verify_ssl = true
+                            bool                     verify_ssl = true,
+                            uint32_t                 delivery   = edfBorrow,
+                            int32_t                  priority   = 0,
+                            uint32_t                 deadline   = 0
                           ) noexcept(true);
 
   /* \brief fetch a resource from specified url.
             this call will MOVE all parameters such as name, url, headers and body
    */
-  bool_t            fetch ( ResourcesFetcherEvents&  events,
+  request_t         fetch ( ResourcesFetcherEvents&  events,
                             std::string&&            app_id,
                             std::string&&            name,  
                             const std::type_info&    type,
@@ -103,22 +138,96 @@ public:
                             customer_request_t       cr,
                             http_headers_t&&         headers,
                             http_body_t&&            body,
-                            bool                     verify_ssl = true
+                            bool                     verify_ssl = true,
+                            uint32_t                 delivery   = edfBorrow,
+                            int32_t                  priority   = 0,
+                            uint32_t                 deadline   = 0
                           ) noexcept(true);
 
+  /**
+   * Limit concurrent transfers, overall and for each host; exceeding requests
+   * will wait in queue until a transfer completes. 
+   * Limits are applied by generic implementation, also to connections opened by curl,
+   * browsers apply their own limits.
+   */
+  void_t            set_max_transfers( uint32_t max_transfers, uint32_t max_host_transfers ) noexcept(true);
   /***/
-  bool_t            cancel( const std::string_view app_id, const std::string_view name, customer_request_t cr ) noexcept(true)
+  inline uint32_t   get_max_transfers() const noexcept(true)
+  { return m_max_transfers; }
+  /***/
+  inline uint32_t   get_max_host_transfers() const noexcept(true)
+  { return m_max_host_transfers; }
+
+  /**
+   * Enable on-disk cache for GET requests in directory \param path, using at most 
+   * \param max_bytes for responses; an empty path disables the cache.
+   * Responses are delivered from disk while fresh according to Cache-Control and
+   * Expires headers, then revalidated using ETag and Last-Modified.
+   * Cache is available with generic implementation only, browsers use their own.
+   */
+  bool_t            set_cache( const std::string& path, uint64_t max_bytes = k_default_cache_size ) noexcept(true);
+
+  /**
+   * Connections are kept alive and shared between requests, DNS and TLS sessions
+   * are cached as well, so these counters show how many handshakes have been saved.
+   */
+  stats_t           get_stats() const noexcept(true);
+  /***/
+  void_t            reset_stats() noexcept(true);
+
+  /**
+   * When enabled, on_download_succeeded(), on_download_moved() and on_download_failed() are not 
+   * notified by the fetcher thread, but queued until dispatch() is called, typically from on_run(),
+   * so that consumers can access textures and resources without any lock.
+   * on_download_progress() and on_download_chunk() are always notified by the fetcher thread.
+   */
+  void_t            set_dispatch( bool_t enable ) noexcept(true)
+  { m_dispatch = enable; }
+  /***/
+  inline bool_t     get_dispatch() const noexcept(true)
+  { return m_dispatch; }
+
+  /**
+   * Notify queued completions in the calling thread, stopping after \param max_completions
+   * or when \param max_time_us microseconds have been spent; 0 means no limit.
+   * Return number of notified completions.
+   */
+  uint32_t          dispatch( uint32_t max_completions = 0, uint32_t max_time_us = 0 ) noexcept(true);
+
+  /**
+   * Return handle for request in progress or k_invalid_request.
+   */
+  request_t         find( const std::string_view app_id, const std::string_view name, customer_request_t cr ) noexcept(true)
   {
-    std::string     _name = core::utils::format( "%s:%s:%s", to_string_view(cr).data(), name.data(), app_id.data() );
     std::lock_guard _mtx(m_mtx_fetch);
 
-    if ( m_fetching.contains(_name.c_str()) == false )
-      return false;
-
-    m_fetching.erase(_name.c_str());
+    auto iter = m_fetching.find( get_key( app_id, name, cr ) );
+    if ( iter == m_fetching.end() )
+      return k_invalid_request;
 
-    return true;
+    return iter->second;
   }
+
+  /**
+   * Change priority of a request still waiting in queue; requests already in progress
+   * are not affected. Return false if \param request is not in progress.
+   */
+  bool_t            set_priority( request_t request, int32_t priority ) noexcept(true);
+
+  /**
+   * Drop \param request if queued or abort the transfer if in progress; a completion
+   * queued for dispatch() and not yet notified is dropped as well.
+   * No callback is notified for \param request after cancel() returns: a callback running
+   * in another thread at the time of the call is waited for, so cancel() must not be 
+   * called while holding a lock taken by the callbacks. It can be called from callbacks.
+   * Return false if \param request has already been completed.
+   */
+  bool_t            cancel( request_t request ) noexcept(true);
+
+  /***/
+  bool_t            cancel( const std::string_view app_id, const std::string_view name, customer_request_t cr ) noexcept(true)
+  { return cancel( find( app_id, name, cr ) ); }
+
 protected:
   /***/
   void_t  on_initialize() noexcept(true);
@@ -127,8 +236,120 @@ protected:
   void_t  on_finalize() noexcept(true);
   
 private:
-  std::mutex                                m_mtx_fetch;
-  std::set<std::string>                     m_fetching;
+  /**
+   * Completion queued when dispatch is enabled.
+   */
+  struct completion_t {
+    enum class kind_t : uint8_t { eSucceeded, eMoved, eFailed };
+
+    /***/
+    completion_t( ResourcesFetcherEvents& events, 
+                  request_t               request,
+                  const std::string_view  app_id, 
+                  const std::string_view  name, 
+                  customer_request_t      cr, 
+                  const std::type_info&   type, 
+                  kind_t                  kind ) noexcept(true)
+      : m_events( events ), m_request( request ), m_app_id( app_id ), m_name( name ), m_cr( cr ), m_type( type ), m_kind( kind )
+    {}
+
+    ResourcesFetcherEvents&         m_events;
+    const request_t                 m_request;
+    const std::string               m_app_id;
+    const std::string               m_name;
+    const customer_request_t        m_cr;
+    const std::type_info&           m_type;
+    const kind_t                    m_kind;
+    ResourcesFetcherEvents::body_t  m_body;
+  };
+
+  using completions_type = lock_free::mailbox<completion_t*, core::ds_impl_t::lockfree, 0, 
+                                              core::arena_allocator<core::node_t<completion_t*,false,true,false>, uint32_t, 1024, 1024, 0, 0, core::default_allocator<uint32_t>>
+                                             >;
+
+  /**
+   * Queue \param completion for dispatch(), ownership is taken on success only.
+   * Return false if completion cannot be queued, so that caller notifies it directly.
+   */
+  bool_t              post( completion_t* completion ) noexcept(true);
+
+  /**
+   * Release queued completions without notifying them.
+   */
+  void_t              clear_completions() noexcept(true);
+
+  /***/
+  static std::string  get_key( const std::string_view app_id, const std::string_view name, customer_request_t cr ) noexcept(true)
+  { return core::utils::format( "%s:%s:%s", to_string_view(cr).data(), std::string(name).c_str(), std::string(app_id).c_str() ); }
+
+  /**
+   * Register a new request with \param key, or return existing one in \param request.
+   * Must be called with m_mtx_fetch locked; return false if request was already in progress.
+   */
+  bool_t              add_request( std::string&& key, request_t& request ) noexcept(true)
+  {
+    auto iter = m_fetching.find( key );
+    if ( iter != m_fetching.end() )
+    {
+      request = iter->second;
+      return false;
+    }
+
+    request = ++m_last_request;
+    m_requests.emplace( request, key );
+    m_fetching.emplace( std::move(key), request );
+    return true;
+  }
+
+  /**
+   * Forget \param request, completed or cancelled; return false if already released.
+   * When \param posted is true the request is tracked until its completion is dispatched,
+   * so that cancel() can still drop it.
+   */
+  bool_t              release( request_t request, bool_t posted = false ) noexcept(true)
+  {
+    std::lock_guard _mtx(m_mtx_fetch);
+
+    auto iter = m_requests.find( request );
+    if ( iter == m_requests.end() )
+      return false;
+
+    m_fetching.erase( iter->second );
+    m_requests.erase( iter );
+
+    if ( posted )
+      m_posted.insert( request );
+    return true;
+  }
+
+  /**
+   * Stop tracking completion for \param request; return false if it has been dropped by cancel().
+   */
+  bool_t              unpost( request_t request ) noexcept(true)
+  {
+    std::lock_guard _mtx(m_mtx_fetch);
+    return ( m_posted.erase( request ) > 0 );
+  }
+
+  /**
+   * Return true if \param request is still in progress, so that its callbacks can be notified.
+   */
+  bool_t              is_active( request_t request ) noexcept(true)
+  {
+    std::lock_guard _mtx(m_mtx_fetch);
+    return m_requests.contains( request );
+  }
+
+  std::mutex                                      m_mtx_fetch;
+  std::unordered_map<std::string, request_t>      m_fetching;
+  std::unordered_map<request_t, std::string>      m_requests;
+  std::unordered_set<request_t>                   m_posted;        /* completions queued for dispatch() */
+  std::recursive_mutex                            m_mtx_notify;    /* held while notifying callbacks    */
+  request_t                                       m_last_request;
+  std::atomic<uint32_t>                           m_max_transfers;
+  std::atomic<uint32_t>                           m_max_host_transfers;
+  std::atomic<bool_t>                             m_dispatch;
+  completions_type                                m_mbxCompletions;
 };
 
 }
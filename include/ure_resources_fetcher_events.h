@@ -25,6 +25,7 @@
 #define URE_RESOURCES_FETCHER_EVENTS_H
 
 #include "ure_common_defs.h"
+#include "ure_buffer.h"
 
 namespace ure {
 
@@ -37,12 +38,26 @@ enum class customer_request_t : enum_t
   Delete
 };
 
+/**
+ * How downloaded data will be delivered to ResourcesFetcherEvents, flags can be combined.
+ */
+enum delivery_flags_t : uint32_t
+{
+  edfBorrow = 0x0000,   // Whole body is lent to on_download_succeeded() and released after the call.
+  edfStream = 0x0001,   // Progress and chunks are notified while downloading. Without edfMove
+                        // on_download_succeeded() will be called with no data at the end.
+  edfMove   = 0x0002    // Whole body is moved to on_download_moved() with a buffer_t, 
+                        // so that consumer can keep it without any copy.
+};
+
 /**
  * 
  */
 class ResourcesFetcherEvents 
 {
 public:
+  using body_t = buffer_t<byte_t, uint_t>;
+
   /***/
   ResourcesFetcherEvents() noexcept(true)
   {}
@@ -57,6 +72,41 @@ public:
                                            [[maybe_unused]] const byte_t* data,
                                            [[maybe_unused]] uint_t length
                                          ) noexcept(true) = 0;
+  /**
+   * Called with edfMove in place of on_download_succeeded(), detach() can be used on \param body 
+   * to take ownership of the memory, that must be released with free().
+   * Default implementation lends the body to on_download_succeeded().
+   */
+  virtual void_t    on_download_moved    ( const std::string_view app_id,
+                                           const std::string_view name,
+                                           customer_request_t cr,
+                                           const std::type_info& type,
+                                           body_t&& body
+                                         ) noexcept(true)
+  { on_download_succeeded( app_id, name, cr, type, body.data(), body.length() ); }
+  /**
+   * Called with edfStream while downloading, \param total is 0 when not known.
+   * @return false in order to abort the download.
+   */
+  virtual bool_t    on_download_progress ( [[maybe_unused]] const std::string_view app_id,
+                                           [[maybe_unused]] const std::string_view name,
+                                           [[maybe_unused]] customer_request_t cr,
+                                           [[maybe_unused]] uint64_t received,
+                                           [[maybe_unused]] uint64_t total
+                                         ) noexcept(true)
+  { return true; }
+  /**
+   * Called with edfStream for each block of data as soon as it is received, 
+   * \param data is valid only during the call.
+   * @return false in order to abort the download.
+   */
+  virtual bool_t    on_download_chunk    ( [[maybe_unused]] const std::string_view app_id,
+                                           [[maybe_unused]] const std::string_view name,
+                                           [[maybe_unused]] customer_request_t cr,
+                                           [[maybe_unused]] const byte_t* data,
+                                           [[maybe_unused]] uint_t length
+                                         ) noexcept(true)
+  { return true; }
   /***/
   virtual void_t    on_download_failed   ( [[maybe_unused]] const std::string_view app_id,
                                            [[maybe_unused]] const std::string_view name,
@@ -51,10 +51,16 @@ public:
   inline camera_ptr get_camera() noexcept(true)
   { return get_object<Camera>(); }
 
+  /**
+   * Cameras have nothing to draw.
+   */
+  virtual void_t enqueue( [[maybe_unused]] RenderQueue& queue, [[maybe_unused]] const glm::mat4& mViewProjection, [[maybe_unused]] const camera_ptr& camera ) noexcept(true) override
+  {}
+
 protected:
 
   /***/  
-  virtual bool render( [[__maybe_unused__]] const glm::mat4& mProjection, [[__maybe_unused__]] const camera_ptr& camera ) noexcept(true) override
+  virtual bool render( [[__maybe_unused__]] const glm::mat4& mViewProjection, [[__maybe_unused__]] const camera_ptr& camera ) noexcept(true) override
   { return true; };
   
 };
@@ -38,7 +38,9 @@ public:
   /***/
   SceneGraph()
     : SceneNode( "Root", nullptr ),
-      m_red(0.0f), m_green(0.0f), m_blue(0.0f), m_alpha(1.0f)
+      m_red(0.0f), m_green(0.0f), m_blue(0.0f), m_alpha(1.0f),
+      m_pActiveCamera( nullptr ), m_camera_activations( 0 ), m_camera_dirty( true ),
+      m_cull_stats{}
   {
   }
 
@@ -50,36 +52,72 @@ public:
    * Return current active camera that will be used during render operation.
    * If there is no camera, return value will be nullptr and identity matrix
    * will be used for render.
+   * Active camera is cached, camera nodes are scanned again only when a camera 
+   * node is added or a camera changes its active state.
    */
   const SceneCameraNode*  get_active_camera() const noexcept(true);
+  /**
+   * Camera of the active camera node, nullptr if there is no active camera.
+   */
+  const camera_ptr&       get_active_camera_ptr() const noexcept(true)
+  {
+    get_active_camera();
+    return m_active_camera;
+  }
     
   /***/
   void_t  set_background( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha ) noexcept(true);
   /***/
   void_t  get_background( GLclampf& red, GLclampf& green, GLclampf& blue, GLclampf& alpha ) noexcept(true);
   
-  /***/
+  /**
+   * Render using the active camera of the scene.
+   */
   bool_t  render( const glm::mat4& mProjection ) noexcept(true)
+  { return render_from( mProjection, get_active_camera_ptr() ); }
+  /**
+   * Render using \param camera, that can be owned by the view port in order to 
+   * show the same scene from different points of view. 
+   * View matrix is resolved here once for all the nodes.
+   */
+  bool_t  render_from( const glm::mat4& mProjection, const camera_ptr& camera ) noexcept(true)
   {
-    const SceneCameraNode* pActiveCamera = get_active_camera();
-    camera_ptr             camera        = (pActiveCamera!=nullptr)?pActiveCamera->get_camera():nullptr; 
+    // World matrices of nodes modified since last frame.
+    if ( TransformSystem::is_valid() )
+      TransformSystem::get_instance()->update();
+
+    m_cull_stats = {};
+    cull_stats_t* pPrevious = set_cull_counters( &m_cull_stats );
+
+    bool_t _retval = ( camera == nullptr )? render( mProjection, camera ) :
+                                            render( mProjection * camera->get_view_matrix().get(), camera );
+
+    set_cull_counters( pPrevious );
 
-    return render( mProjection, camera );
+    return _retval;
   }
+  /***/
+  inline const RenderQueue&     get_render_queue() const noexcept(true)
+  { return m_queue; }
+  /**
+   * Nodes drawn and culled by last render.
+   */
+  constexpr const cull_stats_t& get_cull_stats() const noexcept(true)
+  { return m_cull_stats; }
   
 protected:  
   /**
-   * Iterate on all childs in order to render them.
-   * 
-   * @todo implements rendering order
+   * Collect items from all nodes, then draw them ordered by their sort keys.
    */
-  virtual bool_t render( const glm::mat4& mProjection, const camera_ptr& camera ) noexcept(true)
+  virtual bool_t render( const glm::mat4& mViewProjection, const camera_ptr& camera ) noexcept(true)
   { 
-    for ( auto n : m_vRender )
-    {
-      n->render( mProjection, camera );
-    }
-    
+    m_queue.clear();
+
+    enqueue_children( m_queue, mViewProjection, camera );
+
+    m_queue.sort();
+    m_queue.submit( camera );
+
     return true; 
   }
 
@@ -88,8 +126,15 @@ protected:
   
 private:
   GLclampf   m_red, m_green, m_blue, m_alpha;  
-  
-  std::vector<SceneNodeBase*>    m_vRender;
+
+
+  mutable const SceneCameraNode* m_pActiveCamera;        /* cached active camera node           */
+  mutable camera_ptr             m_active_camera;        /* camera of m_pActiveCamera           */
+  mutable uint32_t               m_camera_activations;   /* Camera::get_activations() when cached */
+  mutable bool_t                 m_camera_dirty;         /* camera nodes changed since cached   */
+
+  cull_stats_t                   m_cull_stats;
+  RenderQueue                    m_queue;
 };
 
 }
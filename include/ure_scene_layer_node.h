@@ -43,10 +43,7 @@ public:
    */
   SceneLayerNode( const std::string& name, std::shared_ptr<widgets::Layer> layer ) noexcept(true)
    : SceneNode( name, layer )
-  {
-    // Init model matrix
-    m_matModel = glm::mat4( 1.0f );
-  }
+  {}
   /***/
   virtual ~SceneLayerNode() noexcept(true)
   {}  
@@ -59,23 +56,43 @@ public:
   { return get_object<widgets::Layer>(); }
 
   /***/  
-  virtual bool_t               render( const glm::mat4& mProjection, const camera_ptr& camera ) noexcept(true) override; 
-  
+  virtual bool_t               render( const glm::mat4& mViewProjection, const camera_ptr& camera ) noexcept(true) override; 
+  /**
+   * Layer is added to \param queue when visible, sorted by depth of its center, 
+   * then child nodes are added.
+   */
+  virtual void_t               enqueue( RenderQueue& queue, const glm::mat4& mViewProjection, const camera_ptr& camera ) noexcept(true) override;
   /***/
+  virtual bool_t               draw_item( const glm::mat4& mvp, const camera_ptr& camera ) noexcept(true) override;
+  /**
+   * Layer area, widgets are expected to be inside it.
+   */
+  virtual bool_t               get_bounds( aabb_t& box ) const noexcept(true) override;
+  
+  /**
+   * Model matrix is the local matrix of the node, relative to its parent.
+   */
   inline xform_matrix_t&       get_model_matrix() noexcept(true)
-  { return m_matModel; }
+  { return get_local_matrix(); }
   /***/
   inline const xform_matrix_t& get_model_matrix() const noexcept(true)
-  { return m_matModel; }
+  { return get_local_matrix(); }
   /***/
   inline void_t                set_model_matrix( const xform_matrix_t& tmat ) noexcept(true)
-  { m_matModel = tmat; }
+  { get_local_matrix() = tmat; }
   /***/
   inline void_t                set_model_matrix( const glm::mat4& mat ) noexcept(true)
-  { m_matModel = mat;  }  
+  { get_local_matrix() = mat;  }  
 
 private:
-  xform_matrix_t   m_matModel;
+  /**
+   * View projection multiplied by world and animation matrices.
+   */
+  glm::mat4                    get_mvp( const glm::mat4& mViewProjection ) noexcept(true);
+  /**
+   * Test layer bounds against view frustum, updating cull counters.
+   */
+  bool_t                       is_culled( const glm::mat4& mvp ) const noexcept(true);
 };
 
 }
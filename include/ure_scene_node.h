@@ -26,9 +26,11 @@
 
 #include "ure_common_defs.h"
 #include "ure_scene_node_base.h"
+#include "ure_slot_map.h"
 
 #include "glm/glm.hpp"
 #include <unordered_map>
+#include <vector>
 #include <type_traits>
 
 namespace ure {
@@ -45,14 +47,40 @@ public:
   {}
 
   /**
-   * @brief 
+   * @brief Register \param pSceneNode taking its ownership.
    * 
    * @param pSceneNode 
-   * @return true 
-   * @return false 
+   * @return handle to be used with get_scene_node() on hot paths, k_invalid_handle if
+   *         a node with the same type and name is already registered or if on_add_scene_node()
+   *         rejects it; in both cases ownership is not taken and \param pSceneNode must be
+   *         released by the caller.
    */
-  bool_t            add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true);
+  node_handle_t          add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true);
+
+  /**
+   * Set counters updated by nodes during render, same as Canvas::set_draw_list().
+   * @return previous counters.
+   */
+  static cull_stats_t*  set_cull_counters( cull_stats_t* pStats ) noexcept(true);
+  /***/
+  static cull_stats_t*  get_cull_counters() noexcept(true)
+  { return s_pCullStats; }
+  /**
+   * @brief Lookup by handle, an index plus a generation check.
+   * @return nullptr if \param handle does not refer to a node of this scene or the node is not a derived_t.
+   */
+  template<class derived_t>
+    requires std::is_nothrow_convertible_v<derived_t*,SceneNodeBase*>  
+  derived_t*        get_scene_node( const node_handle_t& handle ) noexcept(true)
+  {
+    SceneNodeBase** ppNode = m_nodes.get( handle );
+    if ( ppNode == nullptr )
+      return nullptr;
+
+    return dynamic_cast<derived_t*>(*ppNode);
+  }
   /** 
+   * @brief Lookup by name, slow path for nodes whose handle is not known.
    */
   template<class derived_t>
     requires std::is_nothrow_convertible_v<derived_t*,SceneNodeBase*>  
@@ -71,13 +99,35 @@ public:
     if ( _nodeIterator == rSceneNodeMap.end() )
       return nullptr;
     
-    return static_cast<derived_t*>(_nodeIterator->second.get());
+    return dynamic_cast<derived_t*>(_nodeIterator->second.get());
   }  
     
 protected:
   /***/
   virtual bool_t      on_add_scene_node( SceneNodeBase* ) noexcept(true)
   { return true; };
+  /**
+   * Add child nodes to \param queue.
+   */
+  void_t              enqueue_children( RenderQueue& queue, const glm::mat4& mViewProjection, const std::shared_ptr<Camera>& camera ) noexcept(true)
+  {
+    for ( SceneNodeBase* pNode : m_vChildren )
+    {
+      pNode->enqueue( queue, mViewProjection, camera );
+    }
+  }
+  /**
+   * Render child nodes in registration order.
+   */
+  bool_t              render_children( const glm::mat4& mViewProjection, const std::shared_ptr<Camera>& camera ) noexcept(true)
+  {
+    for ( SceneNodeBase* pNode : m_vChildren )
+    {
+      pNode->render( mViewProjection, camera );
+    }
+
+    return true;
+  }
     
 protected:
   using scene_node_map_t  = std::unordered_map<std::string, std::unique_ptr<SceneNodeBase>>;
@@ -87,7 +137,12 @@ protected:
   const scene_node_map_t*   get_scene_node_map( const std::string& sNodeType ) const noexcept(true);
     
 protected:
-  scene_node_maps_t   m_maps;
+  scene_node_maps_t             m_maps;
+  slot_map<SceneNodeBase*>      m_nodes;
+  std::vector<SceneNodeBase*>   m_vChildren;
+
+private:
+  static cull_stats_t*          s_pCullStats;
 };
 
 }
@@ -27,6 +27,9 @@
 #include "ure_common_defs.h"
 #include "ure_object.h"
 #include "ure_animation.h"
+#include "ure_transform_system.h"
+#include "ure_bounds.h"
+#include "ure_render_queue.h"
 
 namespace ure {
 
@@ -38,15 +41,23 @@ class SceneNodeBase : public Object
 {
 public:
   /**
+   * Nodes should be created after Application initialization, since their transform 
+   * is allocated in TransformSystem. Otherwise the node keeps its own local matrix,
+   * used as world matrix as well, and it can't take part in any hierarchy.
    * @param object     can be shared over different scene nodes.
   */
   SceneNodeBase( const std::string& node_type, const std::string& name, std::shared_ptr<Object> object ) noexcept(true)
-    : Object(), m_node_type(node_type), m_name( name ), m_object( object )
+    : Object(), m_node_type(node_type), m_name( name ), m_object( object ),
+      m_render_order( 0 ), m_opaque( false ),
+      m_transform( TransformSystem::is_valid()?TransformSystem::get_instance()->allocate():TransformSystem::k_invalid_transform )
   {}
 
   /***/
   virtual ~SceneNodeBase() noexcept(true)
-  {}
+  {
+    if ( ( m_transform != TransformSystem::k_invalid_transform ) && TransformSystem::is_valid() )
+      TransformSystem::get_instance()->release( m_transform );
+  }
 
   /***/
   inline constexpr const std::string& type() const noexcept(true)
@@ -74,6 +85,75 @@ public:
   inline std::shared_ptr<derived_t> get_object() noexcept(true)
   { return std::static_pointer_cast<derived_t>(m_object); }
 
+  /***/
+  constexpr TransformSystem::transform_t  get_transform() const noexcept(true)
+  { return m_transform; }
+  /**
+   * Local matrix, relative to the parent node. Non const access marks the node 
+   * dirty, world matrices are then updated once per frame by the scene graph.
+   * Reference stays valid for node lifetime, but changes must be made through a 
+   * new call to be tracked.
+   */
+  inline xform_matrix_t&        get_local_matrix() noexcept(true)
+  { 
+    if ( m_transform == TransformSystem::k_invalid_transform )
+      return m_detached;
+    return TransformSystem::get_instance()->edit_local( m_transform ); 
+  }
+  /***/
+  inline const xform_matrix_t&  get_local_matrix() const noexcept(true)
+  { 
+    if ( m_transform == TransformSystem::k_invalid_transform )
+      return m_detached;
+    return TransformSystem::get_instance()->get_local( m_transform ); 
+  }
+  /**
+   * Parent world matrix multiplied by local matrix, as computed by last update.
+   */
+  inline const glm::mat4&       get_world_matrix() const noexcept(true)
+  { 
+    if ( m_transform == TransformSystem::k_invalid_transform )
+      return m_detached.get();
+    return TransformSystem::get_instance()->get_world( m_transform ); 
+  }
+
+  /**
+   * Nodes with lower render order are drawn first, default is 0.
+   */
+  constexpr void_t              set_render_order( uint8_t order ) noexcept(true)
+  { m_render_order = order; }
+  /***/
+  constexpr uint8_t             get_render_order() const noexcept(true)
+  { return m_render_order; }
+  /**
+   * Opaque nodes are drawn front to back before translucent ones, that are drawn 
+   * back to front. Default is translucent, as expected by layers drawn with blending.
+   */
+  constexpr void_t              set_opaque( bool_t opaque ) noexcept(true)
+  { m_opaque = opaque; }
+  /***/
+  constexpr bool_t              is_opaque() const noexcept(true)
+  { return m_opaque; }
+
+  /**
+   * Add items to be drawn to \param queue. Default implementation adds the node 
+   * itself, drawn with render().
+   */
+  virtual void_t    enqueue( RenderQueue& queue, const glm::mat4& mViewProjection, [[maybe_unused]] const std::shared_ptr<Camera>& camera ) noexcept(true)
+  { queue.push( RenderQueue::make_key( m_render_order, !m_opaque, 0, 0, 0.0f ), this, mViewProjection ); }
+  /**
+   * Draw an item added by enqueue(), \param mvp is the matrix pushed with it.
+   */
+  virtual bool_t    draw_item( const glm::mat4& mvp, const std::shared_ptr<Camera>& camera ) noexcept(true)
+  { return render( mvp, camera ); }
+
+  /**
+   * Bounding box in local coordinates, used to skip nodes outside the view frustum.
+   * @return false if the node has no bounds, so it is never culled.
+   */
+  virtual bool_t                get_bounds( [[maybe_unused]] aabb_t& box ) const noexcept(true)
+  { return false; }
+
   inline bool_t has_animation() const noexcept(true)
   { return (bool)m_animation; }
   /***/
@@ -88,9 +168,11 @@ public:
   }
   
   /**
-   * @param camera     pointer to the active camera it will provide the view matrix.
+   * @param mViewProjection  projection matrix multiplied by the view matrix of \param camera,
+   *                         resolved once per frame by the scene graph.
+   * @param camera           pointer to the camera used for render, nullptr for an identity view.
    */
-  virtual bool_t    render( const glm::mat4& mProjection, const std::shared_ptr<Camera>& camera ) noexcept(true) = 0;
+  virtual bool_t    render( const glm::mat4& mViewProjection, const std::shared_ptr<Camera>& camera ) noexcept(true) = 0;
   
 protected:
   /***/
@@ -102,7 +184,11 @@ private:
   const std::string            m_name;         /* instance name */
   std::shared_ptr<Object>      m_object;
   std::unique_ptr<Animation>   m_animation;
-  
+  uint8_t                      m_render_order;
+  bool_t                       m_opaque;
+  const TransformSystem::transform_t  m_transform;
+  xform_matrix_t               m_detached;     /* local and world matrix when m_transform is not valid */
+
 };
 
 }
@@ -0,0 +1,144 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_SLOT_MAP_H
+#define URE_SLOT_MAP_H
+
+#include "ure_common_defs.h"
+
+#include <limits>
+#include <vector>
+
+namespace ure {
+
+/**
+ * Generational handle, index in a slot_map plus the generation of the slot when
+ * the value has been inserted. Zero initialized handles are not valid.
+ */
+struct node_handle_t {
+  uint32_t    index;
+  uint32_t    generation;
+
+  /***/
+  constexpr bool_t  is_valid() const noexcept(true)
+  { return ( generation != 0 ); }
+  /***/
+  constexpr explicit operator bool() const noexcept(true)
+  { return is_valid(); }
+  /***/
+  constexpr bool_t  operator==( const node_handle_t& rhs ) const noexcept(true) = default;
+};
+
+static constexpr node_handle_t k_invalid_handle = { std::numeric_limits<uint32_t>::max(), 0 };
+
+/**
+ * Dense array of slots addressed with generational handles, so that lookups are an
+ * index plus a generation check and handles to erased values are detected.
+ * Slots of erased values are reused, bumping their generation.
+ */
+template<typename value_t>
+class slot_map
+{
+public:
+  /***/
+  slot_map() noexcept(true)
+  {}
+
+  /**
+   * @return handle for \param value.
+   */
+  node_handle_t        insert( value_t value ) noexcept(true)
+  {
+    uint32_t _index;
+
+    if ( m_vFree.empty() == false )
+    {
+      _index = m_vFree.back();
+      m_vFree.pop_back();
+    }
+    else
+    {
+      _index = static_cast<uint32_t>( m_vSlots.size() );
+      m_vSlots.push_back( slot_t{ value_t{}, 1 } );
+    }
+
+    m_vSlots[_index].value = std::move(value);
+
+    return node_handle_t{ _index, m_vSlots[_index].generation };
+  }
+
+  /**
+   * @return pointer to the value or nullptr if \param handle is stale or not valid.
+   */
+  constexpr value_t*        get( const node_handle_t& handle ) noexcept(true)
+  {
+    if ( ( handle.index >= m_vSlots.size() ) || ( m_vSlots[handle.index].generation != handle.generation ) )
+      return nullptr;
+
+    return &m_vSlots[handle.index].value;
+  }
+  /***/
+  constexpr const value_t*  get( const node_handle_t& handle ) const noexcept(true)
+  {
+    if ( ( handle.index >= m_vSlots.size() ) || ( m_vSlots[handle.index].generation != handle.generation ) )
+      return nullptr;
+
+    return &m_vSlots[handle.index].value;
+  }
+
+  /**
+   * Release the slot, all handles to it become stale.
+   */
+  bool_t          erase( const node_handle_t& handle ) noexcept(true)
+  {
+    if ( get( handle ) == nullptr )
+      return false;
+
+    slot_t& _slot = m_vSlots[handle.index];
+
+    _slot.value = value_t{};
+    /* Generation 0 is reserved for invalid handles */
+    if ( ++_slot.generation == 0 )
+      _slot.generation = 1;
+
+    m_vFree.push_back( handle.index );
+    return true;
+  }
+
+  /***/
+  constexpr std::size_t     size() const noexcept(true)
+  { return m_vSlots.size() - m_vFree.size(); }
+
+private:
+  struct slot_t {
+    value_t     value;
+    uint32_t    generation;
+  };
+
+  std::vector<slot_t>     m_vSlots;
+  std::vector<uint32_t>   m_vFree;
+};
+
+}
+
+#endif // URE_SLOT_MAP_H
@@ -0,0 +1,234 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_STATE_CACHE_H
+#define URE_STATE_CACHE_H
+
+#include "ure_object.h"
+
+#include <array>
+#include <vector>
+
+namespace ure {
+
+/**
+ * Shadow copy of the GL state for a single context.
+ * Each Window own an instance for its context, and all backend calls that 
+ * change program, textures, capabilities, blending, viewport, clear color, 
+ * pixel store, buffers or framebuffer bindings go through the instance current 
+ * for the calling thread, so that only real changes reach the driver.
+ * Code that touch GL state directly, as ImGui does, must call invalidate() 
+ * when done.
+ */
+class StateCache final : public Object
+{
+public:
+  /***/
+  struct stats_t {
+    uint32_t  issued;               /* calls forwarded to the driver   */
+    uint32_t  skipped;              /* calls dropped as redundant      */
+  };
+
+  /***/
+  StateCache() noexcept(true);
+  /***/
+  virtual ~StateCache() noexcept(true);
+
+  /**
+   * Return instance made current for calling thread, if no one has been 
+   * made current a default instance, per thread, will be returned.
+   */
+  static StateCache&  get_current() noexcept(true);
+  /**
+   * Same as get_current(), but return nullptr once the default instance for 
+   * calling thread has been destroyed. Must be used by destructors, since GL 
+   * objects can be released during thread or static teardown.
+   */
+  static StateCache*  find_current() noexcept(true);
+  /**
+   * Should be called each time that the context related to this instance
+   * will be made current.
+   */
+  void_t              make_current() noexcept(true);
+  /**
+   * Detach instance from calling thread if current.
+   */
+  void_t              release() noexcept(true);
+  /**
+   * Forget all cached values so that next calls will reach the driver.
+   */
+  void_t              invalidate() noexcept(true);
+
+  /***/
+  void_t  use_program( uint_t program ) noexcept(true);
+  /**
+   * @param unit       texture unit index, not GL_TEXTUREi.
+   */
+  void_t  active_texture( uint_t unit ) noexcept(true);
+  /**
+   * Bind texture to the active texture unit.
+   */
+  void_t  bind_texture( enum_t target, uint_t texture ) noexcept(true);
+  /***/
+  void_t  bind_buffer( enum_t target, uint_t buffer ) noexcept(true);
+  /**
+   * Element array buffer binding is part of vertex array state, so it
+   * will be forgotten each time a different vertex array will be bound.
+   */
+  void_t  bind_vertex_array( uint_t array ) noexcept(true);
+  /***/
+  void_t  bind_framebuffer( uint_t framebuffer ) noexcept(true);
+  /**
+   * Framebuffer bound to GL_FRAMEBUFFER, read from the driver only when not cached.
+   */
+  uint_t  get_framebuffer() noexcept(true);
+  /***/
+  void_t  enable( enum_t cap ) noexcept(true);
+  /***/
+  void_t  disable( enum_t cap ) noexcept(true);
+  /***/
+  void_t  blend_func( enum_t sfactor, enum_t dfactor ) noexcept(true);
+  /***/
+  void_t  blend_func_separate( enum_t srgb, enum_t drgb, enum_t salpha, enum_t dalpha ) noexcept(true);
+  /**
+   * Blending for straight alpha sources. While a premultiplied target is bound 
+   * alpha is accumulated with GL_ONE, GL_ONE_MINUS_SRC_ALPHA, so that the target
+   * ends up holding premultiplied colors.
+   */
+  void_t  blend_alpha() noexcept(true);
+  /**
+   * Blending for premultiplied sources, as textures filled by a RenderTarget.
+   */
+  void_t  blend_premultiplied() noexcept(true);
+  /**
+   * Set by RenderTarget while it is bound, see blend_alpha().
+   */
+  constexpr void_t  set_premultiplied_target( bool_t premultiplied ) noexcept(true)
+  { m_premultiplied_target = premultiplied; }
+  /***/
+  constexpr bool_t  is_premultiplied_target() const noexcept(true)
+  { return m_premultiplied_target; }
+  /***/
+  void_t  viewport( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept(true);
+  /**
+   * Current viewport, read from the driver only when not cached.
+   */
+  void_t  get_viewport( int_t& x, int_t& y, sizei_t& width, sizei_t& height ) noexcept(true);
+  /**
+   * Box used when GL_SCISSOR_TEST is enabled, in window coordinates.
+   */
+  void_t  scissor( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept(true);
+  /***/
+  void_t  stencil_func( enum_t func, int_t ref, uint_t mask ) noexcept(true);
+  /***/
+  void_t  stencil_op( enum_t sfail, enum_t dpfail, enum_t dppass ) noexcept(true);
+  /***/
+  void_t  color_mask( bool_t red, bool_t green, bool_t blue, bool_t alpha ) noexcept(true);
+  /***/
+  void_t  clear_color( float_t red, float_t green, float_t blue, float_t alpha ) noexcept(true);
+  /**
+   * Current clear color, read from the driver only when not cached.
+   */
+  void_t  get_clear_color( float_t& red, float_t& green, float_t& blue, float_t& alpha ) noexcept(true);
+  /***/
+  void_t  pixel_store( enum_t pname, int_t param ) noexcept(true);
+  /***/
+  void_t  line_width( float_t width ) noexcept(true);
+
+  /**
+   * Must be called when objects are deleted, since GL revert to 
+   * zero bindings that referenced them.
+   */
+  void_t  deleted_program( uint_t program ) noexcept(true);
+  /***/
+  void_t  deleted_texture( uint_t texture ) noexcept(true);
+  /***/
+  void_t  deleted_buffer( uint_t buffer ) noexcept(true);
+  /***/
+  void_t  deleted_vertex_array( uint_t array ) noexcept(true);
+  /***/
+  void_t  deleted_framebuffer( uint_t framebuffer ) noexcept(true);
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /***/
+  constexpr void_t         reset_stats() noexcept(true)
+  { m_stats = {}; }
+
+private:
+  /* Cached value with a validity flag, invalid values always reach the driver. */
+  template<typename value_t>
+  struct cached_t {
+    value_t   value;
+    bool_t    valid;
+  };
+
+  /***/
+  template<typename value_t>
+  bool_t  update( cached_t<value_t>& cached, const value_t& value ) noexcept(true);
+  /***/
+  void_t  set_cap( enum_t cap, bool_t enabled ) noexcept(true);
+
+private:
+  static constexpr std::size_t  k_max_texture_units = 16;
+
+  using blend_func_t  = std::array<enum_t, 4>;
+  using viewport_t    = std::array<int_t, 4>;
+  using stencil_t     = std::array<uint_t, 3>;
+  using mask_t        = std::array<bool_t, 4>;
+  using color_t       = std::array<float_t, 4>;
+  using textures_t    = std::array<cached_t<uint_t>, k_max_texture_units>;
+
+  struct cap_t {
+    enum_t            cap;
+    cached_t<bool_t>  enabled;
+  };
+
+  cached_t<uint_t>        m_program;
+  cached_t<uint_t>        m_active_texture;
+  textures_t              m_textures_2d;
+  textures_t              m_textures_cube;
+  cached_t<uint_t>        m_array_buffer;
+  cached_t<uint_t>        m_element_buffer;
+  cached_t<uint_t>        m_vertex_array;
+  cached_t<uint_t>        m_framebuffer;
+  std::vector<cap_t>      m_vCaps;
+  cached_t<blend_func_t>  m_blend_func;
+  cached_t<viewport_t>    m_viewport;
+  cached_t<viewport_t>    m_scissor;
+  cached_t<stencil_t>     m_stencil_func;
+  cached_t<stencil_t>     m_stencil_op;
+  cached_t<mask_t>        m_color_mask;
+  cached_t<color_t>       m_clear_color;
+  cached_t<int_t>         m_pack_alignment;
+  cached_t<int_t>         m_unpack_alignment;
+  cached_t<int_t>         m_unpack_row_length;
+  cached_t<float_t>       m_line_width;
+  bool_t                  m_premultiplied_target;
+  stats_t                 m_stats;
+};
+
+}
+
+#endif // URE_STATE_CACHE_H
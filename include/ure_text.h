@@ -26,16 +26,47 @@
 
 #include "ure_texture.h"
 
+#include <memory>
+#include <vector>
+
 namespace ure {
 
 /**
+ * Text is a run of quads, one for each glyph, referencing a single texture 
+ * that is usually shared with other texts using the same font.
  */
 class Text 
 {
 public:
-  /***/
+  /**
+   * Glyph quad in pixels, relative to top left corner of the text with y axis 
+   * pointing down, and related texture coordinates.
+   */
+  struct glyph_t {
+    glm::vec2   min;
+    glm::vec2   max;
+    glm::vec2   uv_min;
+    glm::vec2   uv_max;
+  };
+
+  /**
+   * Text rendered in a dedicated texture, that will be owned by the Text,
+   * as a single glyph.
+   */
   Text( Texture* pTexture )
-    : m_texture( pTexture ), m_color( 0.0f, 0.0f, 0.0f, 1.0f )
+    : m_texture( pTexture ), m_size( 0, 0 ), m_color( 0.0f, 0.0f, 0.0f, 1.0f )
+  {
+    if ( m_texture != nullptr )
+    {
+      m_size = m_texture->get_size();
+      m_glyphs.push_back( { glm::vec2( 0.0f ), glm::vec2( m_size.width, m_size.height ), glm::vec2( 0.0f ), glm::vec2( 1.0f ) } );
+    }
+  }
+  /**
+   * Text made by \param glyphs all taken from \param texture.
+   */
+  Text( std::shared_ptr<Texture> texture, const Size& size, std::vector<glyph_t>&& glyphs )
+    : m_texture( texture ), m_size( size ), m_glyphs( std::move(glyphs) ), m_color( 0.0f, 0.0f, 0.0f, 1.0f )
   {}
   /***/
   virtual ~Text()
@@ -52,9 +83,19 @@ public:
   /***/
   inline  Texture*         get_texture() const
   { return m_texture.get(); }
+  /**
+   * Size in pixels of the area covered by the text, margins included.
+   */
+  inline  const Size&      get_size() const
+  { return m_size; }
+  /***/
+  inline  const std::vector<glyph_t>& get_glyphs() const
+  { return m_glyphs; }
 
 private:
-  std::unique_ptr<Texture>    m_texture;
+  std::shared_ptr<Texture>    m_texture;
+  Size                        m_size;
+  std::vector<glyph_t>        m_glyphs;
   glm::vec4                   m_color;
 };
 
@@ -37,34 +37,68 @@ namespace ure {
  */
 class Texture : public HandledObject
 {
+  friend class TextureResidency;
 public:
 
   enum class lifecycle_t : int32_t {
     eRender,                        /* Lifecycle for the texture will be related to render(),
-                                     * that means that texture will be created, used and areleased
-                                     * during the render().
+                                     * that means that texture will be created on first render() 
+                                     * and then kept resident by TextureResidency within its budget.
+                                     * Pixels are kept in RAM in order to upload them again after
+                                     * an eviction.
                                      */
     eObject,                        /* Lifecycle for the texture will be related to instance of
                                      * the object, so texture will be created and release only
                                      * when the instance will be destroiyed.
                                      */
+    eTarget,                        /* Storage only, no pixels are kept in RAM. The texture will be 
+                                     * created on first bind() with undefined content and then filled
+                                     * by rendering into it, see RenderTarget. It is never evicted.
+                                     */
   };
 
+  /**
+   * Formats eRed and eRG are stored as GL_R8 and GL_RG8, then sampled as eAlpha and 
+   * eLuminanceAlpha respectively through texture swizzle, so they can be used as mask 
+   * with the same shaders. WebGL has no swizzle, so there eAlpha and eLuminanceAlpha
+   * must be used instead: k_mask_format is the right single channel format for masks.
+   */
   enum class format_t : int32_t {
     eUndefined,
-    eRGB  = URE_RGB,
-    eRGBA = URE_RGBA
+    eAlpha          = URE_ALPHA,
+    eLuminance      = URE_LUMINANCE,
+    eLuminanceAlpha = URE_LUMINANCE_ALPHA,
+    eRed            = URE_RED,
+    eRG             = URE_RG,
+    eRGB            = URE_RGB,
+    eRGBA           = URE_RGBA
   };
 
+#if defined(__EMSCRIPTEN__)
+  static constexpr format_t k_mask_format = format_t::eAlpha;
+#else
+  static constexpr format_t k_mask_format = format_t::eRed;
+#endif
+
+  /**
+   * Packed types are valid only with eRGB (eUnsignedShort565) and eRGBA (eUnsignedShort4444).
+   */
   enum class type_t : int32_t {
     eUndefined,
-    eUnsignedByte = URE_UNSIGNED_BYTE
+    eUnsignedByte       = URE_UNSIGNED_BYTE,
+    eUnsignedShort565   = URE_UNSIGNED_SHORT_5_6_5,
+    eUnsignedShort4444  = URE_UNSIGNED_SHORT_4_4_4_4
   };
 
   /* Delete default constructor */
   constexpr Texture() = delete;
 
-  Texture( sizei_t width, sizei_t height, format_t format, type_t type ) noexcept(true);
+  /**
+   * Pixels buffer will be allocated and zero filled. With lifecycle_t::eObject the
+   * texture will be created on first bind() and the buffer will be kept in 
+   * order to allow updates through update_rows().
+   */
+  Texture( sizei_t width, sizei_t height, format_t format, type_t type, lifecycle_t lifecycle = lifecycle_t::eRender ) noexcept(true);
 
   /***/
   Texture( Image&& image, lifecycle_t lifecycle = lifecycle_t::eRender,
@@ -89,6 +123,13 @@ public:
   constexpr const Size& get_size() const noexcept(true)
   { return m_size; }
 
+  /**
+   * @return true if colors are premultiplied by alpha, as for lifecycle_t::eTarget
+   *         textures, that must be drawn with StateCache::blend_premultiplied().
+   */
+  constexpr bool_t      is_premultiplied() const noexcept(true)
+  { return m_lifecycle == lifecycle_t::eTarget; }
+
   /**
    * @return pixels buffer length in bytes
    */
@@ -99,6 +140,40 @@ public:
   constexpr uint8_t*    get_pixels() const noexcept(true)
   { return m_pixels; }
 
+  /**
+   * @return pixels kept in RAM plus video memory when resident.
+   */
+  virtual std::size_t   get_memory_usage() const noexcept(true) override
+  { return ( ( m_pixels != nullptr )?m_length:0 ) + ( is_valid()?m_length:0 ); }
+
+  /**
+   * @return bytes for each pixel with current format and type.
+   */
+  constexpr uint32_t    get_bytes_per_pixel() const noexcept(true)
+  {
+    if ( m_type != type_t::eUnsignedByte )
+      return 2;
+
+    switch ( m_format )
+    {
+      case format_t::eAlpha         : 
+      case format_t::eLuminance     : 
+      case format_t::eRed           : return 1;
+      case format_t::eLuminanceAlpha: 
+      case format_t::eRG            : return 2;
+      case format_t::eRGB           : return 3;
+      default: break;
+    }
+    return 4;
+  }
+
+  /**
+   * Mark rows [first, first+count) of get_pixels() as modified, so that they
+   * will be sent to the GPU on next bind(). Meaningful only for textures with
+   * lifecycle_t::eObject that still own their pixels buffer.
+   */
+  void_t                update_rows( sizei_t first, sizei_t count ) noexcept(true);
+
   /***/
   void_t                set_packing( int32_t param ) noexcept(true);
   /***/
@@ -110,8 +185,18 @@ public:
   inline void_t         setParameteri( uint32_t target, uint32_t pname, GLint param ) noexcept(true);
 
   /**
-   * Push image data, vertex coordinates and texture coordinates then draw it.
-   * At current time all data will be sent to GPU each time render will be called.
+   * Make the texture current for the active texture unit, creating and uploading
+   * it when not resident. Each call must be paired with unbind().
+   */
+  bool_t                bind( enum_t target, int_t level, int_t tws = URE_CLAMP_TO_EDGE, int_t twt = URE_CLAMP_TO_EDGE ) noexcept(true);
+  /**
+   * Textures stay resident after unbind(), releasing them is up to TextureResidency.
+   */
+  void_t                unbind( enum_t target ) noexcept(true);
+
+  /**
+   * Push vertex coordinates and texture coordinates then draw it.
+   * Image data will be sent to GPU only if the texture is not resident.
    * 
    * @param target     Specifies the target texture of the active texture unit. 
    *                   Must be GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X, 
@@ -145,6 +230,8 @@ private:
   lifecycle_t m_lifecycle;
   uint32_t    m_length;
   uint8_t*    m_pixels;
+  sizei_t     m_dirty_first;          /* first row to upload */
+  sizei_t     m_dirty_last;           /* last row to upload + 1, m_dirty_first when clean */
 };
 
 }
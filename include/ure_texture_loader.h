@@ -0,0 +1,218 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_TEXTURE_LOADER_H
+#define URE_TEXTURE_LOADER_H
+
+#include "ure_common_defs.h"
+#include "ure_image.h"
+#include "ure_image_decoder.h"
+#include "ure_resources_fetcher.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ure {
+
+class Texture;
+class ResourcesCollector;
+
+/**
+ * Pipeline loading remote textures in three stages: download with ResourcesFetcher,
+ * decode with ImageDecoder and upload to the GPU from update(), that must be called
+ * from the thread owning the context, typically in on_run().
+ * Each stage has a bounded number of requests, so a stage that can't keep up stops
+ * the previous one instead of accumulating bodies or images in memory.
+ * ResourcesFetcher and ImageDecoder must be initialized while the loader is in use.
+ */
+class TextureLoader final
+{
+public:
+  /***/
+  enum class status_t : uint8_t {
+    eWaiting,           /* waiting for a free download slot     */
+    eFetching,          /* downloading or waiting for a decoder */
+    eDecoding,          /* decoding or waiting for the upload   */
+    eResident,          /* texture available                    */
+    eFailed             /* download or decoding failed          */
+  };
+
+  /**
+   * Texture requested to the loader, get_texture() returns the placeholder until 
+   * the texture is resident. Status is updated only by TextureLoader::update().
+   */
+  class Handle
+  {
+    friend class TextureLoader;
+  public:
+    /***/
+    Handle( const std::string& name, std::shared_ptr<Texture> texture, status_t status ) noexcept(true)
+      : m_name( name ), m_texture( std::move(texture) ), m_status( status )
+    {}
+
+    /***/
+    constexpr const std::string&              get_name() const noexcept(true)
+    { return m_name; }
+    /***/
+    constexpr status_t                        get_status() const noexcept(true)
+    { return m_status; }
+    /***/
+    constexpr bool_t                          is_resident() const noexcept(true)
+    { return m_status == status_t::eResident; }
+    /***/
+    constexpr const std::shared_ptr<Texture>& get_texture() const noexcept(true)
+    { return m_texture; }
+
+  private:
+    const std::string         m_name;
+    std::shared_ptr<Texture>  m_texture;
+    status_t                  m_status;
+  };
+
+  using handle_t = std::shared_ptr<Handle>;
+
+  /**
+   * Maximum number of requests in each stage.
+   */
+  struct limits_t {
+    uint32_t    fetching;     /* downloads in progress or waiting for a decoder  */
+    uint32_t    decoding;     /* images being decoded or waiting for the upload  */
+    uint32_t    uploads;      /* textures uploaded for each call to update()     */
+  };
+
+  /***/
+  struct stage_stats_t {
+    uint32_t    depth;        /* requests currently in the stage                 */
+    uint32_t    completed;    /* requests that left the stage since last reset   */
+    uint64_t    total_us;     /* time spent in the stage by completed requests   */
+    uint64_t    max_us;       /* longest time spent in the stage                 */
+  };
+
+  /***/
+  struct stats_t {
+    uint32_t       waiting;   /* requests waiting for a download slot            */
+    stage_stats_t  fetch;
+    stage_stats_t  decode;
+    stage_stats_t  upload;
+    uint32_t       failed;    /* requests failed since last reset                */
+  };
+
+  static constexpr limits_t k_default_limits = { 8, 4, 2 };
+
+  /**
+   * \param placeholder texture returned by handles until their texture is resident.
+   * \param pCollector  if not nullptr, textures are attached to the collector with their
+   *                    name once resident and load() will look there first.
+   */
+  TextureLoader( std::shared_ptr<Texture> placeholder, ResourcesCollector* pCollector = nullptr, 
+                 Image::loader_t il = Image::loader_t::eStb ) noexcept(true);
+  /**
+   * Cancel downloads still in progress, no fetcher callback reaches the loader afterwards.
+   */
+  ~TextureLoader() noexcept(true);
+
+  /***/
+  void_t            set_limits( const limits_t& limits ) noexcept(true);
+  /***/
+  constexpr const limits_t& get_limits() const noexcept(true)
+  { return m_limits; }
+
+  /**
+   * Request texture \param name from \param url. Requesting a name already loading 
+   * returns the same handle. Higher \param priority requests are downloaded first.
+   */
+  handle_t          load( const std::string& name, const std::string& url, int32_t priority = 0, bool_t verify_ssl = true ) noexcept(true);
+  /**
+   * Change priority of a request waiting or downloading.
+   */
+  bool_t            set_priority( const handle_t& handle, int32_t priority ) noexcept(true);
+  /**
+   * Stop loading \param handle, that will keep the placeholder.
+   */
+  bool_t            cancel( const handle_t& handle ) noexcept(true);
+
+  /**
+   * Move requests through the stages and upload decoded images, spending at most
+   * \param max_time_us microseconds on uploads; 0 means no limit.
+   * Return number of textures become resident.
+   */
+  uint32_t          update( uint32_t max_time_us = 0 ) noexcept(true);
+
+  /**
+   * @return true when no request is waiting or in any stage, so that update() has nothing to do.
+   */
+  bool_t            is_idle() const noexcept(true);
+
+  /***/
+  stats_t           get_stats() const noexcept(true);
+  /***/
+  void_t            reset_stats() noexcept(true);
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  /***/
+  struct item_t {
+    handle_t                      handle;
+    std::string                   url;
+    int32_t                       priority;
+    bool_t                        verify_ssl;
+    bool_t                        cancelled;       /* dropped when leaving the decoder */
+    ResourcesFetcher::request_t   request;
+    clock_t::time_point           started;         /* when current stage has been entered */
+  };
+
+  /* Receives completions from fetcher and decoder threads, defined in the source */
+  class pipe_t;
+
+  /***/
+  void_t            fail( item_t& item ) noexcept(true);
+  /***/
+  void_t            enqueue( const std::string& name, int32_t priority ) noexcept(true);
+  /***/
+  static void_t     complete( stage_stats_t& stage, clock_t::time_point started ) noexcept(true);
+
+private:
+  std::shared_ptr<Texture>                  m_placeholder;
+  ResourcesCollector*                       m_pCollector;
+  const Image::loader_t                     m_loader;
+  const std::string                         m_app_id;
+  limits_t                                  m_limits;
+  std::shared_ptr<pipe_t>                   m_pipe;
+
+  std::unordered_map<std::string, item_t>   m_items;         /* requests not yet resident        */
+  std::deque<std::string>                   m_waiting;       /* sorted by priority               */
+  std::deque<std::pair<std::string, ImageDecoder::data_t>> m_downloaded; /* waiting for a decoder */
+  std::deque<std::pair<std::string, std::unique_ptr<Image>>> m_decoded;  /* waiting for upload  */
+  uint32_t                                  m_fetching;      /* includes m_downloaded            */
+  uint32_t                                  m_decoding;      /* submitted to ImageDecoder        */
+  stats_t                                   m_stats;
+};
+
+}
+
+#endif // URE_TEXTURE_LOADER_H
@@ -0,0 +1,118 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_TEXTURE_RESIDENCY_H
+#define URE_TEXTURE_RESIDENCY_H
+
+#include "ure_common_defs.h"
+
+#include <core/singleton.h>
+#include <list>
+#include <unordered_map>
+
+namespace ure {
+
+class Texture;
+
+/**
+ * Singleton keeping textures resident in GPU memory across frames.
+ * Textures that retain their pixels in RAM are created on first bind() and then
+ * kept until the budget is exceeded; at that point least recently drawn textures
+ * are released and will be uploaded again from their RAM copy when drawn next time.
+ * Textures that released their pixels cannot be uploaded again, so they are not
+ * managed here and never evicted.
+ */
+class TextureResidency final : public core::singleton_t<TextureResidency>
+{
+  friend class singleton_t<TextureResidency>;
+public:
+  /***/
+  struct stats_t {
+    uint32_t    textures;           /* textures currently resident           */
+    uint64_t    resident_bytes;     /* bytes currently resident              */
+    uint32_t    uploads;            /* textures created since last reset     */
+    uint64_t    uploaded_bytes;     /* bytes sent with glTexImage2D()        */
+    uint32_t    evictions;          /* textures released since last reset    */
+  };
+
+  static constexpr uint64_t k_default_budget = 64 * 1024 * 1024;
+
+  /**
+   * Set maximum amount of bytes for managed textures, textures exceeding
+   * the new budget will be evicted immediately.
+   */
+  void_t            set_budget( uint64_t bytes ) noexcept(true);
+  /***/
+  constexpr uint64_t get_budget() const noexcept(true)
+  { return m_budget; }
+
+  /**
+   * Register \param texture just created in GPU memory, evicting least recently 
+   * used textures if required to stay within the budget.
+   */
+  void_t            insert( Texture& texture ) noexcept(true);
+  /**
+   * Mark \param texture as the most recently used.
+   */
+  void_t            touch( const Texture& texture ) noexcept(true);
+  /**
+   * Forget \param texture, without releasing GPU memory.
+   */
+  void_t            remove( const Texture& texture ) noexcept(true);
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /**
+   * Reset per frame counters, residency counters are kept.
+   */
+  constexpr void_t         reset_stats() noexcept(true)
+  { m_stats.uploads = 0; m_stats.uploaded_bytes = 0; m_stats.evictions = 0; }
+
+protected:
+  /***/
+  void_t on_initialize() noexcept(true)
+  { m_budget = k_default_budget; m_stats = {}; }
+  /**
+   * Release all resident textures while the context is still available.
+   */
+  void_t on_finalize() noexcept(true);
+
+private:
+  /**
+   * Evict least recently used textures until \param required bytes fit in the budget.
+   */
+  void_t            evict( uint64_t required ) noexcept(true);
+
+private:
+  using lru_t = std::list<Texture*>;
+
+  lru_t                                           m_lru;         /* front is the most recently used */
+  std::unordered_map<const Texture*, lru_t::iterator> m_mapLru;
+  uint64_t                                        m_budget;
+  stats_t                                         m_stats;
+};
+
+}
+
+#endif // URE_TEXTURE_RESIDENCY_H
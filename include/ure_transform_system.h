@@ -0,0 +1,192 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_TRANSFORM_SYSTEM_H
+#define URE_TRANSFORM_SYSTEM_H
+
+#include "ure_common_defs.h"
+#include "ure_transformations_matrix.h"
+
+#include <core/singleton.h>
+#include <glm/gtc/quaternion.hpp>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ure {
+
+/**
+ * Singleton holding local and world matrices for scene nodes in contiguous blocks,
+ * one entry for each transform, addressed by index. Blocks are never moved, so 
+ * references to matrices stay valid until their transform is released.
+ * Editing a local matrix only marks the transform dirty, world matrices are computed
+ * by update() in a single linear pass where parents come before their children, 
+ * so that dirty flags propagate down the hierarchy in the same pass.
+ */
+class TransformSystem final : public core::singleton_t<TransformSystem>
+{
+  friend class singleton_t<TransformSystem>;
+public:
+  using transform_t = uint32_t;
+
+  static constexpr transform_t k_invalid_transform = std::numeric_limits<transform_t>::max();
+
+  /***/
+  struct stats_t {
+    uint32_t    transforms;         /* transforms currently allocated           */
+    uint32_t    updates;            /* world matrices computed since reset      */
+  };
+
+  /**
+   * Reserve a transform with identity local matrix and no parent.
+   * @return k_invalid_transform if memory is not available.
+   */
+  transform_t       allocate() noexcept(true);
+  /***/
+  void_t            release( transform_t transform ) noexcept(true);
+
+  /**
+   * World matrix of \param transform will be the world matrix of \param parent 
+   * multiplied by its local matrix, k_invalid_transform to detach it.
+   */
+  bool_t            set_parent( transform_t transform, transform_t parent ) noexcept(true);
+  /***/
+  constexpr transform_t  get_parent( transform_t transform ) const noexcept(true)
+  { return m_vParent[transform]; }
+
+  /**
+   * Local matrix to be modified, \param transform is marked dirty.
+   * Reference is valid until \param transform is released, but changes made
+   * through it after the call are not tracked: call edit_local() again for them.
+   */
+  inline xform_matrix_t&        edit_local( transform_t transform ) noexcept(true)
+  {
+    m_vDirty[transform] = 1;
+    m_dirty             = true;
+    m_changes++;
+    return m_local[transform];
+  }
+  /***/
+  constexpr const xform_matrix_t&  get_local( transform_t transform ) const noexcept(true)
+  { return m_local[transform]; }
+  /**
+   * Compose local matrix from translation, rotation and scale.
+   */
+  void_t            set_trs( transform_t transform, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale ) noexcept(true);
+
+  /**
+   * World matrix as computed by last update().
+   */
+  constexpr const glm::mat4&    get_world( transform_t transform ) const noexcept(true)
+  { return m_world[transform]; }
+
+  /**
+   * Compute world matrices of dirty transforms and their descendants.
+   * @return number of world matrices computed.
+   */
+  uint32_t          update() noexcept(true);
+  /**
+   * Counter incremented by each allocation, release, parent change or local
+   * matrix edit, not reset by update().
+   */
+  constexpr uint32_t       get_changes() const noexcept(true)
+  { return m_changes; }
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /**
+   * Reset update counter, allocation counter is kept.
+   */
+  constexpr void_t         reset_stats() noexcept(true)
+  { m_stats.updates = 0; }
+
+protected:
+  /***/
+  void_t on_initialize() noexcept(true)
+  { m_stats = {}; m_changes = 0; m_dirty = false; m_linear = true; m_order_dirty = false; }
+  /***/
+  void_t on_finalize() noexcept(true);
+
+private:
+  /**
+   * Array growing by blocks of k_block_size elements, elements are never moved.
+   */
+  template<typename value_t>
+  class blocks_t
+  {
+  public:
+    static constexpr uint32_t k_block_bits = 8;
+    static constexpr uint32_t k_block_size = 1u << k_block_bits;
+
+    /***/
+    constexpr value_t&        operator[]( transform_t index ) noexcept(true)
+    { return m_vBlocks[index >> k_block_bits][index & (k_block_size-1)]; }
+    /***/
+    constexpr const value_t&  operator[]( transform_t index ) const noexcept(true)
+    { return m_vBlocks[index >> k_block_bits][index & (k_block_size-1)]; }
+
+    /**
+     * Make room for \param count elements, return false if memory is not available.
+     */
+    bool_t                    reserve( std::size_t count ) noexcept(true)
+    {
+      while ( ( m_vBlocks.size() << k_block_bits ) < count )
+      {
+        std::unique_ptr<value_t[]> _block( new(std::nothrow) value_t[k_block_size] );
+        if ( _block == nullptr )
+          return false;
+
+        m_vBlocks.push_back( std::move(_block) );
+      }
+      return true;
+    }
+    /***/
+    void_t                    clear() noexcept(true)
+    { m_vBlocks.clear(); }
+
+  private:
+    std::vector<std::unique_ptr<value_t[]>>  m_vBlocks;
+  };
+
+  /***/
+  void_t            sort() noexcept(true);
+
+private:
+  blocks_t<xform_matrix_t>      m_local;
+  blocks_t<glm::mat4>           m_world;
+  std::vector<transform_t>      m_vParent;
+  std::vector<uint8_t>          m_vDirty;
+  std::vector<uint8_t>          m_vUsed;
+  std::vector<transform_t>      m_vFree;
+  std::vector<transform_t>      m_vOrder;         /* parents first, used only when indices are not */
+  uint32_t                      m_changes;        /* see get_changes()                             */
+  bool_t                        m_dirty;          /* at least one transform is dirty               */
+  bool_t                        m_linear;         /* all parents have lower index than children    */
+  bool_t                        m_order_dirty;    /* m_vOrder must be rebuilt                      */
+  stats_t                       m_stats;
+};
+
+}
+
+#endif // URE_TRANSFORM_SYSTEM_H
@@ -0,0 +1,140 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_VERTEX_SLAB_H
+#define URE_VERTEX_SLAB_H
+
+#include "ure_common_defs.h"
+
+#include <core/singleton.h>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ure {
+
+/**
+ * Singleton holding widgets quads in persistent vertex buffers.
+ * Quads are allocated once and addressed by index; vertices are kept in a CPU 
+ * shadow and only modified ranges are uploaded when the page is bound, so
+ * quads that do not change cost no vertex upload at all.
+ * Each page holds k_quads_per_page quads, so that all its vertices can be 
+ * addressed with 16 bits indices.
+ */
+class VertexSlab final : public core::singleton_t<VertexSlab>
+{
+  friend class singleton_t<VertexSlab>;
+public:
+  /* Vertex layout: attribute 0 point, 1 texture coordinates, 2 color. */
+  struct vertex_t {
+    glm::vec2   point;
+    glm::vec2   tex_coord;
+    glm::vec4   color;
+  };
+
+  /***/
+  struct stats_t {
+    uint32_t    quads;              /* quads currently allocated         */
+    uint32_t    pages;              /* pages currently allocated         */
+    uint32_t    uploads;            /* glBufferSubData() calls           */
+    uint32_t    uploaded_bytes;     /* bytes sent with glBufferSubData() */
+  };
+
+  using quad_t = uint32_t;
+
+  static constexpr quad_t   k_invalid_quad   = std::numeric_limits<quad_t>::max();
+  static constexpr uint32_t k_quads_per_page = 16384;
+
+  /**
+   * Reserve a quad, existing free slots are reused first.
+   * @return k_invalid_quad in case of failure.
+   */
+  quad_t            allocate() noexcept(true);
+  /***/
+  void_t            release( quad_t quad ) noexcept(true);
+  /**
+   * Update quad vertices, that must be 4 ordered as triangle strip.
+   * If \param texCoord is nullptr texture coordinates will be left untouched.
+   */
+  bool_t            update( quad_t quad, const std::vector<glm::vec2>& points, 
+                            const std::vector<glm::vec2>* texCoord, const glm::vec4& color ) noexcept(true);
+  /**
+   * @return CPU copy of the 4 quad vertices or nullptr if quad is not valid.
+   */
+  const vertex_t*   get_vertices( quad_t quad ) const noexcept(true);
+
+  /***/
+  static constexpr uint32_t get_page( quad_t quad ) noexcept(true)
+  { return quad / k_quads_per_page; }
+  /**
+   * @return index of the first quad vertex inside its page.
+   */
+  static constexpr uint32_t get_first( quad_t quad ) noexcept(true)
+  { return (quad % k_quads_per_page) * 4; }
+
+  /**
+   * Upload pending changes for \param page, then bind its buffer and set 
+   * vertex attributes. When GL3 backend is selected a vertex array object
+   * will be used instead.
+   */
+  bool_t            bind( uint32_t page ) noexcept(true);
+  /**
+   * Restore client side arrays used by immediate drawing.
+   */
+  void_t            unbind() noexcept(true);
+
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /**
+   * Reset upload counters, allocation counters are kept.
+   */
+  constexpr void_t         reset_stats() noexcept(true)
+  { m_stats.uploads = 0; m_stats.uploaded_bytes = 0; }
+
+protected:
+  /***/
+  void_t on_initialize() noexcept(true)
+  { m_stats = {}; }
+  /***/
+  void_t on_finalize() noexcept(true);
+
+private:
+  /***/
+  struct page_t {
+    uint_t                  vbo;
+    uint_t                  vao;
+    std::vector<vertex_t>   vertices;
+    uint32_t                dirty_first;      /* first modified vertex */
+    uint32_t                dirty_last;       /* last modified vertex + 1, 0 when clean */
+  };
+
+  std::vector<std::unique_ptr<page_t>>  m_vPages;
+  std::vector<quad_t>                   m_vFree;
+  std::vector<bool_t>                   m_vUsed;
+  stats_t                               m_stats;
+};
+
+}
+
+#endif // URE_VERTEX_SLAB_H
@@ -40,7 +40,7 @@ public:
   /***/
   ViewPort() noexcept(true)
     : m_scene_graph( nullptr ), m_projection_matrix( glm::mat4( 1.0f ) ),
-      m_pos( 0.0f, 0.0f ), m_size( 2, 2 ) 
+      m_pos( 0.0f, 0.0f ), m_size( 2, 2 ), m_dirty( true ), m_changes{}
   {
     reset();
   }
@@ -48,7 +48,7 @@ public:
   /***/
   ViewPort( std::unique_ptr<SceneGraph> scene_graph, const glm::mat4& projection_matrix ) noexcept(true)
     : m_scene_graph( std::move(scene_graph) ), m_projection_matrix( projection_matrix ),
-      m_pos( 0.0f, 0.0f ), m_size( 2, 2 )
+      m_pos( 0.0f, 0.0f ), m_size( 2, 2 ), m_dirty( true ), m_changes{}
   {
     m_projection_matrix = projection_matrix;
     
@@ -76,6 +76,7 @@ public:
   {
     std::unique_ptr<SceneGraph> old_sg = std::move(m_scene_graph);
     m_scene_graph = std::move(scene_graph);
+    m_dirty       = true;
     return old_sg;
   }
 
@@ -90,6 +91,9 @@ public:
   /***/
   constexpr void_t    set_area( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept(true)
   {
+    if ( ( m_pos.x != x ) || ( m_pos.y != y ) || ( m_size.width != width ) || ( m_size.height != height ) )
+      m_dirty = true;
+
     m_pos.x       = x;     m_pos.y       = y;
     m_size.width  = width; m_size.height = height;      
   }
@@ -112,8 +116,31 @@ public:
   constexpr sizei_t height() const noexcept(true)
   { return m_size.height; }
 
+  /**
+   * Camera used by this view port in place of the active camera of the scene,
+   * so that more view ports can show the same scene from different points of view.
+   * nullptr to use the active camera of the scene.
+   */
+  inline void_t             set_camera( camera_ptr camera ) noexcept(true)
+  { m_camera = std::move(camera); m_dirty = true; }
+  /***/
+  inline const camera_ptr&  get_camera() const noexcept(true)
+  { return m_camera; }
+
   /***/
   bool_t            render() noexcept(true);
+  /**
+   * Force next needs_render() to return true, for changes that are not tracked
+   * such as window exposure or edits made through references to matrices.
+   */
+  constexpr void_t  invalidate() noexcept(true)
+  { m_dirty = true; }
+  /**
+   * @return true when area, camera or scene graph changed, or when any widget, 
+   *         camera or scene node transform changed since last render(). Frames
+   *         can be skipped while it returns false, since they will be the same.
+   */
+  bool_t            needs_render() const noexcept(true);
   
   /**
    * eg.
@@ -123,12 +150,25 @@ public:
   constexpr xform_matrix_t&   get_projection_matrix() noexcept(true)
   { return m_projection_matrix; }
 
+private:
+  /* Change counters observed at last render() */
+  struct changes_t {
+    uint32_t    widgets;
+    uint32_t    cameras;
+    uint32_t    transforms;
+  };
+
+  /***/
+  static changes_t          get_changes() noexcept(true);
+
 private:
   std::unique_ptr<SceneGraph> m_scene_graph;
   xform_matrix_t              m_projection_matrix;
   Position2D                  m_pos;
   Size                        m_size;
-  
+  camera_ptr                  m_camera;
+  bool_t                      m_dirty;
+  changes_t                   m_changes;
 };
 
 }
@@ -26,6 +26,7 @@
 
 #include "ure_object.h"
 #include "ure_renderer.h"
+#include "ure_state_cache.h"
 #include "ure_window_options.h"
 #include "ure_window_events.h"
 #include "ure_message.h"
@@ -93,6 +94,11 @@ public:
   /***/
   const Renderer*    get_renderer() const noexcept(true)
   { return m_ptrRenderer.get(); }
+  /**
+   * GL state cache for the window context, available after create().
+   */
+  StateCache*        get_state_cache() noexcept(true)
+  { return m_ptrState.get(); }
 
   /***/
   bool_t             show( enum_t flags = static_cast<enum_t>(processing_flag_t::epfCalling) ) noexcept(true);
@@ -207,6 +213,7 @@ private:
   std::unique_ptr<window_options>  m_ptrWinOptions;
   WindowHandler                    m_hWindow;
   std::unique_ptr<Renderer>        m_ptrRenderer;
+  std::unique_ptr<StateCache>      m_ptrState;
   mailbox_type                     m_mbxMessages;  
 };
 
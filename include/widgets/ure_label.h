@@ -53,8 +53,7 @@ public:
   /***/
   Label( Widget* pParent ) noexcept(true);
   /***/
-  virtual ~Label() noexcept(true)
-  {}
+  virtual ~Label() noexcept(true);
   
   /***/
   inline constexpr const std::wstring& get_label() const noexcept(true)
@@ -83,6 +82,8 @@ private:
   
   /***/
   void_t                    _updateVertices( WidgetTextAligment align ) noexcept(true);
+  /***/
+  void_t                    _releaseQuads( std::size_t count ) noexcept(true);
 
 private:
   std::wstring              m_sLabel;
@@ -90,8 +91,7 @@ private:
   WidgetTextAligment        m_eAlignment;
   Text*                     m_pText;
   
-  std::vector<glm::vec2>    m_vVertices;
-  std::vector<glm::vec2>    m_vTexCoord;    
+  std::vector<VertexSlab::quad_t> m_vQuads;
 };
 
 }
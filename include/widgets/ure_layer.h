@@ -27,6 +27,7 @@
 #include "widgets/ure_widget.h"
 #include "ure_view_port.h"
 #include "ure_window_events.h"
+#include "ure_draw_list.h"
 
 namespace ure {
 
@@ -46,6 +47,27 @@ public:
   /***/
   bool_t          render( const glm::mat4& mvp ) noexcept(true);
   
+  /**
+   * When enabled, all widgets in the layer are collected into a draw list 
+   * during render() and submitted at the end sorted by program, texture and
+   * blending, merging adjacent draws that share the same state.
+   * Default is disabled.
+   */
+  void_t          set_batching( bool_t bEnable ) noexcept(true);
+  /***/
+  inline bool_t   is_batching() const noexcept(true)
+  { return (m_draw_list != nullptr); }
+  /**
+   * Counters related to last render() when batching is enabled.
+   */
+  inline DrawList::stats_t get_draw_stats() const noexcept(true)
+  { return (m_draw_list != nullptr)?m_draw_list->get_stats():DrawList::stats_t{}; }
+  /**
+   * Widgets drawn and skipped, since outside the layer area, by last render().
+   */
+  constexpr const cull_stats_t& get_cull_stats() const noexcept(true)
+  { return m_cull_stats; }
+  
 /// Implements WindowEvents
 protected:
   
@@ -108,6 +130,8 @@ protected:
   virtual void_t  on_unicode_char( Window* pWindow, uint_t iCodePoint ) noexcept(true) override;
   
 private:
+  std::unique_ptr<DrawList>   m_draw_list;
+  cull_stats_t                m_cull_stats;
   
 };
 
@@ -0,0 +1,226 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_TILE_MAP_LAYER_H
+#define URE_TILE_MAP_LAYER_H
+
+#include "ure_common_defs.h"
+#include "ure_texture_loader.h"
+#include "widgets/ure_layer.h"
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ure {
+
+namespace widgets {
+
+/**
+ * Layer showing raster tiles of a slippy map, with z/x/y addressing and Web Mercator
+ * projection as used by OpenStreetMap. Tiles covering the layer area around the current 
+ * center and zoom are loaded with a TextureLoader, nearest to the center first, together 
+ * with a ring of tiles around the view. While a tile is loading the nearest resident 
+ * ancestor is drawn upscaled in its place. Resident tiles are kept in a LRU cache with
+ * a fixed number of entries, so memory is bounded whatever the user does.
+ * Tiles that fail to load are requested again after a delay that doubles with each failure.
+ * Dragging with left button pans the map and mouse wheel changes the zoom.
+ */
+class TileMapLayer : public Layer
+{
+public:
+  static constexpr uint32_t  k_tile_size          = 256;
+  static constexpr uint32_t  k_max_zoom           = 19;
+  static constexpr uint32_t  k_default_max_tiles  = 256;
+  static constexpr uint32_t  k_max_ancestors      = 6;      /* levels searched for a fallback tile */
+  static constexpr uint32_t  k_upload_time_us     = 2000;   /* time spent uploading tiles each frame */
+  static constexpr uint32_t  k_retry_min_ms       = 1000;   /* delay before loading a failed tile again */
+  static constexpr uint32_t  k_retry_max_ms       = 60000;  /* delay doubles with each failure up to this */
+
+  /***/
+  struct tile_id_t {
+    uint32_t    z;
+    uint32_t    x;
+    uint32_t    y;
+
+    /***/
+    constexpr uint64_t  key() const noexcept(true)
+    { return ( uint64_t(z) << 58 ) | ( uint64_t(x) << 29 ) | uint64_t(y); }
+    /***/
+    constexpr tile_id_t parent() const noexcept(true)
+    { return tile_id_t{ z - 1, x / 2, y / 2 }; }
+  };
+
+  /***/
+  struct stats_t {
+    uint32_t    visible;          /* tiles covering the layer area             */
+    uint32_t    resident;         /* visible tiles drawn with their own image  */
+    uint32_t    fallback;         /* visible tiles drawn with an ancestor      */
+    uint32_t    cached;           /* tiles in the cache, loaded or loading     */
+    uint32_t    evicted;          /* tiles removed from the cache since reset  */
+  };
+
+  /**
+   * \param url tiles url with {z}, {x} and {y} placeholders, 
+   *            e.g. "https://tile.openstreetmap.org/{z}/{x}/{y}.png".
+   */
+  TileMapLayer( ViewPort& rViewPort, const std::string& url ) noexcept(true);
+  /***/
+  virtual ~TileMapLayer() noexcept(true);
+
+  /**
+   * Center of the view as longitude and latitude in degrees.
+   */
+  void_t              set_center( double_t lon, double_t lat ) noexcept(true);
+  /***/
+  void_t              get_center( double_t& lon, double_t& lat ) const noexcept(true);
+  /**
+   * Fractional zoom, tiles of the integer level below are scaled up to fill the gap.
+   */
+  void_t              set_zoom( double_t zoom ) noexcept(true);
+  /***/
+  constexpr double_t  get_zoom() const noexcept(true)
+  { return m_zoom; }
+  /**
+   * Move the view by \param dx, \param dy pixels.
+   */
+  void_t              pan( double_t dx, double_t dy ) noexcept(true);
+
+  /**
+   * Maximum number of tiles kept in the cache, at least visible and prefetched tiles are kept.
+   */
+  void_t              set_max_tiles( uint32_t tiles ) noexcept(true);
+  /***/
+  constexpr uint32_t  get_max_tiles() const noexcept(true)
+  { return m_max_tiles; }
+  /**
+   * Number of tiles loaded around the visible ones, 0 to disable prefetching.
+   */
+  constexpr void_t    set_prefetch( uint32_t ring ) noexcept(true)
+  { m_prefetch = ring; m_view_changed = true; }
+
+  /**
+   * Return true when a failed tile is due to be loaded again, that happens on next frame;
+   * applications that skip frames while nothing changes must check it.
+   */
+  bool_t              is_retry_due() const noexcept(true)
+  { return ( m_next_retry != clock_t::time_point::max() ) && ( m_next_retry <= clock_t::now() ); }
+
+  /***/
+  inline TextureLoader&  get_loader() noexcept(true)
+  { return m_loader; }
+  /***/
+  constexpr const stats_t& get_stats() const noexcept(true)
+  { return m_stats; }
+  /***/
+  constexpr void_t    reset_stats() noexcept(true)
+  { m_stats.evicted = 0; }
+
+protected:
+  /**
+   * Upload tiles decoded in the meantime and, if something changed, update tiles to be drawn.
+   */
+  virtual void_t  on_widget_begin_drawing( const Recti& rect ) noexcept(true) override;
+  /***/
+  virtual bool_t  on_widget_draw( const Recti& rect ) noexcept(true) override;
+  /***/
+  virtual void_t  on_widget_size_changed( const Size& size ) noexcept(true) override;
+
+  /***/
+  virtual void_t  on_mouse_button_pressed( Window* pWindow, mouse_button_t button, int_t mods ) noexcept(true) override;
+  /***/
+  virtual void_t  on_mouse_button_released( Window* pWindow, mouse_button_t button, int_t mods ) noexcept(true) override;
+  /***/
+  virtual void_t  on_mouse_move( Window* pWindow, double_t dPosX, double_t dPosY ) noexcept(true) override;
+  /***/
+  virtual void_t  on_mouse_scroll( Window* pWindow, double_t dOffsetX, double_t dOffsetY ) noexcept(true) override;
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  /***/
+  struct tile_t {
+    TextureLoader::handle_t       handle;
+    int32_t                       priority;
+    std::list<uint64_t>::iterator lru;
+    uint64_t                      frame;        /* last frame the tile was needed */
+    clock_t::time_point           retry_at;     /* next attempt after a failure, zero when not failed */
+    uint32_t                      failures;
+  };
+
+  /***/
+  struct draw_t {
+    VertexSlab::quad_t            quad;
+    std::shared_ptr<Texture>      texture;
+  };
+
+  /**
+   * Compute tiles covering the view, request missing ones and rebuild quads.
+   */
+  void_t              update_view() noexcept(true);
+  /**
+   * Return tile from the cache, requesting it with \param priority if not present.
+   */
+  tile_t*             request( const tile_id_t& id, int32_t priority ) noexcept(true);
+  /**
+   * Return nearest resident ancestor of \param id, with its level distance in \param levels.
+   */
+  tile_t*             find_ancestor( const tile_id_t& id, uint32_t& levels ) noexcept(true);
+  /**
+   * Release least recently used tiles not needed by current frame.
+   */
+  void_t              evict() noexcept(true);
+  /***/
+  std::string         get_name( const tile_id_t& id ) const noexcept(true);
+  /***/
+  std::string         get_url( const tile_id_t& id ) const noexcept(true);
+  /***/
+  void_t              _releaseQuads( std::size_t count ) noexcept(true);
+
+private:
+  const std::string                       m_url;
+  TextureLoader                           m_loader;
+  double_t                                m_center_x;        /* Web Mercator, [0,1) from left   */
+  double_t                                m_center_y;        /* Web Mercator, [0,1) from top    */
+  double_t                                m_zoom;
+  uint32_t                                m_prefetch;
+  uint32_t                                m_max_tiles;
+  bool_t                                  m_view_changed;
+  uint64_t                                m_frame;
+  clock_t::time_point                     m_next_retry;      /* earliest retry_at, max when none */
+  std::unordered_map<uint64_t, tile_t>    m_tiles;
+  std::list<uint64_t>                     m_lru;             /* front is the most recently used */
+  std::vector<draw_t>                     m_vDraws;
+  stats_t                                 m_stats;
+  bool_t                                  m_dragging;
+  double_t                                m_mouse_x;
+  double_t                                m_mouse_y;
+};
+
+} /* namespace widgets */ 
+
+} /* namespace ure */ 
+
+#endif // URE_TILE_MAP_LAYER_H
@@ -29,6 +29,8 @@
 #include "ure_position.h"
 #include "ure_size.h"
 #include "ure_rect.h"
+#include "ure_bounds.h"
+#include "ure_render_target.h"
 
 #include <sigc++/sigc++.h>
 
@@ -89,8 +91,7 @@ public:
   /**
    * Set if layer is visible or not. When not visible render is disabled.
    */
-  inline constexpr void_t      set_visible( bool_t visible ) noexcept(true)
-  { m_visible = visible; }  
+  void_t                       set_visible( bool_t visible ) noexcept(true);
   
   /**
    * @return TRUE if widget is enabled, so it will be receive envents
@@ -142,15 +143,41 @@ public:
     rect.right = get_size().width; rect.bottom = get_size().height;
   }
   
+  /**
+   * @return true when the widget has an area and it does not intersect \param rect, 
+   *         that has the same layout of get_client_area() in vertices coordinates,
+   *         so relative to parent origin. Children are expected to be inside their
+   *         parent, so the whole subtree can be skipped.
+   */
+  inline bool_t                is_outside( const Recti& rect ) const noexcept(true)
+  {
+    if ( ( m_size.width <= 0 ) || ( m_size.height <= 0 ) )
+      return false;
+
+    const Position origin = _get_origin();
+
+    return ( origin.x >= rect.left + rect.right  ) || ( origin.x + m_size.width  <= rect.left ) ||
+           ( origin.y >= rect.top  + rect.bottom ) || ( origin.y + m_size.height <= rect.top  );
+  }
+
+  /**
+   * When enabled, children and everything drawn by the widget are clipped to the 
+   * widget area, and children outside the area are not drawn at all.
+   * Clipping uses the scissor test while the widget is axis aligned on screen and the 
+   * stencil buffer otherwise, see Canvas::push_clip(). Default is disabled for widgets
+   * and enabled for layers.
+   */
+  inline constexpr void_t      set_clipping( bool_t bEnable ) noexcept(true)
+  { m_clipping = bEnable; }
+  /***/
+  inline constexpr bool_t      is_clipping() const noexcept(true)
+  { return m_clipping; }
+
   /***/    
   inline constexpr bool_t      has_background() const noexcept(true)
   { return (m_eBackground!=NoBackground); }
   /***/
-  inline constexpr void_t      set_background( const glm::vec4& cr ) noexcept(true)
-  {  
-    m_crBackground = cr;     
-    m_eBackground  = SolidColor;
-  }
+  void_t                       set_background( const glm::vec4& cr ) noexcept(true);
   /**
    * @bo  usually image loaded from files needs a vertival flip in order to be shown as original.
    *      The reason is related to format type used to store image where images are store starting
@@ -163,8 +190,44 @@ public:
   inline std::shared_ptr<Texture> get_bk_image() const noexcept(true)
   { return m_bkg_texture;   }
   
+  /**
+   * When enabled, the widget and its children are rendered once into a texture
+   * that is then drawn as a single quad, until invalidate() is called on the
+   * widget or on any widget in its subtree. Position, size, background, visibility,
+   * children, focus and label changes call it already; specialized widgets that 
+   * draw something else must call it each time their content changes.
+   * Since the texture is in layer coordinates, it is shared by all nodes that
+   * render the same Layer. Translucent content is blended twice, so it will
+   * look more transparent than without cache.
+   * Default is disabled.
+   */
+  void_t                    set_cached( bool_t bEnable ) noexcept(true);
   /***/
+  inline constexpr bool_t   is_cached() const noexcept(true)
+  { return m_cached; }
+  /**
+   * Mark the area of the widget as changed, so that it will be rendered again on
+   * next draw() in the cache of the widget and of all its ancestors. Widgets 
+   * without size damage the whole cache.
+   */
+  void_t                    invalidate() noexcept(true);
+  /**
+   * Counter incremented by each invalidate() on any widget, so that view ports
+   * can check if something changed since last frame.
+   */
+  static inline uint32_t    get_changes() noexcept(true)
+  { return s_changes; }
+
+  /**
+   * Children outside \param rect are skipped.
+   */
   bool_t                    draw( const glm::mat4& mvp, const Recti& rect ) noexcept(true);
+
+  /**
+   * Set counters updated by draw(), same as Canvas::set_draw_list().
+   * @return previous counters.
+   */
+  static cull_stats_t*      set_cull_counters( cull_stats_t* pStats ) noexcept(true);
   
 public:
   using OnClick_Signal = sigc::signal<void_t(Widget*)>;
@@ -232,8 +295,31 @@ protected:
   
 private:
 
+  /**
+   * Draw widget and children without cache.
+   */
+  bool_t _draw( const glm::mat4& mvp, const Recti& rect ) noexcept;
+  /**
+   * Render the subtree into the cache texture and update the quad used to draw it.
+   */
+  bool_t _updateCache() noexcept;
+  /***/
+  void_t _releaseCache() noexcept;
+  /**
+   * Add area to the region that will be rendered again in the cache,
+   * same layout of get_client_area().
+   */
+  void_t _damage( const Recti& area ) noexcept;
+  /**
+   * Top left corner used for vertices, that is position plus parent position.
+   */
+  Position _get_origin() const noexcept;
   /***/
   void_t _updateBkVertices() noexcept;
+  /**
+   * Write background vertices, texture coordinates and color to the VertexSlab.
+   */
+  void_t _updateBkQuad() noexcept;
 
 protected:
   using Key_Signal = sigc::signal<void_t(Window*, Layer*, key_t, int_t, word_t)>;
@@ -263,7 +349,17 @@ private:
   BackgroundType                m_eBackground;
   glm::vec4                     m_crBackground;
   std::shared_ptr<ure::Texture> m_bkg_texture;
+  VertexSlab::quad_t            m_bkQuad;
+  bool_t                        m_clipping;
+  bool_t                        m_cached;
+  bool_t                        m_cache_valid;
+  std::unique_ptr<RenderTarget> m_cache;
+  VertexSlab::quad_t            m_cacheQuad;
+  Recti                         m_damage;
   
+  static cull_stats_t*          s_pCullStats;
+  static uint32_t               s_changes;
+
 protected:
   std::vector<glm::vec2>    m_bkVertices;
   std::vector<glm::vec2>    m_bkTexCoord;  
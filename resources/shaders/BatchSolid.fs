@@ -0,0 +1,10 @@
+#version 100
+
+precision mediump float;
+
+varying   vec4  v_v4Color;
+
+void main()
+{
+  gl_FragColor = v_v4Color;
+}
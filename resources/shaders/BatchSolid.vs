@@ -0,0 +1,16 @@
+#version 100
+
+precision mediump float;
+
+uniform   mat4  u_m4MVP;
+uniform   float u_fThickness;
+attribute vec2  a_v2Point;
+attribute vec4  a_v4Color;
+varying   vec4  v_v4Color;
+
+void main()
+{
+  gl_PointSize = u_fThickness;
+  gl_Position  = u_m4MVP * vec4( a_v2Point, 0, 1.0 );
+  v_v4Color    = a_v4Color;
+}
@@ -0,0 +1,12 @@
+#version 100
+
+precision mediump float;
+
+varying   vec2      v_v2TexCoord;
+varying   vec4      v_v4Color;
+uniform   sampler2D u_2dTexture;
+
+void main()
+{
+  gl_FragColor = vec4(1, 1, 1, texture2D(u_2dTexture, v_v2TexCoord).a) * v_v4Color;
+}
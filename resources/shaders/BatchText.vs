@@ -0,0 +1,17 @@
+#version 100
+
+precision mediump float;
+
+uniform   mat4 u_m4MVP;
+attribute vec2 a_v2Point;
+attribute vec2 a_v2TexCoord;
+attribute vec4 a_v4Color;
+varying   vec2 v_v2TexCoord;
+varying   vec4 v_v4Color;
+
+void main()
+{
+  gl_Position  = u_m4MVP * vec4( a_v2Point, 0.0, 1.0 );
+  v_v2TexCoord = a_v2TexCoord;
+  v_v4Color    = a_v4Color;
+}
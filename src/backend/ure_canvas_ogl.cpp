@@ -22,12 +22,71 @@
  *************************************************************************************************/
 
 #include "ure_canvas.h"
+#include "ure_draw_list.h"
 #include "ure_programs_collector.h"
+#include "ure_state_cache.h"
 
-#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace ure {
 
+DrawList*       Canvas::s_pDrawList = nullptr;
+Canvas::clips_t Canvas::s_vClips;
+
+/**
+ * Call \param draw with vertices and texture coordinates of each glyph in \param text,
+ * placed inside the quad given by \param vertices and \param texCoord, where texture
+ * coordinates span the whole text. So glyphs taken from an atlas sample only their own 
+ * area instead of the whole page. Quad is expected to be a parallelogram.
+ */
+template<typename draw_t>
+static void_t for_each_glyph( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, draw_t&& draw ) noexcept
+{
+  const auto& glyphs = text.get_glyphs();
+  const Size& size   = text.get_size();
+
+  // Text with a dedicated texture is a single glyph covering the whole texture.
+  if ( ( glyphs.size() == 1 ) && ( glyphs[0].uv_min == glm::vec2( 0.0f ) ) && ( glyphs[0].uv_max == glm::vec2( 1.0f ) ) )
+  {
+    draw( vertices, texCoord );
+    return;
+  }
+
+  if ( ( vertices.size() < 3 ) || ( texCoord.size() < 3 ) || ( size.width <= 0 ) || ( size.height <= 0 ) )
+    return;
+
+  // Affine map from text coordinates to vertices, solved on the first three corners.
+  const glm::vec2 t1  = texCoord[1] - texCoord[0];
+  const glm::vec2 t2  = texCoord[2] - texCoord[0];
+  const glm::vec2 v1  = vertices[1] - vertices[0];
+  const glm::vec2 v2  = vertices[2] - vertices[0];
+  const float_t   det = t1.x * t2.y - t2.x * t1.y;
+  if ( std::abs( det ) < 1e-6f )
+    return;
+
+  auto map = [&]( float_t x, float_t y )
+  {
+    const glm::vec2 t( x / (float_t)size.width - texCoord[0].x, y / (float_t)size.height - texCoord[0].y );
+    const float_t   a = (  t2.y * t.x - t2.x * t.y ) / det;
+    const float_t   b = ( -t1.y * t.x + t1.x * t.y ) / det;
+    return glm::vec2( vertices[0].x + a * v1.x + b * v2.x, vertices[0].y + a * v1.y + b * v2.y );
+  };
+
+  std::vector<glm::vec2> quad( 4 );
+  std::vector<glm::vec2> uv( 4 );
+
+  for ( const Text::glyph_t& glyph : glyphs )
+  {
+    quad[0] = map( glyph.min.x, glyph.min.y );  uv[0] = glm::vec2( glyph.uv_min.x, glyph.uv_min.y );
+    quad[1] = map( glyph.max.x, glyph.min.y );  uv[1] = glm::vec2( glyph.uv_max.x, glyph.uv_min.y );
+    quad[2] = map( glyph.min.x, glyph.max.y );  uv[2] = glm::vec2( glyph.uv_min.x, glyph.uv_max.y );
+    quad[3] = map( glyph.max.x, glyph.max.y );  uv[3] = glm::vec2( glyph.uv_max.x, glyph.uv_max.y );
+
+    draw( quad, uv );
+  }
+}
+
 Canvas::Canvas() noexcept
 {
   m_mvp = glm::mat4( 1.0f );
@@ -37,28 +96,281 @@ Canvas::~Canvas() noexcept
 {
   
 }
+
+DrawList* Canvas::set_draw_list( DrawList* pDrawList ) noexcept
+{
+  DrawList* pPrevious = s_pDrawList;
+  s_pDrawList = pDrawList;
+  return pPrevious;
+}
+
+bool_t  Canvas::push_clip( const Recti& rect ) noexcept
+{
+  if ( ( rect.right <= 0 ) || ( rect.bottom <= 0 ) )
+    return false;
+
+  const clip_t* pTop = s_vClips.empty()?nullptr:&s_vClips.back();
+
+  clip_t clip{ false, {}, 0, false, m_mvp, {} };
+  if ( pTop != nullptr )
+  {
+    clip.scissor = pTop->scissor;
+    clip.box     = pTop->box;
+    clip.stencil = pTop->stencil;
+  }
+
+  const float_t x0 = (float_t)rect.left;
+  const float_t y0 = (float_t)rect.top;
+  const float_t x1 = (float_t)(rect.left + rect.right);
+  const float_t y1 = (float_t)(rect.top  + rect.bottom);
+
+  // Corners in window coordinates, same order used for triangle strips.
+  int_t    vx, vy;
+  sizei_t  vw, vh;
+  StateCache::get_current().get_viewport( vx, vy, vw, vh );
+
+  const glm::vec2 corners[4] = { glm::vec2( x0, y1 ), glm::vec2( x1, y1 ), glm::vec2( x0, y0 ), glm::vec2( x1, y0 ) };
+  glm::vec2       screen[4];
+  bool_t          bAligned = true;
+
+  for ( int_t ndx = 0; ndx < 4; ++ndx )
+  {
+    const glm::vec4 c = m_mvp * glm::vec4( corners[ndx].x, corners[ndx].y, 0.0f, 1.0f );
+    if ( c.w <= 0.0f )
+    {
+      bAligned = false;
+      break;
+    }
+
+    screen[ndx] = glm::vec2( (float_t)vx + ( c.x / c.w + 1.0f ) * 0.5f * (float_t)vw,
+                             (float_t)vy + ( c.y / c.w + 1.0f ) * 0.5f * (float_t)vh );
+  }
+
+  // Rotations multiple of 90 degrees keep the rect axis aligned as well.
+  constexpr float_t k_epsilon = 0.5f;
+  auto _near = []( float_t a, float_t b ) { return std::abs( a - b ) < k_epsilon; };
+
+  bAligned = bAligned && 
+             ( ( _near( screen[0].y, screen[1].y ) && _near( screen[2].y, screen[3].y ) && 
+                 _near( screen[0].x, screen[2].x ) && _near( screen[1].x, screen[3].x ) ) ||
+               ( _near( screen[0].x, screen[1].x ) && _near( screen[2].x, screen[3].x ) && 
+                 _near( screen[0].y, screen[2].y ) && _near( screen[1].y, screen[3].y ) ) );
+
+  if ( bAligned )
+  {
+    int_t left   = (int_t)std::floor( std::min( { screen[0].x, screen[1].x, screen[2].x, screen[3].x } ) + k_epsilon );
+    int_t bottom = (int_t)std::floor( std::min( { screen[0].y, screen[1].y, screen[2].y, screen[3].y } ) + k_epsilon );
+    int_t right  = (int_t)std::floor( std::max( { screen[0].x, screen[1].x, screen[2].x, screen[3].x } ) + k_epsilon );
+    int_t top    = (int_t)std::floor( std::max( { screen[0].y, screen[1].y, screen[2].y, screen[3].y } ) + k_epsilon );
+
+    if ( clip.scissor )
+    {
+      left   = std::max( left  , clip.box[0] );
+      bottom = std::max( bottom, clip.box[1] );
+      right  = std::min( right , clip.box[0] + clip.box[2] );
+      top    = std::min( top   , clip.box[1] + clip.box[3] );
+    }
+
+    if ( ( right <= left ) || ( top <= bottom ) )
+      return false;
+
+    flush_draw_list();
+
+    clip.scissor = true;
+    clip.box     = { left, bottom, right - left, top - bottom };
+
+    s_vClips.push_back( std::move(clip) );
+    apply_clip( &s_vClips.back() );
+
+    return true;
+  }
+
+  flush_draw_list();
+
+  // Pixels inside all previous stencil clips are incremented, so that they will match the new level.
+  StateCache& state = StateCache::get_current();
+
+  clip.stencil     = clip.stencil + 1;
+  clip.own_stencil = true;
+  clip.vertices.assign( std::begin(corners), std::end(corners) );
+
+  apply_clip( pTop );
+
+  state.enable      ( GL_STENCIL_TEST );
+  state.stencil_func( GL_EQUAL, (int_t)clip.stencil - 1, 0xFF );
+  state.stencil_op  ( GL_KEEP, GL_KEEP, GL_INCR );
+  state.color_mask  ( false, false, false, false );
+
+  draw( GL_TRIANGLE_STRIP, clip.vertices, glm::vec4( 1.0f ), 1.0f );
+
+  state.color_mask  ( true, true, true, true );
+
+  s_vClips.push_back( std::move(clip) );
+  apply_clip( &s_vClips.back() );
+
+  return true;
+}
+
+bool_t  Canvas::push_scissor( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept
+{
+  const clip_t* pTop = s_vClips.empty()?nullptr:&s_vClips.back();
+
+  clip_t clip{ true, { x, y, width, height }, 0, false, glm::mat4( 1.0f ), {} };
+  if ( pTop != nullptr )
+  {
+    clip.stencil = pTop->stencil;
+
+    if ( pTop->scissor )
+    {
+      const int_t left   = std::max( x         , pTop->box[0] );
+      const int_t bottom = std::max( y         , pTop->box[1] );
+      const int_t right  = std::min( x + width , pTop->box[0] + pTop->box[2] );
+      const int_t top    = std::min( y + height, pTop->box[1] + pTop->box[3] );
+
+      clip.box = { left, bottom, right - left, top - bottom };
+    }
+  }
+
+  if ( ( clip.box[2] <= 0 ) || ( clip.box[3] <= 0 ) )
+    return false;
+
+  flush_draw_list();
+
+  s_vClips.push_back( std::move(clip) );
+  apply_clip( &s_vClips.back() );
+
+  return true;
+}
+
+void_t  Canvas::pop_clip() noexcept
+{
+  if ( s_vClips.empty() )
+    return;
+
+  flush_draw_list();
+
+  const clip_t& top = s_vClips.back();
+
+  // Pixels incremented by push_clip() are restored to previous level.
+  if ( top.own_stencil )
+  {
+    StateCache& state = StateCache::get_current();
+
+    const glm::mat4 mvp = m_mvp;
+    m_mvp = top.mvp;
+
+    state.stencil_op( GL_KEEP, GL_KEEP, GL_DECR );
+    state.color_mask( false, false, false, false );
+
+    draw( GL_TRIANGLE_STRIP, top.vertices, glm::vec4( 1.0f ), 1.0f );
+
+    state.color_mask( true, true, true, true );
+
+    m_mvp = mvp;
+  }
+
+  s_vClips.pop_back();
+
+  apply_clip( s_vClips.empty()?nullptr:&s_vClips.back() );
+}
+
+Canvas::clips_t  Canvas::suspend_clips() noexcept
+{
+  flush_draw_list();
+
+  clips_t clips = std::move( s_vClips );
+  s_vClips.clear();
+
+  apply_clip( nullptr );
+
+  return clips;
+}
+
+void_t  Canvas::resume_clips( clips_t&& clips ) noexcept
+{
+  flush_draw_list();
+
+  s_vClips = std::move( clips );
+
+  apply_clip( s_vClips.empty()?nullptr:&s_vClips.back() );
+}
+
+void_t  Canvas::flush_draw_list() noexcept
+{
+  if ( s_pDrawList != nullptr )
+    s_pDrawList->flush();
+}
+
+void_t  Canvas::apply_clip( const clip_t* pClip ) noexcept
+{
+  StateCache& state = StateCache::get_current();
+
+  if ( ( pClip != nullptr ) && pClip->scissor )
+  {
+    state.enable ( GL_SCISSOR_TEST );
+    state.scissor( pClip->box[0], pClip->box[1], pClip->box[2], pClip->box[3] );
+  }
+  else
+  {
+    state.disable( GL_SCISSOR_TEST );
+  }
+
+  if ( ( pClip != nullptr ) && ( pClip->stencil > 0 ) )
+  {
+    state.enable      ( GL_STENCIL_TEST );
+    state.stencil_func( GL_EQUAL, (int_t)pClip->stencil, 0xFF );
+    state.stencil_op  ( GL_KEEP, GL_KEEP, GL_KEEP );
+  }
+  else
+  {
+    state.disable( GL_STENCIL_TEST );
+  }
+}
   
 void_t  Canvas::draw_points( const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept
 {
+  if ( s_pDrawList != nullptr )
+  {
+    if ( s_pDrawList->add_points( m_mvp, points, color, fThickness ) )
+      return;
+
+    // too large for the list, pending commands go first in order to keep layering
+    s_pDrawList->flush();
+  }
+
 #if defined(_NV_CARD_)  
 // Values are not part of ES Specs but still supported on NV cards
 /* Shaders */
 #define GL_VERTEX_PROGRAM_POINT_SIZE      0x8642
 #define GL_VERTEX_ATTRIB_ARRAY_NORMALIZED 0x886A  
 
-  glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+  StateCache::get_current().enable( GL_VERTEX_PROGRAM_POINT_SIZE );
 #endif
   
+  StateCache::get_current().disable( GL_BLEND );
+
   draw( GL_POINTS, points, color, fThickness );
   
 #if defined(_NV_CARD_)  
-  glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+  StateCache::get_current().disable( GL_VERTEX_PROGRAM_POINT_SIZE );
 #endif
 }
 
 void_t  Canvas::draw_lines( const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept
 {
-  glLineWidth( fThickness );
+  if ( s_pDrawList != nullptr )
+  {
+    if ( s_pDrawList->add_lines( m_mvp, points, color, fThickness ) )
+      return;
+
+    // too large for the list, pending commands go first in order to keep layering
+    s_pDrawList->flush();
+  }
+
+  StateCache& state = StateCache::get_current();
+
+  state.disable   ( GL_BLEND );
+  state.line_width( fThickness );
   
   draw( GL_LINE_STRIP, points, color, fThickness );
 }
@@ -68,17 +380,34 @@ void_t  Canvas::draw_rect( const std::vector<glm::vec2>& points, const glm::vec4
   if ( points.size() != 4 )
     return;
   
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+  if ( s_pDrawList != nullptr )
+  {
+    s_pDrawList->add_rect( m_mvp, points, color );
+    return;
+  }
+
+  StateCache& state = StateCache::get_current();
   
-  draw( GL_TRIANGLE_STRIP, points, color, 1.0f );
+  state.enable( GL_BLEND );
+  state.blend_alpha();
   
-  glDisable(GL_BLEND);
+  draw( GL_TRIANGLE_STRIP, points, color, 1.0f );
 }
 
 void  Canvas::draw_rect( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, Texture& texture, int_t tws, int_t twt ) noexcept
 {
-  Program* pProgram = ProgramsCollector::get_instance()->find( "DefaultTexture" );
+  if ( s_pDrawList != nullptr )
+  {
+    if ( s_pDrawList->add_rect( m_mvp, vertices, texCoord, texture, tws, twt ) )
+      return;
+
+    // too large for the list, pending commands go first in order to keep layering
+    s_pDrawList->flush();
+  }
+
+  static program_ref_t s_program( "DefaultTexture" );
+
+  Program* pProgram = ProgramsCollector::get_instance()->find( s_program );
   if ( pProgram == nullptr )
   {
     std::vector< std::pair<int,std::string> >  attributes;
@@ -94,23 +423,67 @@ void  Canvas::draw_rect( const std::vector<glm::vec2>& vertices, const std::vect
   
   pProgram->use();
   
-  // Get the uniform location
-  int_t MatrixID  = glGetUniformLocation( pProgram->get_id(), "u_m4MVP"     );
-  int_t TextureID = glGetUniformLocation( pProgram->get_id(), "u_2dTexture" );
-  
-  glUniformMatrix4fv(MatrixID, 1, GL_FALSE, glm::value_ptr(m_mvp) );
+  pProgram->set_uniform( Program::uniform_t::eMVP, m_mvp );
   
-  texture.render( vertices, texCoord, true, GL_TEXTURE_2D, 0, TextureID, 0, 1, tws, twt );
+  texture.render( vertices, texCoord, true, GL_TEXTURE_2D, 0, pProgram->get_uniform_location( Program::uniform_t::eTexture ), 0, 1, tws, twt );
 }
   
+void  Canvas::draw_rect( VertexSlab::quad_t quad ) noexcept
+{
+  if ( s_pDrawList != nullptr )
+  {
+    s_pDrawList->add_rect( m_mvp, quad );
+    return;
+  }
+
+  static program_ref_t s_program( "BatchSolid" );
+
+  draw( &quad, 1, s_program, nullptr, URE_CLAMP_TO_EDGE, URE_CLAMP_TO_EDGE );
+}
+
+void  Canvas::draw_rect( VertexSlab::quad_t quad, Texture& texture, int_t tws, int_t twt ) noexcept
+{
+  if ( s_pDrawList != nullptr )
+  {
+    s_pDrawList->add_rect( m_mvp, quad, texture, tws, twt );
+    return;
+  }
+
+  static program_ref_t s_program( "BatchTexture" );
+
+  draw( &quad, 1, s_program, &texture, tws, twt );
+}
+
+void  Canvas::draw_text( const std::vector<VertexSlab::quad_t>& quads, const Text& text, int_t tws, int_t twt ) noexcept
+{
+  if ( s_pDrawList != nullptr )
+  {
+    for ( auto quad : quads )
+      s_pDrawList->add_text( m_mvp, quad, text, tws, twt );
+    return;
+  }
+
+  static program_ref_t s_program( "BatchText" );
+
+  draw( quads.data(), quads.size(), s_program, text.get_texture(), tws, twt );
+}
+
 void  Canvas::draw_text( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept
 {
-  draw( vertices, texCoord, text, tws, twt );
+  if ( s_pDrawList != nullptr )
+  {
+    for_each_glyph( vertices, texCoord, text, [&]( const auto& quad, const auto& uv ) { s_pDrawList->add_text( m_mvp, quad, uv, text, tws, twt ); } );
+    return;
+  }
+
+  for_each_glyph( vertices, texCoord, text, [&]( const auto& quad, const auto& uv ) { draw( quad, uv, text, tws, twt ); } );
 }
 
 void  Canvas::draw( enum_t mode, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept
 {
-  Program* pProgram = ProgramsCollector::get_instance()->find( "DefaultSolid" );
+  static program_ref_t s_program( "DefaultSolid" );
+
+  Program* pProgram = ProgramsCollector::get_instance()->find( s_program );
   if ( pProgram == nullptr )
   {
     std::vector< std::pair<int,std::string> >  attributes;
@@ -125,14 +498,9 @@ void  Canvas::draw( enum_t mode, const std::vector<glm::vec2>& points, const glm
   
   pProgram->use();
     
-  // Get the uniform location
-  int_t MatrixID    = glGetUniformLocation( pProgram->get_id(), "u_m4MVP"      );
-  int_t ThicknessID = glGetUniformLocation( pProgram->get_id(), "u_fThickness" );
-  int_t ColorID     = glGetUniformLocation( pProgram->get_id(), "u_v4Color"    );
-  
-  glUniformMatrix4fv(MatrixID   , 1, GL_FALSE, glm::value_ptr(m_mvp) );
-  glUniform1f       (ThicknessID, fThickness                         );
-  glUniform4fv      (ColorID    , 1, glm::value_ptr(color)           );  
+  pProgram->set_uniform( Program::uniform_t::eMVP      , m_mvp      );
+  pProgram->set_uniform( Program::uniform_t::eThickness, fThickness );
+  pProgram->set_uniform( Program::uniform_t::eColor    , color      );
 
   glEnableVertexAttribArray(0);
   glVertexAttribPointer    (0, 2, GL_FLOAT, GL_FALSE, 0, points.data() );
@@ -144,7 +512,9 @@ void  Canvas::draw( enum_t mode, const std::vector<glm::vec2>& points, const glm
 
 void   Canvas::draw( const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept
 {
-  Program* pProgram = ProgramsCollector::get_instance()->find( "DefaultText" );
+  static program_ref_t s_program( "DefaultText" );
+
+  Program* pProgram = ProgramsCollector::get_instance()->find( s_program );
   if ( pProgram == nullptr )
   {
     std::vector< std::pair<int,std::string> >  attributes;
@@ -160,15 +530,76 @@ void   Canvas::draw( const std::vector<glm::vec2>& vertices, const std::vector<g
   
   pProgram->use();
   
-  // Get the uniform location
-  int_t MatrixID  = glGetUniformLocation( pProgram->get_id(), "u_m4MVP"     );
-  int_t TextureID = glGetUniformLocation( pProgram->get_id(), "u_2dTexture" );
-  int_t ColorID   = glGetUniformLocation( pProgram->get_id(), "u_v4Color"   );
+  pProgram->set_uniform( Program::uniform_t::eMVP  , m_mvp            );
+  pProgram->set_uniform( Program::uniform_t::eColor, text.get_color() );
+  
+  text.get_texture()->render( vertices, texCoord, true, GL_TEXTURE_2D, 0, pProgram->get_uniform_location( Program::uniform_t::eTexture ), 0, 1, tws, twt );
+}
+
+void   Canvas::draw( const VertexSlab::quad_t* pQuads, std::size_t count, program_ref_t& program, Texture* pTexture, int_t tws, int_t twt ) noexcept
+{
+  if ( ( VertexSlab::is_valid() == false ) || ( count == 0 ) )
+    return;
+
+  VertexSlab* pSlab = VertexSlab::get_instance();
+
+  Program* pProgram = ProgramsCollector::get_instance()->find( program );
+  if ( pProgram == nullptr )
+  {
+    std::vector< std::pair<int,std::string> >  attributes;
+  
+    attributes.push_back( std::pair<int,std::string>( 0, "a_v2Point"    ) );
+    attributes.push_back( std::pair<int,std::string>( 1, "a_v2TexCoord" ) );
+    attributes.push_back( std::pair<int,std::string>( 2, "a_v4Color"    ) );
+  
+    pProgram = ProgramsCollector::get_instance()->create( program.name, attributes );
+  }
+  
+  if ( pProgram == nullptr )
+    return;
+  
+  pProgram->use();
+  pProgram->set_uniform( Program::uniform_t::eMVP, m_mvp );
   
-  glUniformMatrix4fv(MatrixID, 1, GL_FALSE, glm::value_ptr(m_mvp) );
-  glUniform4fv      ( ColorID, 1, glm::value_ptr(text.get_color()) );  
+  StateCache& state = StateCache::get_current();
+
+  state.enable( GL_BLEND );
+  if ( ( pTexture != nullptr ) && pTexture->is_premultiplied() )
+    state.blend_premultiplied();
+  else
+    state.blend_alpha();
+
+  if ( pTexture != nullptr )
+  {
+    state.active_texture( 0 );
+    pTexture->bind( GL_TEXTURE_2D, 0, tws, twt );
+    pProgram->set_uniform( Program::uniform_t::eTexture, 0 );
+  }
+
+  // Page is bound again only when it changes between consecutive quads.
+  uint32_t page = VertexSlab::k_invalid_quad;
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    if ( pSlab->get_vertices( pQuads[i] ) == nullptr )
+      continue;
+
+    if ( VertexSlab::get_page( pQuads[i] ) != page )
+    {
+      page = VertexSlab::get_page( pQuads[i] );
+      if ( pSlab->bind( page ) == false )
+      {
+        page = VertexSlab::k_invalid_quad;
+        continue;
+      }
+    }
+
+    glDrawArrays( GL_TRIANGLE_STRIP, VertexSlab::get_first( pQuads[i] ), 4 );
+  }
   
-  text.get_texture()->render( vertices, texCoord, true, GL_TEXTURE_2D, 0, TextureID, 0, 1, tws, twt );
+  pSlab->unbind();
+
+  if ( pTexture != nullptr )
+    pTexture->unbind( GL_TEXTURE_2D );
 }
 
 }
@@ -0,0 +1,500 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_draw_list.h"
+#include "ure_programs_collector.h"
+#include "ure_state_cache.h"
+#include "ure_text.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(_NV_CARD_)  
+// Values are not part of ES Specs but still supported on NV cards
+# define GL_VERTEX_PROGRAM_POINT_SIZE      0x8642
+#endif
+
+namespace ure {
+
+/* Indices are 16 bits wide, so this is the max number of vertices in a single flush. */
+static constexpr std::size_t  k_max_vertices = std::numeric_limits<word_t>::max() + 1;
+/* Used to mark that neither the stream nor a slab page is bound. */
+static constexpr uint32_t     k_no_source    = std::numeric_limits<uint32_t>::max();
+
+std::size_t  DrawList::state_hash_t::operator()( const state_t& state ) const noexcept(true)
+{
+  uint32_t thickness = 0;
+  std::memcpy( &thickness, &state.thickness, sizeof(thickness) );
+
+  std::size_t _hash = std::hash<const void_t*>()( state.texture );
+  for ( uint64_t value : { uint64_t(state.mode), uint64_t(state.program), uint64_t(state.blend), uint64_t(thickness), 
+                           uint64_t(state.mvp), uint64_t(uint32_t(state.tws)), uint64_t(uint32_t(state.twt)), uint64_t(state.source) } )
+  {
+    _hash ^= std::hash<uint64_t>()( value ) + 0x9e3779b97f4a7c15ull + ( _hash << 6 ) + ( _hash >> 2 );
+  }
+  return _hash;
+}
+
+static Program* get_program( program_ref_t& ref ) noexcept(true)
+{
+  Program* pProgram = ProgramsCollector::get_instance()->find( ref );
+  if ( pProgram == nullptr )
+  {
+    std::vector< std::pair<int,std::string> >  attributes;
+  
+    attributes.push_back( std::pair<int,std::string>( 0, "a_v2Point"    ) );
+    attributes.push_back( std::pair<int,std::string>( 1, "a_v2TexCoord" ) );
+    attributes.push_back( std::pair<int,std::string>( 2, "a_v4Color"    ) );
+
+    pProgram = ProgramsCollector::get_instance()->create( ref.name, attributes );
+  }
+
+  return pProgram;
+}
+
+DrawList::DrawList() noexcept(true)
+  : m_vbo( 0 ), m_ibo( 0 ), m_stats{}
+{
+}
+
+DrawList::~DrawList() noexcept(true)
+{
+  StateCache* pState = StateCache::find_current();
+
+  if ( m_vbo != 0 )
+  {
+    glDeleteBuffers( 1, &m_vbo );
+    if ( pState != nullptr )
+      pState->deleted_buffer( m_vbo );
+  }
+  if ( m_ibo != 0 )
+  {
+    glDeleteBuffers( 1, &m_ibo );
+    if ( pState != nullptr )
+      pState->deleted_buffer( m_ibo );
+  }
+}
+
+bool_t  DrawList::add_points( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept(true)
+{
+  state_t state{ GL_POINTS, program_t::eSolid, nullptr, false, fThickness, 0, 0, 0, 0 };
+
+  return add( GL_POINTS, state, mvp, points, nullptr, color );
+}
+
+bool_t  DrawList::add_lines( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color, float_t fThickness ) noexcept(true)
+{
+  state_t state{ GL_LINES, program_t::eSolid, nullptr, false, fThickness, 0, 0, 0, 0 };
+
+  return add( GL_LINE_STRIP, state, mvp, points, nullptr, color );
+}
+
+void_t  DrawList::add_rect( const glm::mat4& mvp, const std::vector<glm::vec2>& points, const glm::vec4& color ) noexcept(true)
+{
+  if ( points.size() != 4 )
+    return;
+
+  state_t state{ GL_TRIANGLES, program_t::eSolid, nullptr, true, 1.0f, 0, 0, 0, 0 };
+
+  add( GL_TRIANGLE_STRIP, state, mvp, points, nullptr, color );
+}
+
+bool_t  DrawList::add_rect( const glm::mat4& mvp, const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, Texture& texture, int_t tws, int_t twt ) noexcept(true)
+{
+  state_t state{ GL_TRIANGLES, program_t::eTexture, &texture, true, 1.0f, 0, tws, twt, 0 };
+
+  return add( GL_TRIANGLE_STRIP, state, mvp, vertices, &texCoord, glm::vec4( 1.0f ) );
+}
+
+void_t  DrawList::add_text( const glm::mat4& mvp, const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, const Text& text, int_t tws, int_t twt ) noexcept(true)
+{
+  state_t state{ GL_TRIANGLES, program_t::eText, text.get_texture(), true, 1.0f, 0, tws, twt, 0 };
+
+  add( GL_TRIANGLE_STRIP, state, mvp, vertices, &texCoord, text.get_color() );
+}
+
+void_t  DrawList::add_rect( const glm::mat4& mvp, VertexSlab::quad_t quad ) noexcept(true)
+{
+  state_t state{ GL_TRIANGLES, program_t::eSolid, nullptr, true, 1.0f, 0, 0, 0, 0 };
+
+  add( state, mvp, quad );
+}
+
+void_t  DrawList::add_rect( const glm::mat4& mvp, VertexSlab::quad_t quad, Texture& texture, int_t tws, int_t twt ) noexcept(true)
+{
+  state_t state{ GL_TRIANGLES, program_t::eTexture, &texture, true, 1.0f, 0, tws, twt, 0 };
+
+  add( state, mvp, quad );
+}
+
+void_t  DrawList::add_text( const glm::mat4& mvp, VertexSlab::quad_t quad, const Text& text, int_t tws, int_t twt ) noexcept(true)
+{
+  state_t state{ GL_TRIANGLES, program_t::eText, text.get_texture(), true, 1.0f, 0, tws, twt, 0 };
+
+  add( state, mvp, quad );
+}
+
+bool_t  DrawList::add( enum_t primitive, state_t& state, const glm::mat4& mvp,
+                       const std::vector<glm::vec2>& points, const std::vector<glm::vec2>* texCoord,
+                       const glm::vec4& color ) noexcept(true)
+{
+  if ( points.empty() )
+    return true;
+
+  if ( ( texCoord != nullptr ) && ( texCoord->size() < points.size() ) )
+    return true;
+
+  // A single command that can't be addressed with 16 bits indices is left 
+  // to the caller, since splitting would break strips.
+  if ( points.size() > k_max_vertices )
+    return false;
+
+  // 16 bits indices can't address more vertices, so what has been 
+  // collected so far is submitted in order to make room.
+  if ( m_vVertices.size() + points.size() > k_max_vertices )
+    flush();
+
+  command_t  cmd;
+  
+  cmd.primitive = primitive;
+  cmd.first     = static_cast<uint32_t>(m_vVertices.size());
+  cmd.count     = static_cast<uint32_t>(points.size());
+  cmd.min       = points[0];
+  cmd.max       = points[0];
+
+  for ( std::size_t ndx = 0; ndx < points.size(); ++ndx )
+  {
+    cmd.min = glm::min( cmd.min, points[ndx] );
+    cmd.max = glm::max( cmd.max, points[ndx] );
+
+    m_vVertices.push_back( { points[ndx], (texCoord!=nullptr)?(*texCoord)[ndx]:glm::vec2(0.0f), color } );
+  }
+
+  push( state, mvp, cmd );
+
+  return true;
+}
+
+void_t  DrawList::add( state_t& state, const glm::mat4& mvp, VertexSlab::quad_t quad ) noexcept(true)
+{
+  if ( VertexSlab::is_valid() == false )
+    return;
+
+  const VertexSlab::vertex_t* pVertices = VertexSlab::get_instance()->get_vertices( quad );
+  if ( pVertices == nullptr )
+    return;
+
+  command_t  cmd;
+  
+  cmd.primitive = GL_TRIANGLE_STRIP;
+  cmd.first     = VertexSlab::get_first( quad );
+  cmd.count     = 4;
+  cmd.min       = pVertices[0].point;
+  cmd.max       = pVertices[0].point;
+
+  for ( uint32_t ndx = 1; ndx < 4; ++ndx )
+  {
+    cmd.min = glm::min( cmd.min, pVertices[ndx].point );
+    cmd.max = glm::max( cmd.max, pVertices[ndx].point );
+  }
+
+  state.source = VertexSlab::get_page( quad ) + 1;
+
+  push( state, mvp, cmd );
+}
+
+void_t  DrawList::push( state_t& state, const glm::mat4& mvp, command_t& cmd ) noexcept(true)
+{
+  // Commands sharing the same matrix share the same index.
+  if ( m_vMVP.empty() || ( m_vMVP.back() != mvp ) )
+    m_vMVP.push_back( mvp );
+
+  state.mvp = static_cast<uint32_t>(m_vMVP.size() - 1);
+
+  auto iter = m_mapStates.find( state );
+  if ( iter == m_mapStates.end() )
+  {
+    iter = m_mapStates.emplace( state, static_cast<uint32_t>(m_vStates.size()) ).first;
+    m_vStates.push_back( state );
+  }
+
+  cmd.state = iter->second;
+  cmd.depth = 0;
+
+  // A command must be drawn after any previous command it overlaps, unless they share
+  // the same state and so they will end up in the same draw call preserving the order.
+  // Commands with a different matrix are always considered overlapping.
+  // Previous commands are checked by depth, using the union of their boxes, starting 
+  // from the highest depth since lower ones can't raise the result; a union can report
+  // an overlap where there is none, that only splits a batch and never breaks the order.
+  for ( std::size_t ndx = m_vLevels.size(); ndx-- > 0; )
+  {
+    const level_t& level   = m_vLevels[ndx];
+    const bool_t   overlap = level.mixed_mvp || ( level.mvp != state.mvp ) ||
+                             ( ( level.min.x <= cmd.max.x ) && ( cmd.min.x <= level.max.x ) &&
+                               ( level.min.y <= cmd.max.y ) && ( cmd.min.y <= level.max.y ) );
+    if ( overlap == false )
+      continue;
+
+    const bool_t   same    = ( level.mixed_state == false ) && ( level.state == cmd.state );
+    cmd.depth = static_cast<uint32_t>( ndx + ( same?0:1 ) );
+    break;
+  }
+
+  if ( cmd.depth == m_vLevels.size() )
+  {
+    m_vLevels.push_back( level_t{ cmd.min, cmd.max, cmd.state, state.mvp, false, false } );
+  }
+  else
+  {
+    level_t& level = m_vLevels[cmd.depth];
+    level.min          = glm::min( level.min, cmd.min );
+    level.max          = glm::max( level.max, cmd.max );
+    level.mixed_state |= ( level.state != cmd.state );
+    level.mixed_mvp   |= ( level.mvp   != state.mvp );
+  }
+
+  m_vCommands.push_back( cmd );
+}
+
+bool_t  DrawList::flush() noexcept(true)
+{
+  if ( m_vCommands.empty() )
+    return true;
+
+  m_vOrder.resize( m_vCommands.size() );
+  for ( uint32_t ndx = 0; ndx < m_vOrder.size(); ++ndx )
+    m_vOrder[ndx] = ndx;
+
+  // Stable sort will keep submission order for commands with same depth and state.
+  std::stable_sort( m_vOrder.begin(), m_vOrder.end(), [this]( uint32_t a, uint32_t b ) {
+    const command_t& ca = m_vCommands[a];
+    const command_t& cb = m_vCommands[b];
+    if ( ca.depth != cb.depth )
+      return ca.depth < cb.depth;
+    return ca.state < cb.state;
+  });
+
+  // Build index stream and merge adjacent commands sharing the same state.
+  m_vIndices.clear();
+  m_vRuns.clear();
+
+  for ( uint32_t ndx : m_vOrder )
+  {
+    const command_t& cmd = m_vCommands[ndx];
+
+    if ( m_vRuns.empty() || ( m_vRuns.back().state != cmd.state ) )
+    {
+      m_vRuns.push_back( { cmd.state, static_cast<uint32_t>(m_vIndices.size()), 0 } );
+    }
+    else
+    {
+      m_stats.merged++;
+    }
+
+    switch ( cmd.primitive )
+    {
+      case GL_TRIANGLE_STRIP:
+      {
+        for ( uint32_t i = 0; i + 2 < cmd.count; ++i )
+        {
+          // Keep strip winding order.
+          const word_t v = static_cast<word_t>(cmd.first + i);
+          if ( i % 2 == 0 )
+            m_vIndices.insert( m_vIndices.end(), { v, word_t(v+1), word_t(v+2) } );
+          else
+            m_vIndices.insert( m_vIndices.end(), { word_t(v+1), v, word_t(v+2) } );
+        }
+      }; break;
+      case GL_LINE_STRIP:
+      {
+        for ( uint32_t i = 0; i + 1 < cmd.count; ++i )
+        {
+          const word_t v = static_cast<word_t>(cmd.first + i);
+          m_vIndices.insert( m_vIndices.end(), { v, word_t(v+1) } );
+        }
+      }; break;
+      default:
+      {
+        for ( uint32_t i = 0; i < cmd.count; ++i )
+          m_vIndices.push_back( static_cast<word_t>(cmd.first + i) );
+      }; break;
+    }
+
+    m_vRuns.back().count = static_cast<uint32_t>(m_vIndices.size()) - m_vRuns.back().first;
+  }
+
+  m_stats.commands += static_cast<uint32_t>(m_vCommands.size());
+  m_stats.draws    += static_cast<uint32_t>(m_vRuns.size());
+  m_stats.vertices += static_cast<uint32_t>(m_vVertices.size());
+  m_stats.indices  += static_cast<uint32_t>(m_vIndices.size());
+
+  if ( m_vbo == 0 )
+    glGenBuffers( 1, &m_vbo );
+  if ( m_ibo == 0 )
+    glGenBuffers( 1, &m_ibo );
+
+  StateCache& cache = StateCache::get_current();
+
+  // Whole buffers are respecified each frame, this let the driver orphan previous storage.
+  if ( m_vVertices.empty() == false )
+  {
+    cache.bind_buffer( GL_ARRAY_BUFFER, m_vbo );
+    glBufferData( GL_ARRAY_BUFFER, m_vVertices.size() * sizeof(vertex_t), m_vVertices.data(), GL_STREAM_DRAW );
+  }
+
+  uint32_t source   = k_no_source;
+  bool_t   bIndices = false;
+  for ( const run_t& run : m_vRuns )
+  {
+    const state_t& state = m_vStates[run.state];
+
+    if ( state.source != source )
+    {
+      bind_source( state.source, source );
+      source = state.source;
+
+      // Element array binding may have been replaced by a vertex array object.
+      cache.bind_buffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+      if ( bIndices == false )
+      {
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_vIndices.size() * sizeof(word_t), m_vIndices.data(), GL_STREAM_DRAW );
+        bIndices = true;
+      }
+    }
+
+    apply( state );
+
+    glDrawElements( state.mode, run.count, GL_UNSIGNED_SHORT, (const void_t*)(run.first * sizeof(word_t)) );
+
+    // Textures bound to the render lifecycle exist only while used.
+    if ( state.texture != nullptr )
+      state.texture->unbind( GL_TEXTURE_2D );
+  }
+
+#if defined(_NV_CARD_)
+  cache.disable( GL_VERTEX_PROGRAM_POINT_SIZE );
+#endif
+
+  bind_source( k_no_source, source );
+
+  // Immediate drawing relies on client side arrays, so no buffer must be left bound.
+  cache.bind_buffer( GL_ARRAY_BUFFER        , 0 );
+  cache.bind_buffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+  clear();
+
+  return true;
+}
+
+void_t  DrawList::bind_source( uint32_t source, uint32_t previous ) noexcept(true)
+{
+  // Release previous source.
+  if ( previous == 0 )
+  {
+    glDisableVertexAttribArray( 0 );
+    glDisableVertexAttribArray( 1 );
+    glDisableVertexAttribArray( 2 );
+  }
+  else if ( ( previous != k_no_source ) && VertexSlab::is_valid() )
+  {
+    VertexSlab::get_instance()->unbind();
+  }
+
+  if ( source == 0 )
+  {
+    StateCache::get_current().bind_buffer( GL_ARRAY_BUFFER, m_vbo );
+
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer    ( 0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, point)     );
+    glEnableVertexAttribArray( 1 );
+    glVertexAttribPointer    ( 1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, tex_coord) );
+    glEnableVertexAttribArray( 2 );
+    glVertexAttribPointer    ( 2, 4, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, color)     );
+  }
+  else if ( ( source != k_no_source ) && VertexSlab::is_valid() )
+  {
+    VertexSlab::get_instance()->bind( source - 1 );
+  }
+}
+
+void_t  DrawList::apply( const state_t& state ) noexcept(true)
+{
+  static program_ref_t s_programs[] = { program_ref_t( "BatchSolid" ), program_ref_t( "BatchTexture" ), program_ref_t( "BatchText" ) };
+
+  StateCache& cache = StateCache::get_current();
+
+  Program* pProgram = get_program( s_programs[static_cast<std::size_t>(state.program)] );
+  if ( pProgram == nullptr )
+    return;
+
+  pProgram->use();
+
+  pProgram->set_uniform( Program::uniform_t::eMVP, m_vMVP[state.mvp] );
+
+  if ( state.program == program_t::eSolid )
+    pProgram->set_uniform( Program::uniform_t::eThickness, state.thickness );
+
+  if ( state.texture != nullptr )
+  {
+    cache.active_texture( 0 );
+    state.texture->bind( GL_TEXTURE_2D, 0, state.tws, state.twt );
+    pProgram->set_uniform( Program::uniform_t::eTexture, 0 );
+  }
+
+  if ( state.blend )
+  {
+    cache.enable( GL_BLEND );
+    if ( ( state.texture != nullptr ) && state.texture->is_premultiplied() )
+      cache.blend_premultiplied();
+    else
+      cache.blend_alpha();
+  }
+  else
+  {
+    cache.disable( GL_BLEND );
+  }
+
+  if ( state.mode == GL_LINES )
+    cache.line_width( state.thickness );
+
+#if defined(_NV_CARD_)
+  if ( state.mode == GL_POINTS )
+    cache.enable( GL_VERTEX_PROGRAM_POINT_SIZE );
+  else
+    cache.disable( GL_VERTEX_PROGRAM_POINT_SIZE );
+#endif
+}
+
+void_t  DrawList::clear() noexcept(true)
+{
+  m_vMVP.clear();
+  m_vStates.clear();
+  m_mapStates.clear();
+  m_vCommands.clear();
+  m_vLevels.clear();
+  m_vVertices.clear();
+}
+
+}
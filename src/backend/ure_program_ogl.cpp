@@ -24,17 +24,28 @@
 #include "ure_program.h"
 #include "ure_vertex_shader.h"
 #include "ure_fragment_shader.h"
+#include "ure_state_cache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstring>
 
 namespace ure {
 
 Program::Program( ) noexcept
 {
   set_id( glCreateProgram( ) );
+  
+  m_aTags.fill( k_invalid_slot );
 }
 
 Program::~Program() noexcept
 {
   glDeleteProgram( get_id() );
+
+  StateCache* pState = StateCache::find_current();
+  if ( pState != nullptr )
+    pState->deleted_program( get_id() );
 }
 
 bool_t Program::attach_shaders( std::shared_ptr<VertexShader> pVertexShader, std::shared_ptr<FragmentShader> pFragmentShader )
@@ -69,14 +80,17 @@ bool_t Program::link() noexcept
   glLinkProgram( get_id() );
 
   if (is_linked())
+  {
+    reflect();
     return true;
+  }
   
   return false;
 }
 
 void_t Program::use() noexcept
 {
-  glUseProgram( get_id() );
+  StateCache::get_current().use_program( get_id() );
 }
 
 bool_t Program::is_linked() const noexcept
@@ -117,6 +131,128 @@ int_t Program::getAttachedShaders() const noexcept
   return query(GL_ATTACHED_SHADERS);
 }
 
+int_t Program::get_uniform_slot( const std::string& name ) const noexcept
+{
+  for ( std::size_t ndx = 0; ndx < m_vUniforms.size(); ++ndx )
+  {
+    if ( m_vUniforms[ndx].name == name )
+      return (int_t)ndx;
+  }
+  
+  return k_invalid_slot;
+}
+
+int_t Program::get_attribute_slot( const std::string& name ) const noexcept
+{
+  for ( std::size_t ndx = 0; ndx < m_vAttributes.size(); ++ndx )
+  {
+    if ( m_vAttributes[ndx].name == name )
+      return (int_t)ndx;
+  }
+  
+  return k_invalid_slot;
+}
+
+bool_t Program::set_uniform( int_t slot, int_t value ) noexcept
+{
+  float_t fValue = (float_t)value;
+  if ( update_cache( slot, &fValue, 1 ) == false )
+    return false;
+  
+  glUniform1i( m_vUniforms[slot].location, value );
+  return true;
+}
+
+bool_t Program::set_uniform( int_t slot, float_t value ) noexcept
+{
+  if ( update_cache( slot, &value, 1 ) == false )
+    return false;
+  
+  glUniform1f( m_vUniforms[slot].location, value );
+  return true;
+}
+
+bool_t Program::set_uniform( int_t slot, const glm::vec4& value ) noexcept
+{
+  if ( update_cache( slot, glm::value_ptr(value), 4 ) == false )
+    return false;
+  
+  glUniform4fv( m_vUniforms[slot].location, 1, glm::value_ptr(value) );
+  return true;
+}
+
+bool_t Program::set_uniform( int_t slot, const glm::mat4& value ) noexcept
+{
+  if ( update_cache( slot, glm::value_ptr(value), 16 ) == false )
+    return false;
+  
+  glUniformMatrix4fv( m_vUniforms[slot].location, 1, GL_FALSE, glm::value_ptr(value) );
+  return true;
+}
+
+bool_t Program::update_cache( int_t slot, const float_t* pValue, std::size_t count ) noexcept
+{
+  if ( is_slot(slot) == false )
+    return false;
+  
+  uniform_cache_t& cache = m_vCache[slot];
+  if ( cache.valid && ( memcmp( cache.value.data(), pValue, count*sizeof(float_t) ) == 0 ) )
+    return false;
+  
+  memcpy( cache.value.data(), pValue, count*sizeof(float_t) );
+  cache.valid = true;
+  
+  return true;
+}
+
+void_t Program::reflect() noexcept
+{
+  static const char* const s_tags[] = { "u_m4MVP", "u_v4Color", "u_fThickness", "u_2dTexture" };
+  
+  m_vUniforms.clear();
+  m_vCache.clear();
+  m_vAttributes.clear();
+  m_aTags.fill( k_invalid_slot );
+  
+  std::vector<char_t> vName( std::max( getActiveUniformMaxLength(), getActiveAttributeMaxLength() ) + 1 );
+  
+  for ( int_t ndx = 0; ndx < getActiveUniforms(); ++ndx )
+  {
+    sizei_t        length = 0;
+    uniform_info_t info;
+    
+    glGetActiveUniform( get_id(), ndx, (sizei_t)vName.size(), &length, &info.size, &info.type, vName.data() );
+    
+    info.name.assign( vName.data(), length );
+    // Arrays are reported as "name[0]", the base name is enough to address them.
+    if ( info.name.ends_with( "[0]" ) )
+      info.name.resize( info.name.size() - 3 );
+    
+    info.location = glGetUniformLocation( get_id(), vName.data() );
+    
+    m_vUniforms.push_back( info );
+    m_vCache.push_back( uniform_cache_t{ {}, false } );
+  }
+  
+  for ( int_t ndx = 0; ndx < getActiveAttributes(); ++ndx )
+  {
+    sizei_t          length = 0;
+    attribute_info_t info;
+    
+    glGetActiveAttrib( get_id(), ndx, (sizei_t)vName.size(), &length, &info.size, &info.type, vName.data() );
+    
+    info.name.assign( vName.data(), length );
+    info.location = glGetAttribLocation( get_id(), vName.data() );
+    
+    m_vAttributes.push_back( info );
+  }
+  
+  for ( std::size_t tag = 0; tag < m_aTags.size(); ++tag )
+  {
+    m_aTags[tag] = get_uniform_slot( s_tags[tag] );
+  }
+}
+
 uint_t Program::query( GLenum e ) const noexcept
 {
   int_t iValue;
@@ -0,0 +1,140 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_render_target.h"
+#include "ure_state_cache.h"
+
+
+namespace ure {
+
+RenderTarget::RenderTarget( sizei_t width, sizei_t height ) noexcept(true)
+  : HandledObject( URE_INVALID_HANDLE ),
+    m_texture( width, height, Texture::format_t::eRGBA, Texture::type_t::eUnsignedByte, Texture::lifecycle_t::eTarget ),
+    m_depth_stencil( 0 ), m_scissor( false ), m_prev_premultiplied( false ), 
+    m_prev_fbo( 0 ), m_prev_viewport{ 0, 0, 0, 0 }, m_prev_clear_color{ 0.0f, 0.0f, 0.0f, 0.0f }
+{
+}
+
+RenderTarget::~RenderTarget() noexcept(true)
+{
+  if ( get_id() != URE_INVALID_HANDLE )
+  {
+    StateCache* pState = StateCache::find_current();
+    if ( pState != nullptr )
+      pState->deleted_framebuffer( get_id() );
+
+    glDeleteFramebuffers( 1, &m_id );
+  }
+
+  if ( m_depth_stencil != 0 )
+    glDeleteRenderbuffers( 1, &m_depth_stencil );
+}
+
+bool_t  RenderTarget::begin( const Recti* pArea ) noexcept(true)
+{
+  StateCache& state = StateCache::get_current();
+
+  sizei_t vw = 0, vh = 0;
+  state.get_viewport( m_prev_viewport[0], m_prev_viewport[1], vw, vh );
+  m_prev_viewport[2] = vw;
+  m_prev_viewport[3] = vh;
+
+  state.get_clear_color( m_prev_clear_color[0], m_prev_clear_color[1], m_prev_clear_color[2], m_prev_clear_color[3] );
+
+  m_prev_fbo           = state.get_framebuffer();
+  m_prev_premultiplied = state.is_premultiplied_target();
+
+  // Storage is allocated on first bind().
+  if ( m_texture.bind( GL_TEXTURE_2D, 0 ) == false )
+    return false;
+  m_texture.unbind( GL_TEXTURE_2D );
+
+  if ( ( get_id() == URE_INVALID_HANDLE ) && ( create() == false ) )
+    return false;
+
+  state.bind_framebuffer( get_id() );
+  state.set_premultiplied_target( true );
+
+  state.viewport( 0, 0, get_size().width, get_size().height );
+
+  // Clear is limited by the scissor box as well.
+  m_scissor = ( pArea != nullptr );
+  if ( m_scissor )
+  {
+    state.enable ( GL_SCISSOR_TEST );
+    state.scissor( pArea->left, pArea->top, pArea->right, pArea->bottom );
+  }
+
+  // Stencil clips pushed while rendering into the target start from an empty buffer.
+  state.clear_color( 0.0f, 0.0f, 0.0f, 0.0f );
+  glClear( GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
+
+  return true;
+}
+
+void_t  RenderTarget::end() noexcept(true)
+{
+  StateCache& state = StateCache::get_current();
+
+  state.bind_framebuffer( m_prev_fbo );
+  state.set_premultiplied_target( m_prev_premultiplied );
+
+  if ( m_scissor )
+    state.disable( GL_SCISSOR_TEST );
+
+  state.viewport( m_prev_viewport[0], m_prev_viewport[1], m_prev_viewport[2], m_prev_viewport[3] );
+  state.clear_color( m_prev_clear_color[0], m_prev_clear_color[1], m_prev_clear_color[2], m_prev_clear_color[3] );
+}
+
+bool_t  RenderTarget::create() noexcept(true)
+{
+  StateCache& state = StateCache::get_current();
+
+  // Clips drawn with the stencil buffer need one in the target as well.
+  glGenRenderbuffers( 1, &m_depth_stencil );
+  glBindRenderbuffer( GL_RENDERBUFFER, m_depth_stencil );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, get_size().width, get_size().height );
+  glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+  glGenFramebuffers( 1, &m_id );
+  state.bind_framebuffer( get_id() );
+  glFramebufferTexture2D   ( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0       , GL_TEXTURE_2D  , m_texture.get_id(), 0 );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth_stencil      );
+
+  const bool_t complete = ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE );
+
+  state.bind_framebuffer( m_prev_fbo );
+
+  if ( complete == false )
+  {
+    state.deleted_framebuffer( get_id() );
+    glDeleteFramebuffers( 1, &m_id );
+    glDeleteRenderbuffers( 1, &m_depth_stencil );
+    m_id            = URE_INVALID_HANDLE;
+    m_depth_stencil = 0;
+  }
+
+  return complete;
+}
+
+}
@@ -22,6 +22,7 @@
  *************************************************************************************************/
 
 #include "ure_scene_graph.h"
+#include "ure_state_cache.h"
 
 
 #define GLM_FORCE_RADIANS
@@ -40,7 +41,7 @@ void_t  SceneGraph::set_background( GLclampf red, GLclampf green, GLclampf blue,
 
   ///////////////////
   // Reset background color
-  glClearColor( m_red, m_green, m_blue, m_alpha );
+  StateCache::get_current().clear_color( m_red, m_green, m_blue, m_alpha );
 }
 
 void_t  SceneGraph::get_background( GLclampf& red, GLclampf& green, GLclampf& blue, GLclampf& alpha ) noexcept(true)
@@ -53,23 +54,38 @@ void_t  SceneGraph::get_background( GLclampf& red, GLclampf& green, GLclampf& bl
 
 const SceneCameraNode*  SceneGraph::get_active_camera() const noexcept(true)
 {
+  if ( ( m_camera_dirty == false ) && ( m_camera_activations == Camera::get_activations() ) )
+    return m_pActiveCamera;
+
+  m_camera_dirty       = false;
+  m_camera_activations = Camera::get_activations();
+  m_pActiveCamera      = nullptr;
+  m_active_camera      = nullptr;
+
   const scene_node_map_t* mapCameras = get_scene_node_map( "SceneCameraNode" );
   if ( mapCameras == nullptr )
     return nullptr;
   
   for( auto& NodeBasePtr : *mapCameras )
   {
-    const SceneCameraNode* pCameraNode = dynamic_cast<const SceneCameraNode*>(NodeBasePtr.second.get());
+    // Nodes are registered by type name, so all nodes in this map are camera nodes.
+    const SceneCameraNode* pCameraNode = static_cast<const SceneCameraNode*>(NodeBasePtr.second.get());
     if ( pCameraNode->get_camera()->is_active() )
-      return pCameraNode;
+    {
+      m_pActiveCamera = pCameraNode;
+      m_active_camera = pCameraNode->get_camera();
+      break;
+    }
   }
 
-  return nullptr;
+  return m_pActiveCamera;
 }
  
 bool_t  SceneGraph::on_add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true)
 {
-  m_vRender.push_back( pSceneNode );
+  if ( pSceneNode->type() == "SceneCameraNode" )
+    m_camera_dirty = true;
+
   return true;
 }
 
@@ -0,0 +1,407 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_state_cache.h"
+
+namespace ure {
+
+static thread_local StateCache*  s_pCurrent = nullptr;
+static thread_local bool_t       s_bDefault = true;
+
+/* Default instance, flag it as gone when destroyed with its thread. */
+struct default_state_t {
+  StateCache  state;
+
+  ~default_state_t() noexcept(true)
+  { s_bDefault = false; }
+};
+
+StateCache::StateCache() noexcept(true)
+  : m_premultiplied_target( false ), m_stats{}
+{
+  invalidate();
+}
+
+StateCache::~StateCache() noexcept(true)
+{
+  release();
+}
+
+StateCache&  StateCache::get_current() noexcept(true)
+{
+  static thread_local default_state_t s_default;
+
+  return (s_pCurrent != nullptr)?*s_pCurrent:s_default.state;
+}
+
+StateCache*  StateCache::find_current() noexcept(true)
+{
+  if ( s_pCurrent != nullptr )
+    return s_pCurrent;
+
+  return s_bDefault?&get_current():nullptr;
+}
+
+void_t  StateCache::make_current() noexcept(true)
+{
+  s_pCurrent = this;
+}
+
+void_t  StateCache::release() noexcept(true)
+{
+  if ( s_pCurrent == this )
+    s_pCurrent = nullptr;
+}
+
+void_t  StateCache::invalidate() noexcept(true)
+{
+  m_program.valid           = false;
+  m_active_texture.valid    = false;
+  m_array_buffer.valid      = false;
+  m_element_buffer.valid    = false;
+  m_vertex_array.valid      = false;
+  m_framebuffer.valid       = false;
+  m_blend_func.valid        = false;
+  m_viewport.valid          = false;
+  m_scissor.valid           = false;
+  m_stencil_func.valid      = false;
+  m_stencil_op.valid        = false;
+  m_color_mask.valid        = false;
+  m_clear_color.valid       = false;
+  m_pack_alignment.valid    = false;
+  m_unpack_alignment.valid  = false;
+  m_unpack_row_length.valid = false;
+  m_line_width.valid        = false;
+
+  for ( std::size_t ndx = 0; ndx < k_max_texture_units; ++ndx )
+  {
+    m_textures_2d[ndx].valid   = false;
+    m_textures_cube[ndx].valid = false;
+  }
+
+  for ( cap_t& cap : m_vCaps )
+    cap.enabled.valid = false;
+}
+
+template<typename value_t>
+bool_t  StateCache::update( cached_t<value_t>& cached, const value_t& value ) noexcept(true)
+{
+  if ( cached.valid && ( cached.value == value ) )
+  {
+    m_stats.skipped++;
+    return false;
+  }
+
+  cached.value = value;
+  cached.valid = true;
+
+  m_stats.issued++;
+  return true;
+}
+
+void_t  StateCache::use_program( uint_t program ) noexcept(true)
+{
+  if ( update( m_program, program ) )
+    glUseProgram( program );
+}
+
+void_t  StateCache::active_texture( uint_t unit ) noexcept(true)
+{
+  if ( update( m_active_texture, unit ) )
+    glActiveTexture( GL_TEXTURE0 + unit );
+}
+
+void_t  StateCache::bind_texture( enum_t target, uint_t texture ) noexcept(true)
+{
+  textures_t* pTextures = nullptr;
+
+  switch ( target )
+  {
+    case GL_TEXTURE_2D      : pTextures = &m_textures_2d;   break;
+    case GL_TEXTURE_CUBE_MAP: pTextures = &m_textures_cube; break;
+    default: break;
+  }
+
+  // Untracked targets or units are always forwarded.
+  if ( ( pTextures == nullptr ) || ( m_active_texture.valid == false ) || ( m_active_texture.value >= k_max_texture_units ) )
+  {
+    m_stats.issued++;
+    glBindTexture( target, texture );
+    return;
+  }
+
+  if ( update( (*pTextures)[m_active_texture.value], texture ) )
+    glBindTexture( target, texture );
+}
+
+void_t  StateCache::bind_buffer( enum_t target, uint_t buffer ) noexcept(true)
+{
+  cached_t<uint_t>* pBuffer = nullptr;
+
+  switch ( target )
+  {
+    case GL_ARRAY_BUFFER        : pBuffer = &m_array_buffer;   break;
+    case GL_ELEMENT_ARRAY_BUFFER: pBuffer = &m_element_buffer; break;
+    default: break;
+  }
+
+  if ( pBuffer == nullptr )
+  {
+    m_stats.issued++;
+    glBindBuffer( target, buffer );
+    return;
+  }
+
+  if ( update( *pBuffer, buffer ) )
+    glBindBuffer( target, buffer );
+}
+
+void_t  StateCache::bind_vertex_array( uint_t array ) noexcept(true)
+{
+  if ( update( m_vertex_array, array ) == false )
+    return;
+
+  glBindVertexArray( array );
+
+  m_element_buffer.valid = false;
+}
+
+void_t  StateCache::bind_framebuffer( uint_t framebuffer ) noexcept(true)
+{
+  if ( update( m_framebuffer, framebuffer ) )
+    glBindFramebuffer( GL_FRAMEBUFFER, framebuffer );
+}
+
+uint_t  StateCache::get_framebuffer() noexcept(true)
+{
+  if ( m_framebuffer.valid == false )
+  {
+    int_t framebuffer = 0;
+    glGetIntegerv( GL_FRAMEBUFFER_BINDING, &framebuffer );
+
+    m_framebuffer.value = (uint_t)framebuffer;
+    m_framebuffer.valid = true;
+  }
+
+  return m_framebuffer.value;
+}
+
+void_t  StateCache::enable( enum_t cap ) noexcept(true)
+{
+  set_cap( cap, true );
+}
+
+void_t  StateCache::disable( enum_t cap ) noexcept(true)
+{
+  set_cap( cap, false );
+}
+
+void_t  StateCache::set_cap( enum_t cap, bool_t enabled ) noexcept(true)
+{
+  cap_t* pCap = nullptr;
+
+  // Just few capabilities are used, so a linear search is enough.
+  for ( cap_t& item : m_vCaps )
+  {
+    if ( item.cap == cap )
+    {
+      pCap = &item;
+      break;
+    }
+  }
+
+  if ( pCap == nullptr )
+  {
+    m_vCaps.push_back( { cap, { false, false } } );
+    pCap = &m_vCaps.back();
+  }
+
+  if ( update( pCap->enabled, enabled ) == false )
+    return;
+
+  if ( enabled )
+    glEnable( cap );
+  else
+    glDisable( cap );
+}
+
+void_t  StateCache::blend_func( enum_t sfactor, enum_t dfactor ) noexcept(true)
+{
+  if ( update( m_blend_func, blend_func_t{ sfactor, dfactor, sfactor, dfactor } ) )
+    glBlendFunc( sfactor, dfactor );
+}
+
+void_t  StateCache::blend_func_separate( enum_t srgb, enum_t drgb, enum_t salpha, enum_t dalpha ) noexcept(true)
+{
+  if ( update( m_blend_func, blend_func_t{ srgb, drgb, salpha, dalpha } ) )
+    glBlendFuncSeparate( srgb, drgb, salpha, dalpha );
+}
+
+void_t  StateCache::blend_alpha() noexcept(true)
+{
+  if ( m_premultiplied_target )
+    blend_func_separate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+  else
+    blend_func( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+void_t  StateCache::blend_premultiplied() noexcept(true)
+{
+  blend_func( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+void_t  StateCache::viewport( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept(true)
+{
+  if ( update( m_viewport, viewport_t{ x, y, width, height } ) )
+    glViewport( x, y, width, height );
+}
+
+void_t  StateCache::get_viewport( int_t& x, int_t& y, sizei_t& width, sizei_t& height ) noexcept(true)
+{
+  if ( m_viewport.valid == false )
+  {
+    glGetIntegerv( GL_VIEWPORT, m_viewport.value.data() );
+    m_viewport.valid = true;
+  }
+
+  x      = m_viewport.value[0];
+  y      = m_viewport.value[1];
+  width  = m_viewport.value[2];
+  height = m_viewport.value[3];
+}
+
+void_t  StateCache::scissor( int_t x, int_t y, sizei_t width, sizei_t height ) noexcept(true)
+{
+  if ( update( m_scissor, viewport_t{ x, y, width, height } ) )
+    glScissor( x, y, width, height );
+}
+
+void_t  StateCache::stencil_func( enum_t func, int_t ref, uint_t mask ) noexcept(true)
+{
+  if ( update( m_stencil_func, stencil_t{ func, (uint_t)ref, mask } ) )
+    glStencilFunc( func, ref, mask );
+}
+
+void_t  StateCache::stencil_op( enum_t sfail, enum_t dpfail, enum_t dppass ) noexcept(true)
+{
+  if ( update( m_stencil_op, stencil_t{ sfail, dpfail, dppass } ) )
+    glStencilOp( sfail, dpfail, dppass );
+}
+
+void_t  StateCache::color_mask( bool_t red, bool_t green, bool_t blue, bool_t alpha ) noexcept(true)
+{
+  if ( update( m_color_mask, mask_t{ red, green, blue, alpha } ) )
+    glColorMask( red, green, blue, alpha );
+}
+
+void_t  StateCache::clear_color( float_t red, float_t green, float_t blue, float_t alpha ) noexcept(true)
+{
+  if ( update( m_clear_color, color_t{ red, green, blue, alpha } ) )
+    glClearColor( red, green, blue, alpha );
+}
+
+void_t  StateCache::get_clear_color( float_t& red, float_t& green, float_t& blue, float_t& alpha ) noexcept(true)
+{
+  if ( m_clear_color.valid == false )
+  {
+    glGetFloatv( GL_COLOR_CLEAR_VALUE, m_clear_color.value.data() );
+    m_clear_color.valid = true;
+  }
+
+  red   = m_clear_color.value[0];
+  green = m_clear_color.value[1];
+  blue  = m_clear_color.value[2];
+  alpha = m_clear_color.value[3];
+}
+
+void_t  StateCache::pixel_store( enum_t pname, int_t param ) noexcept(true)
+{
+  cached_t<int_t>* pParam = nullptr;
+
+  switch ( pname )
+  {
+    case GL_PACK_ALIGNMENT   : pParam = &m_pack_alignment;    break;
+    case GL_UNPACK_ALIGNMENT : pParam = &m_unpack_alignment;  break;
+    case GL_UNPACK_ROW_LENGTH: pParam = &m_unpack_row_length; break;
+    default: break;
+  }
+
+  if ( pParam == nullptr )
+  {
+    m_stats.issued++;
+    glPixelStorei( pname, param );
+    return;
+  }
+
+  if ( update( *pParam, param ) )
+    glPixelStorei( pname, param );
+}
+
+void_t  StateCache::line_width( float_t width ) noexcept(true)
+{
+  if ( update( m_line_width, width ) )
+    glLineWidth( width );
+}
+
+void_t  StateCache::deleted_program( uint_t program ) noexcept(true)
+{
+  // Program in use is only flagged for deletion, so binding is unknown from now on.
+  if ( m_program.valid && ( m_program.value == program ) )
+    m_program.valid = false;
+}
+
+void_t  StateCache::deleted_texture( uint_t texture ) noexcept(true)
+{
+  for ( std::size_t ndx = 0; ndx < k_max_texture_units; ++ndx )
+  {
+    if ( m_textures_2d[ndx].valid && ( m_textures_2d[ndx].value == texture ) )
+      m_textures_2d[ndx].value = 0;
+    if ( m_textures_cube[ndx].valid && ( m_textures_cube[ndx].value == texture ) )
+      m_textures_cube[ndx].value = 0;
+  }
+}
+
+void_t  StateCache::deleted_buffer( uint_t buffer ) noexcept(true)
+{
+  if ( m_array_buffer.valid && ( m_array_buffer.value == buffer ) )
+    m_array_buffer.value = 0;
+  if ( m_element_buffer.valid && ( m_element_buffer.value == buffer ) )
+    m_element_buffer.value = 0;
+}
+
+void_t  StateCache::deleted_vertex_array( uint_t array ) noexcept(true)
+{
+  if ( m_vertex_array.valid && ( m_vertex_array.value == array ) )
+  {
+    m_vertex_array.value   = 0;
+    m_element_buffer.valid = false;
+  }
+}
+
+void_t  StateCache::deleted_framebuffer( uint_t framebuffer ) noexcept(true)
+{
+  if ( m_framebuffer.valid && ( m_framebuffer.value == framebuffer ) )
+    m_framebuffer.value = 0;
+}
+
+}
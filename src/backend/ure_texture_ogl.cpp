@@ -22,18 +22,20 @@
  *************************************************************************************************/
 
 #include "ure_texture.h"
+#include "ure_state_cache.h"
+#include "ure_texture_residency.h"
 
 
 namespace ure {
 
 void  Texture::set_packing( int32_t param ) noexcept(true)
 {
-  glPixelStorei(GL_PACK_ALIGNMENT, param );
+  StateCache::get_current().pixel_store( GL_PACK_ALIGNMENT, param );
 }
 
 void  Texture::set_unpacking( int32_t param ) noexcept(true)
 {
-  glPixelStorei(GL_UNPACK_ALIGNMENT, param );
+  StateCache::get_current().pixel_store( GL_UNPACK_ALIGNMENT, param );
 }
 
 void  Texture::setParameterf( uint32_t target, uint32_t pname, GLfloat param ) noexcept(true)
@@ -53,7 +55,7 @@ bool  Texture::tex_create( enum_t target, int_t level, int_t  tws, int_t twt ) n
 
   glGenTextures(1, &m_id);
   // texture 1 (poor quality scaling)
-  glBindTexture(target, get_id());   // 2d texture (x and y size)
+  StateCache::get_current().bind_texture( target, get_id() );   // 2d texture (x and y size)
 
   // Set 2D texture rendering options
   setParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // cheap scaling when image smalled than texture
@@ -61,9 +63,35 @@ bool  Texture::tex_create( enum_t target, int_t level, int_t  tws, int_t twt ) n
   setParameteri( target, GL_TEXTURE_WRAP_S, tws );
   setParameteri( target, GL_TEXTURE_WRAP_T, twt );  
  
-  // Send texture data to graphics card
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-  glTexImage2D(target, level, (GLint)get_format(), m_size.width, m_size.height, 0, (GLenum)get_format(), (GLenum)get_type(), m_pixels );
+  // Unsized formats are not accepted for red and red green textures.
+  GLint internal_format = (GLint)get_format();
+  if ( m_format == format_t::eRed )
+    internal_format = GL_R8;
+  else if ( m_format == format_t::eRG )
+    internal_format = GL_RG8;
+
+#if !defined(__EMSCRIPTEN__)
+  // Single and dual channels textures are sampled as alpha masks, 
+  // so that shaders don't need to know the storage format.
+  if ( m_format == format_t::eRed )
+  {
+    setParameteri( target, GL_TEXTURE_SWIZZLE_R, GL_ONE );
+    setParameteri( target, GL_TEXTURE_SWIZZLE_G, GL_ONE );
+    setParameteri( target, GL_TEXTURE_SWIZZLE_B, GL_ONE );
+    setParameteri( target, GL_TEXTURE_SWIZZLE_A, GL_RED );
+  }
+  else if ( m_format == format_t::eRG )
+  {
+    setParameteri( target, GL_TEXTURE_SWIZZLE_G, GL_RED   );
+    setParameteri( target, GL_TEXTURE_SWIZZLE_B, GL_RED   );
+    setParameteri( target, GL_TEXTURE_SWIZZLE_A, GL_GREEN );
+  }
+#endif
+
+  // Send texture data to graphics card, rows are tightly packed for all formats.
+  set_unpacking( 1 );
+  StateCache::get_current().pixel_store( GL_UNPACK_ROW_LENGTH, 0 );
+  glTexImage2D(target, level, internal_format, m_size.width, m_size.height, 0, (GLenum)get_format(), (GLenum)get_type(), m_pixels );
 
   return true;
 }
@@ -74,37 +102,85 @@ bool  Texture::tex_destroy() noexcept(true)
     return false;
 
   glDeleteTextures(1, &m_id);
+
+  StateCache* pState = StateCache::find_current();
+  if ( pState != nullptr )
+    pState->deleted_texture( m_id );
+
   set_id( URE_INVALID_HANDLE );
 
   return true;
 }
 
+bool  Texture::bind( enum_t target, int_t level, int_t tws, int_t twt ) noexcept(true)
+{
+  // Disable default 4 byte alignment
+  set_unpacking( 1 );
+
+  // Textures that keep their pixels are created on first use, since a
+  // context could be not available at construction time, or after an eviction.
+  if ( get_id() == URE_INVALID_HANDLE )
+  {
+    if ( ( m_pixels == nullptr ) && ( m_lifecycle != lifecycle_t::eTarget ) )
+      return false;
+
+    m_dirty_first = m_dirty_last = 0;
+    if ( tex_create( target, level, tws, twt ) == false )
+      return false;
+
+    // Content of render targets cannot be uploaded again, so they are not evictable.
+    if ( ( m_lifecycle != lifecycle_t::eTarget ) && TextureResidency::is_valid() )
+      TextureResidency::get_instance()->insert( *this );
+
+    return true;
+  }
+
+  // select the texture
+  StateCache::get_current().bind_texture( target, get_id() );   // 2d texture (x and y size)
+
+  if ( TextureResidency::is_valid() )
+    TextureResidency::get_instance()->touch( *this );
+
+  // Send only modified rows, full width so that row length is not required.
+  if ( ( m_dirty_last > m_dirty_first ) && ( m_pixels != nullptr ) )
+  {
+    glTexSubImage2D( target, level, 0, m_dirty_first, m_size.width, m_dirty_last - m_dirty_first, 
+                     (GLenum)get_format(), (GLenum)get_type(), 
+                     &m_pixels[m_dirty_first * m_size.width * get_bytes_per_pixel()] );
+
+    m_dirty_first = m_dirty_last = 0;
+  }
+
+  return true;
+}
+
+void  Texture::unbind( enum_t target ) noexcept(true)
+{
+  (void)target;
+}
 
 void  Texture::render(  const std::vector<glm::vec2>& vertices, const std::vector<glm::vec2>& texCoord, 
 					              bool blend, enum_t target, int_t level, int_t uLocation, GLuint aVertices, GLuint aTexCoord,
 					              int_t  tws, int_t twt
  					) noexcept(true)
 {
-  if ( blend )
-  {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  }
+  StateCache& state = StateCache::get_current();
 
-  // Disable default 4 byte alignment
-  set_unpacking( 1 );
-
-  // Create Textures if lifecycle is whithin the scope of render.
-  if ( m_lifecycle == lifecycle_t::eRender )
+  if ( blend )
   {
-    tex_create( target, level, tws, twt );
+    state.enable( GL_BLEND );
+    if ( is_premultiplied() )
+      state.blend_premultiplied();
+    else
+      state.blend_alpha();
   }
   else
   {
-    // select the texture
-    glBindTexture(target, get_id());   // 2d texture (x and y size)
+    state.disable( GL_BLEND );
   }
 
+  bind( target, level, tws, twt );
+
   // Set the base map sampler to texture unit 0
   glUniform1i(uLocation, 0);
   
@@ -119,14 +195,7 @@ void  Texture::render(  const std::vector<glm::vec2>& vertices, const std::vecto
   glDisableVertexAttribArray(aTexCoord);
   glDisableVertexAttribArray(aVertices);
 
-  if ( m_lifecycle == lifecycle_t::eRender )
-    tex_destroy();
-
-        
-  if ( blend )
-  {
-    glDisable(GL_BLEND);
-  }
+  unbind( target );
 }
 
 }
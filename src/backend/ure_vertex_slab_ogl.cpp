@@ -0,0 +1,222 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_vertex_slab.h"
+#include "ure_state_cache.h"
+
+#include <algorithm>
+
+namespace ure {
+
+VertexSlab::quad_t  VertexSlab::allocate() noexcept(true)
+{
+  quad_t quad = k_invalid_quad;
+
+  if ( m_vFree.empty() == false )
+  {
+    quad = m_vFree.back();
+    m_vFree.pop_back();
+  }
+  else
+  {
+    quad = static_cast<quad_t>(m_vUsed.size());
+
+    if ( get_page( quad ) >= m_vPages.size() )
+    {
+      std::unique_ptr<page_t> page( new(std::nothrow) page_t{ 0, 0, {}, 0, 0 } );
+      if ( page == nullptr )
+        return k_invalid_quad;
+      
+      page->vertices.resize( k_quads_per_page * 4 );
+
+      m_vPages.push_back( std::move(page) );
+      m_stats.pages++;
+    }
+
+    m_vUsed.push_back( false );
+  }
+
+  m_vUsed[quad] = true;
+  m_stats.quads++;
+
+  return quad;
+}
+
+void_t  VertexSlab::release( quad_t quad ) noexcept(true)
+{
+  if ( ( quad >= m_vUsed.size() ) || ( m_vUsed[quad] == false ) )
+    return;
+
+  m_vUsed[quad] = false;
+  m_vFree.push_back( quad );
+  m_stats.quads--;
+}
+
+bool_t  VertexSlab::update( quad_t quad, const std::vector<glm::vec2>& points, 
+                            const std::vector<glm::vec2>* texCoord, const glm::vec4& color ) noexcept(true)
+{
+  if ( ( quad >= m_vUsed.size() ) || ( m_vUsed[quad] == false ) )
+    return false;
+
+  if ( ( points.size() != 4 ) || ( ( texCoord != nullptr ) && ( texCoord->size() != 4 ) ) )
+    return false;
+
+  page_t&   page  = *m_vPages[get_page(quad)];
+  uint32_t  first = get_first( quad );
+
+  for ( uint32_t ndx = 0; ndx < 4; ++ndx )
+  {
+    vertex_t& vertex = page.vertices[first + ndx];
+
+    vertex.point = points[ndx];
+    vertex.color = color;
+    if ( texCoord != nullptr )
+      vertex.tex_coord = (*texCoord)[ndx];
+  }
+
+  // Extend the range that will be uploaded on next bind().
+  if ( page.dirty_last == 0 )
+  {
+    page.dirty_first = first;
+    page.dirty_last  = first + 4;
+  }
+  else
+  {
+    page.dirty_first = std::min( page.dirty_first, first     );
+    page.dirty_last  = std::max( page.dirty_last , first + 4 );
+  }
+
+  return true;
+}
+
+const VertexSlab::vertex_t*  VertexSlab::get_vertices( quad_t quad ) const noexcept(true)
+{
+  if ( ( quad >= m_vUsed.size() ) || ( m_vUsed[quad] == false ) )
+    return nullptr;
+
+  return &m_vPages[get_page(quad)]->vertices[get_first(quad)];
+}
+
+bool_t  VertexSlab::bind( uint32_t page ) noexcept(true)
+{
+  if ( page >= m_vPages.size() )
+    return false;
+
+  StateCache& cache = StateCache::get_current();
+  page_t&     data  = *m_vPages[page];
+
+  if ( data.vbo == 0 )
+  {
+    glGenBuffers( 1, &data.vbo );
+
+    cache.bind_buffer( GL_ARRAY_BUFFER, data.vbo );
+    glBufferData( GL_ARRAY_BUFFER, data.vertices.size() * sizeof(vertex_t), data.vertices.data(), GL_DYNAMIC_DRAW );
+
+    m_stats.uploads++;
+    m_stats.uploaded_bytes += static_cast<uint32_t>(data.vertices.size() * sizeof(vertex_t));
+
+    data.dirty_first = 0;
+    data.dirty_last  = 0;
+  }
+  else
+  {
+    cache.bind_buffer( GL_ARRAY_BUFFER, data.vbo );
+  }
+
+  if ( data.dirty_last != 0 )
+  {
+    const std::size_t offset = data.dirty_first * sizeof(vertex_t);
+    const std::size_t length = (data.dirty_last - data.dirty_first) * sizeof(vertex_t);
+
+    glBufferSubData( GL_ARRAY_BUFFER, offset, length, &data.vertices[data.dirty_first] );
+
+    m_stats.uploads++;
+    m_stats.uploaded_bytes += static_cast<uint32_t>(length);
+
+    data.dirty_first = 0;
+    data.dirty_last  = 0;
+  }
+
+#if defined(_OGL3_ENABLED)
+  if ( data.vao != 0 )
+  {
+    cache.bind_vertex_array( data.vao );
+    return true;
+  }
+
+  glGenVertexArrays( 1, &data.vao );
+  cache.bind_vertex_array( data.vao );
+#endif
+
+  glEnableVertexAttribArray( 0 );
+  glVertexAttribPointer    ( 0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, point)     );
+  glEnableVertexAttribArray( 1 );
+  glVertexAttribPointer    ( 1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, tex_coord) );
+  glEnableVertexAttribArray( 2 );
+  glVertexAttribPointer    ( 2, 4, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void_t*)offsetof(vertex_t, color)     );
+
+  return true;
+}
+
+void_t  VertexSlab::unbind() noexcept(true)
+{
+  StateCache& cache = StateCache::get_current();
+
+#if defined(_OGL3_ENABLED)
+  cache.bind_vertex_array( 0 );
+#else
+  glDisableVertexAttribArray( 0 );
+  glDisableVertexAttribArray( 1 );
+  glDisableVertexAttribArray( 2 );
+#endif
+
+  cache.bind_buffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void_t  VertexSlab::on_finalize() noexcept(true)
+{
+  StateCache& cache = StateCache::get_current();
+
+  for ( std::unique_ptr<page_t>& page : m_vPages )
+  {
+#if defined(_OGL3_ENABLED)
+    if ( page->vao != 0 )
+    {
+      glDeleteVertexArrays( 1, &page->vao );
+      cache.deleted_vertex_array( page->vao );
+    }
+#endif
+    if ( page->vbo != 0 )
+    {
+      glDeleteBuffers( 1, &page->vbo );
+      cache.deleted_buffer( page->vbo );
+    }
+  }
+
+  m_vPages.clear();
+  m_vFree.clear();
+  m_vUsed.clear();
+  m_stats = {};
+}
+
+}
@@ -22,6 +22,9 @@
  *************************************************************************************************/
 
 #include "ure_view_port.h"
+#include "ure_state_cache.h"
+#include "ure_transform_system.h"
+#include "widgets/ure_widget.h"
 
 #if defined(_IMGUI_ENABLED)
 # include "imgui.h"
@@ -33,7 +36,7 @@ namespace ure {
 
 void ViewPort::use() noexcept
 {
-  glViewport( m_pos.x, m_pos.y, m_size.width, m_size.height );
+  StateCache::get_current().viewport( m_pos.x, m_pos.y, m_size.width, m_size.height );
 
 #if defined(_IMGUI_ENABLED)
   // Start the Dear ImGui frame
@@ -60,16 +63,53 @@ bool_t       ViewPort::render() noexcept(true)
 {
   if ( m_scene_graph == nullptr )
     return false;
+
+  // Changes made while rendering, e.g. by widgets still loading, require one more frame.
+  const changes_t changes = get_changes();
+
+  // Blending is set once for the whole pass, draws that do not need it disable it
+  // and draws that need it leave it enabled, so that it is not toggled on each draw.
+  StateCache& state = StateCache::get_current();
+  state.enable     ( GL_BLEND );
+  state.blend_alpha();
   
-  bool_t _retval = m_scene_graph->render( get_projection_matrix().get() );
+  bool_t _retval = ( m_camera != nullptr )? m_scene_graph->render_from( get_projection_matrix().get(), m_camera ) :
+                                            m_scene_graph->render( get_projection_matrix().get() );
 
 #if defined(_IMGUI_ENABLED)
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+  // ImGui works directly on GL state.
+  StateCache::get_current().invalidate();
 #endif
 
+  m_changes = changes;
+  m_dirty   = false;
+
   return _retval;
 }
 
+bool_t       ViewPort::needs_render() const noexcept(true)
+{
+  if ( m_dirty )
+    return true;
+
+  const changes_t changes = get_changes();
+
+  return ( changes.widgets    != m_changes.widgets    ) ||
+         ( changes.cameras    != m_changes.cameras    ) ||
+         ( changes.transforms != m_changes.transforms );
+}
+
+ViewPort::changes_t  ViewPort::get_changes() noexcept(true)
+{
+  return changes_t{ 
+                    widgets::Widget::get_changes(), 
+                    Camera::get_changes(), 
+                    TransformSystem::is_valid()?TransformSystem::get_instance()->get_changes():0 
+                  };
+}
+
 
 }
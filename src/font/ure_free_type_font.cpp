@@ -27,8 +27,6 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include FT_STROKER_H
-#include FT_GLYPH_H
 
 namespace ure {
 
@@ -86,77 +84,59 @@ Text*       FreeTypeFont::get_text( const std::wstring& sText, const glm::vec4&
   if ( sText.empty() == true )
     return nullptr;
   
-  std::vector<FT_Glyph>   glyphs;
-  const wchar_t *         pBuffer = sText.c_str();
-  std::size_t             iChars  = sText.length();
-  FT_Error                error   = 0;
-  Size                    size(0,0) ;
-  
-  while ( iChars-- )
-  {
-    FT_Glyph pGlyph = nullptr;
-    
-    error = FT_Load_Char ( m_face, *pBuffer++, FT_LOAD_RENDER );
-    if ( error == 0 )
-    {
-      error = FT_Get_Glyph( m_face->glyph, &pGlyph );
-      if ( error == 0 )
-      {
-        // convert to a bitmap (default render mode + destroying old)  
-        if ( pGlyph->format != FT_GLYPH_FORMAT_BITMAP )                 
-        {
-          error = FT_Glyph_To_Bitmap( &pGlyph, FT_RENDER_MODE_NORMAL, 0, 1 );                          
-	      }
-	      
-        // access bitmap content by typecasting                        
-        FT_BitmapGlyph bmpGlyph = (FT_BitmapGlyph)pGlyph;  
-	
-        ///////////
-        // Update bounding rect
-	      size.width  += (pGlyph->advance.x >> 16);
-        size.height = std::max( size.height, (GLsizei)bmpGlyph->bitmap.rows );
-      
-        glyphs.push_back( pGlyph );
-      }
-    }     
-  } //while ( iChars-- )
-  
-  ///////////////////
-  // Create new texture in order to store all characters
-  // @todo create an image before and then generate a texture in order to have under control lifecycle of ont and to reduce transfers to the GPU.
-  Texture* pTexture = new(std::nothrow) Texture( size.width + m_left + m_right, size.height + m_top  + m_bottom, Texture::format_t::eRGBA, Texture::type_t::eUnsignedByte );
-  if (pTexture==nullptr)
+  GlyphAtlas* pAtlas = get_atlas();
+  if ( pAtlas == nullptr )
     return nullptr;
-  
-  uint8_t* pTextureData = pTexture->get_pixels();  
-  
-  sizei_t  width = pTexture->get_size().width;  
-  sizei_t  xPos  = m_left;
-  for ( auto g : glyphs )
+
+  // Vertical metrics for current size, from 26.6 fixed point.
+  const int_t             ascender  =  (m_face->size->metrics.ascender  >> 6);
+  const int_t             descender = -(m_face->size->metrics.descender >> 6);
+  std::vector<Text::glyph_t>  glyphs;
+  int_t                   xPos      = m_left;
+  uint_t                  previous  = 0;
+
+  glyphs.reserve( sText.length() );
+
+  // Glyphs must be all available before taking the texture, since atlas could grow.
+  for ( wchar_t ch : sText )
   {
-    // access bitmap content by typecasting                        
-    FT_BitmapGlyph bmpGlyph = (FT_BitmapGlyph)g;
-    FT_Bitmap&     bmp      = (bmpGlyph->bitmap);
-    
-    int yOffset = (size.height - bmpGlyph->top) + m_top;
+    get_glyph( *pAtlas, static_cast<uint32_t>(ch) );
+  }
+
+  const Texture*  pTexture = pAtlas->get_texture().get();
+  const float_t   width    = (float_t)pTexture->get_size().width;
+  const float_t   height   = (float_t)pTexture->get_size().height;
 
-    for ( unsigned int y = 0; y < bmp.rows; y++ )
+  for ( wchar_t ch : sText )
+  {
+    const GlyphAtlas::glyph_t* pGlyph = pAtlas->find( static_cast<uint32_t>(ch) );
+    if ( pGlyph == nullptr )
+      continue;
+
+    if ( previous != 0 )
+      xPos += get_kerning( *pAtlas, previous, pGlyph->index );
+    
+    if ( ( pGlyph->width > 0 ) && ( pGlyph->height > 0 ) )
     {
-      memcpy( &(pTextureData[((y+yOffset)*width)+(xPos+bmpGlyph->left)]), &(bmp.buffer[y*bmp.width]), bmp.width );
+      Text::glyph_t glyph;
+
+      glyph.min    = glm::vec2( xPos + pGlyph->left, m_top + ascender - pGlyph->top );
+      glyph.max    = glyph.min + glm::vec2( pGlyph->width, pGlyph->height );
+      glyph.uv_min = glm::vec2( pGlyph->x / width, pGlyph->y / height );
+      glyph.uv_max = glm::vec2( (pGlyph->x + pGlyph->width) / width, (pGlyph->y + pGlyph->height) / height );
+
+      glyphs.push_back( glyph );
     }
-    
-    xPos += (g->advance.x >> 16);
-    
-    // Release glyph data
-    FT_Done_Glyph( g );
+
+    xPos    += pGlyph->advance;
+    previous = pGlyph->index;
   }
 
-  Text* pText = new(std::nothrow) Text( pTexture );
+  Size  size( xPos + m_right, m_top + ascender + descender + m_bottom );
+
+  Text* pText = new(std::nothrow) Text( pAtlas->get_texture(), size, std::move(glyphs) );
   if ( pText == nullptr )
-  {
-    delete pTexture;
     return nullptr;
-  }
   
   // Set text foreground color
   pText->set_color( frColor );
@@ -164,6 +144,81 @@ Text*       FreeTypeFont::get_text( const std::wstring& sText, const glm::vec4&
   return pText;
 }
 
+std::size_t FreeTypeFont::get_memory_usage() const noexcept(true)
+{
+  std::size_t _size = 0;
+
+  for ( const auto& [key, atlas] : m_mapAtlas )
+    _size += atlas->get_memory_usage();
+
+  return _size;
+}
+
+GlyphAtlas* FreeTypeFont::get_atlas() noexcept
+{
+  static constexpr sizei_t k_atlas_width      = 512;
+  static constexpr sizei_t k_atlas_height     = 256;
+  static constexpr sizei_t k_atlas_max_height = 4096;
+
+  const uint64_t key = (uint64_t(m_size.width) << 32) | uint32_t(m_size.height);
+
+  std::unique_ptr<GlyphAtlas>& atlas = m_mapAtlas[key];
+  if ( atlas == nullptr )
+    atlas.reset( new(std::nothrow) GlyphAtlas( k_atlas_width, k_atlas_height, k_atlas_max_height ) );
+
+  return atlas.get();
+}
+
+const GlyphAtlas::glyph_t* FreeTypeFont::get_glyph( GlyphAtlas& atlas, uint32_t code ) noexcept
+{
+  const GlyphAtlas::glyph_t* pGlyph = atlas.find( code );
+  if ( pGlyph != nullptr )
+    return pGlyph;
+
+  FT_UInt  index = FT_Get_Char_Index( m_face, code );
+
+  if ( FT_Load_Glyph( m_face, index, FT_LOAD_RENDER ) != 0 )
+    return nullptr;
+
+  FT_GlyphSlot  slot = m_face->glyph;
+  FT_Bitmap&    bmp  = slot->bitmap;
+
+  // Only 8 bits gray bitmaps are supported by the atlas.
+  if ( ( bmp.pixel_mode != FT_PIXEL_MODE_GRAY ) || ( bmp.pitch < 0 ) )
+    return nullptr;
+
+  GlyphAtlas::glyph_t glyph;
+
+  glyph.index   = index;
+  glyph.x       = 0;
+  glyph.y       = 0;
+  glyph.width   = bmp.width;
+  glyph.height  = bmp.rows;
+  glyph.left    = slot->bitmap_left;
+  glyph.top     = slot->bitmap_top;
+  glyph.advance = (slot->advance.x >> 6);
+
+  return atlas.insert( code, glyph, bmp.buffer, bmp.pitch );
+}
+
+int_t       FreeTypeFont::get_kerning( GlyphAtlas& atlas, uint_t left, uint_t right ) noexcept
+{
+  if ( FT_HAS_KERNING( m_face ) == 0 )
+    return 0;
+
+  int_t value = 0;
+  if ( atlas.find_kerning( left, right, value ) )
+    return value;
+
+  FT_Vector  delta;
+  if ( FT_Get_Kerning( m_face, left, right, FT_KERNING_DEFAULT, &delta ) == 0 )
+    value = (delta.x >> 6);
+
+  atlas.set_kerning( left, right, value );
+
+  return value;
+}
+
 }
 
 }
@@ -15,7 +15,7 @@ bool il_init()
   return true;
 }
 
-uint8_t* il_load( const char* filename, unsigned int* size, int* width, int* height )
+uint8_t* il_load( const char* filename, unsigned int* size, int* width, int* height, int* channels )
 {
   if ( filename == NULL )
     return NULL;
@@ -40,8 +40,15 @@ uint8_t* il_load( const char* filename, unsigned int* size, int* width, int* hei
     return NULL;
   }
 
-  /* Convert image to RGBA with unsigned byte data type */
-  ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+  /* Convert image to unsigned byte data type keeping source channels */
+  switch ( ilGetInteger(IL_IMAGE_FORMAT) )
+  {
+    case IL_LUMINANCE      : ilConvertImage(IL_LUMINANCE      , IL_UNSIGNED_BYTE); *channels = 1; break;
+    case IL_LUMINANCE_ALPHA: ilConvertImage(IL_LUMINANCE_ALPHA, IL_UNSIGNED_BYTE); *channels = 2; break;
+    case IL_RGB            :
+    case IL_BGR            : ilConvertImage(IL_RGB            , IL_UNSIGNED_BYTE); *channels = 3; break;
+    default                : ilConvertImage(IL_RGBA           , IL_UNSIGNED_BYTE); *channels = 4; break;
+  }
 
   unsigned char* data = NULL;
   *width    = ilGetInteger(IL_IMAGE_WIDTH);
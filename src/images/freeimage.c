@@ -6,7 +6,7 @@
 #include <stdbool.h>
 
 
-uint8_t* fi_load( const char* filename, unsigned int* size, int* width, int* height )
+uint8_t* fi_load( const char* filename, unsigned int* size, int* width, int* height, int* channels )
 {
   if ( filename == NULL )
     return NULL;
@@ -31,25 +31,63 @@ uint8_t* fi_load( const char* filename, unsigned int* size, int* width, int* hei
     return NULL;
   
   unsigned char* data = NULL;
-  FIBITMAP*      dib  = FreeImage_ConvertTo32Bits(odib);
+  FIBITMAP*      dib  = NULL;
+  
+  // Keep gray and RGB images without adding channels that are not in the source.
+  if ( ( FreeImage_GetBPP(odib) == 8 ) && ( FreeImage_GetColorType(odib) == FIC_MINISBLACK ) )
+  {
+    dib       = FreeImage_Clone(odib);
+    *channels = 1;
+  }
+  else if ( FreeImage_GetBPP(odib) == 24 )
+  {
+    dib       = FreeImage_Clone(odib);
+    *channels = 3;
+  }
+  else
+  {
+    dib       = FreeImage_ConvertTo32Bits(odib);
+    *channels = 4;
+  }
   FreeImage_Unload(odib);
+
+  if ( dib == NULL )
+    return NULL;
  
   *width    = FreeImage_GetWidth(dib);
   *height   = FreeImage_GetHeight(dib);
-  *size     = 4*(*width)*(*height);
+  *size     = (*channels)*(*width)*(*height);
   data      = malloc( *size );
   
-  
-  BYTE* pixels = (BYTE*)FreeImage_GetBits(dib);
+  if ( data == NULL )
+  {
+    FreeImage_Unload(dib);
+    return NULL;
+  }
   
   //FreeImage loads in BGR format, so you need to swap some bytes(Or use GL_BGR).
-  int j = 0;
-  for( j= 0; j< ((*width)*(*height)); j++)
+  int y = 0;
+  int x = 0;
+  int c = *channels;
+  for( y = 0; y < (*height); y++ )
   {
-    data[j*4+0]= pixels[j*4+2];
-    data[j*4+1]= pixels[j*4+1];
-    data[j*4+2]= pixels[j*4+0];
-    data[j*4+3]= pixels[j*4+3];
+    BYTE*          src = (BYTE*)FreeImage_GetScanLine(dib, y);
+    unsigned char* dst = &data[y*(*width)*c];
+    
+    for( x = 0; x < (*width); x++ )
+    {
+      if ( c == 1 )
+      {
+        dst[x] = src[x];
+        continue;
+      }
+      
+      dst[x*c+0]= src[x*c+2];
+      dst[x*c+1]= src[x*c+1];
+      dst[x*c+2]= src[x*c+0];
+      if ( c == 4 )
+        dst[x*c+3]= src[x*c+3];
+    }
   }
 
   FreeImage_Unload(dib);
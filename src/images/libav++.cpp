@@ -14,7 +14,7 @@ bool av_init()
   return true;
 }
 
-uint8_t* av_load( const char* filename, unsigned int* size, int* width, int* height )
+uint8_t* av_load( const char* filename, unsigned int* size, int* width, int* height, int* channels )
 {
   if ( filename == NULL )
     return NULL;
@@ -28,6 +28,7 @@ uint8_t* av_load( const char* filename, unsigned int* size, int* width, int* hei
   
   *width    = avImg.getWidth();
   *height   = avImg.getHeight();  
+  *channels = 4;
   
   _data     = avImg.detachData( 0, &_size );
   *size     = _size;
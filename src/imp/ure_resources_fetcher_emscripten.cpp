@@ -32,6 +32,9 @@ public:
   using http_headers_t     = ResourcesFetcher::http_headers_t;
   using http_body_t        = ResourcesFetcher::http_body_t;
   using http_headers_in_t  = std::vector<const char*>;
+  using request_t          = ResourcesFetcher::request_t;
+  using completion_t       = ResourcesFetcher::completion_t;
+  using body_t             = ResourcesFetcherEvents::body_t;
 
   /***/
   resource_t() = delete;
@@ -43,12 +46,14 @@ public:
                         customer_request_t      cr,
                         const http_headers_t&   headers,
                         const http_body_t&      body,
-                        bool                    verify_ssl
+                        bool                    verify_ssl,
+                        uint32_t                delivery,
+                        request_t               request
                       ) noexcept(true)
     : m_events(events), m_app_id( app_id ), m_name(name), 
       m_type(type), m_cr(cr), m_headers({}),
       m_body({}), m_body_internal( body ),
-      m_verify_ssl(verify_ssl)
+      m_verify_ssl(verify_ssl), m_delivery(delivery), m_request(request)
   {
     if ( headers.empty() == false )
     {
@@ -70,12 +75,14 @@ public:
                         customer_request_t      cr,
                         http_headers_t&&        headers,
                         http_body_t&&           body,
-                        bool                    verify_ssl
+                        bool                    verify_ssl,
+                        uint32_t                delivery,
+                        request_t               request
                       ) noexcept(true)
     : m_events(events), m_app_id(std::move(app_id)), m_name(std::move(name)),
       m_type(type), m_cr(cr), m_headers( headers ),
       m_body( std::move(body) ), m_body_internal( m_body ),
-      m_verify_ssl(verify_ssl)
+      m_verify_ssl(verify_ssl), m_delivery(delivery), m_request(request)
   {
     if ( m_headers.empty() == false )
     {
@@ -113,6 +120,58 @@ public:
   /***/
   constexpr bool                     verify_ssl() const noexcept(true)
   { return m_verify_ssl; }
+  /***/
+  constexpr uint32_t                 delivery() const noexcept(true)
+  { return m_delivery; }
+  /***/
+  constexpr request_t                request() const noexcept(true)
+  { return m_request; }
+
+  /**
+   * Remove the request from the fetcher, return false if it has been cancelled
+   * so that no notification must be delivered.
+   */
+  bool_t                             release() const noexcept(true)
+  { 
+    ResourcesFetcher* _fetcher = ResourcesFetcher::get_instance();
+    return _fetcher->release( m_request, _fetcher->get_dispatch() ); 
+  }
+
+  /**
+   * Queue a completion for ResourcesFetcher::dispatch(), return false when dispatch
+   * is not enabled or the completion cannot be queued, so that it must be notified 
+   * directly; in that case \param body is left to the caller.
+   */
+  bool_t                             post( completion_t::kind_t kind, body_t&& body ) const noexcept(true)
+  {
+    ResourcesFetcher* _fetcher = ResourcesFetcher::get_instance();
+    if ( _fetcher->get_dispatch() == false )
+    {
+      _fetcher->unpost( m_request );
+      return false;
+    }
+
+    completion_t* _completion = new(std::nothrow) completion_t( m_events, m_request, m_app_id, m_name, m_cr, m_type, kind );
+    if ( _completion == nullptr )
+    {
+      _fetcher->unpost( m_request );
+      return false;
+    }
+
+    uint_t _length = body.length();
+    _completion->m_body.attach( body.detach(), _length );
+
+    if ( _fetcher->post( _completion ) == false )
+    {
+      _length = _completion->m_body.length();
+      body.attach( _completion->m_body.detach(), _length );
+      delete _completion;
+
+      _fetcher->unpost( m_request );
+      return false;
+    }
+    return true;
+  }
 
 private:
   ResourcesFetcherEvents&  m_events;
@@ -125,23 +184,59 @@ private:
   const http_body_t        m_body;
   const http_body_t&       m_body_internal;
   bool                     m_verify_ssl;
+  uint32_t                 m_delivery;
+  const request_t          m_request;
 };
 
+/* Fetches in progress, used to abort them; callbacks are executed by the main thread */
+static std::unordered_map<ResourcesFetcher::request_t, emscripten_fetch_t*>  s_fetches;
+
 static void_t emscripten_download_succeeded(emscripten_fetch_t *fetch) noexcept(true)
 {
-  printf("Finished downloading %llu bytes from URL %s.\n", fetch->numBytes, fetch->url);
-
   if ( fetch->userData != nullptr ) 
   {
     std::unique_ptr<resource_t> _resource =  std::unique_ptr<resource_t>( reinterpret_cast<resource_t*>(fetch->userData) );
 
-    _resource->events().on_download_succeeded( _resource->app_id(), _resource->name(), _resource->cr(), _resource->type(), (const byte_t*)fetch->data, fetch->numBytes );
+    s_fetches.erase( _resource->request() );
+    _resource->release();
 
-    if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
+    ResourcesFetcherEvents& _events = _resource->events();
+    const byte_t*           _data   = (const byte_t*)fetch->data;
+
+    /* Body is owned by the browser fetch, so chunks are notified once completed and moving requires a copy */
+    if ( _resource->delivery() & edfStream )
     {
-      //@todo
+      _events.on_download_progress( _resource->app_id(), _resource->name(), _resource->cr(), fetch->numBytes, fetch->numBytes );
+      _events.on_download_chunk   ( _resource->app_id(), _resource->name(), _resource->cr(), _data, fetch->numBytes );
     }
 
+    const bool_t _moved    = ( _resource->delivery() & edfMove );
+    const bool_t _dispatch = ResourcesFetcher::get_instance()->get_dispatch();
+    /* Bodies only streamed are not delivered at completion */
+    const bool_t _complete = _moved || ( ( _resource->delivery() & edfStream ) == 0 );
+
+    if ( _moved || _dispatch )
+    {
+      resource_t::body_t _body;
+      if ( _complete && ( fetch->numBytes > 0 ) )
+        _body.copy( _data, fetch->numBytes );
+
+      if ( _dispatch && _resource->post( _moved?resource_t::completion_t::kind_t::eMoved:resource_t::completion_t::kind_t::eSucceeded, std::move(_body) ) )
+      {
+        emscripten_fetch_close(fetch);
+        return;
+      }
+
+      if ( _moved )
+        _events.on_download_moved( _resource->app_id(), _resource->name(), _resource->cr(), _resource->type(), std::move(_body) );
+      else
+        _events.on_download_succeeded( _resource->app_id(), _resource->name(), _resource->cr(), _resource->type(), _body.data(), _body.length() );
+    }
+    else
+    {
+      _events.on_download_succeeded( _resource->app_id(), _resource->name(), _resource->cr(), _resource->type(), 
+                                     _complete?_data:nullptr, _complete?fetch->numBytes:0 );
+    }
   }
 
   // The data is now available at fetch->data[0] through fetch->data[fetch->numBytes-1];
@@ -150,53 +245,75 @@ static void_t emscripten_download_succeeded(emscripten_fetch_t *fetch) noexcept(
 
 static void_t emscripten_download_failed(emscripten_fetch_t *fetch) noexcept(true)
 {
-  printf("Downloading %s failed, HTTP failure status code: %d.\n", fetch->url, fetch->status);
-
   if ( fetch->userData != nullptr ) 
   {
     std::unique_ptr<resource_t> _resource =  std::unique_ptr<resource_t>( (resource_t*)fetch->userData );
 
-    _resource->events().on_download_failed( _resource->app_id(), _resource->name(), _resource->cr() );
+    s_fetches.erase( _resource->request() );
+    _resource->release();
 
-    if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
-    {
-      //@todo
-    } 
+    if ( _resource->post( resource_t::completion_t::kind_t::eFailed, resource_t::body_t() ) == false )
+      _resource->events().on_download_failed( _resource->app_id(), _resource->name(), _resource->cr() );
   }
 
   emscripten_fetch_close(fetch); // Also free data on failure.
 }
 
-bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
-                                const std::string&      app_id,
-                                const std::string&      name, 
-                                const std::type_info&   type, 
-                                const std::string&      url, 
-                                customer_request_t      cr,
-                                const http_headers_t&   headers,
-                                const http_body_t&      body,
-                                bool                    verify_ssl
-                              ) noexcept(true)
+ResourcesFetcher::stats_t ResourcesFetcher::get_stats() const noexcept(true)
+{
+  /* Connections are managed by the browser */
+  return stats_t{ 0, 0, 0, 0 };
+}
+
+void_t ResourcesFetcher::set_max_transfers( uint32_t max_transfers, uint32_t max_host_transfers ) noexcept(true)
+{
+  /* Values are only reported, connections are limited by the browser */
+  m_max_transfers      = (max_transfers      > 0)?max_transfers:1; 
+  m_max_host_transfers = (max_host_transfers > 0)?max_host_transfers:1; 
+}
+
+bool_t ResourcesFetcher::set_cache( [[maybe_unused]] const std::string& path, [[maybe_unused]] uint64_t max_bytes ) noexcept(true)
+{
+  /* Responses are cached by the browser */
+  return false;
+}
+
+void_t ResourcesFetcher::reset_stats() noexcept(true)
+{
+}
+
+ResourcesFetcher::request_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
+                                                     const std::string&      app_id,
+                                                     const std::string&      name, 
+                                                     const std::type_info&   type, 
+                                                     const std::string&      url, 
+                                                     customer_request_t      cr,
+                                                     const http_headers_t&   headers,
+                                                     const http_body_t&      body,
+                                                     bool                    verify_ssl,
+                                                     uint32_t                delivery,
+                                                     int32_t                 priority,
+                                                     uint32_t                deadline
+                                                   ) noexcept(true)
 {
   if ( name.empty() || url.empty() )
-    return false;
+    return k_invalid_request;
 
-  std::string     _name = core::utils::format( "%s:%s:%s", to_string_view(cr).data(), name.c_str(), app_id.c_str() );
+  request_t       _request = k_invalid_request;
   std::lock_guard _mtx(m_mtx_fetch);
 
   /***/
-  if ( m_fetching.contains( _name ) == true )
-    return true;
+  if ( add_request( get_key( app_id, name, cr ), _request ) == false )
+    return _request;
 
-  resource_t* _resource = new(std::nothrow)resource_t( events, app_id, name, type, cr, headers, body, verify_ssl );
+  resource_t* _resource = new(std::nothrow)resource_t( events, app_id, name, type, cr, headers, body, verify_ssl, delivery, _request );
   if ( _resource == nullptr )
   {
-    return false;
+    m_fetching.erase( m_requests[_request] );
+    m_requests.erase( _request );
+    return k_invalid_request;
   }
 
-  /***/
-  m_fetching.insert(_name);
-
   emscripten_fetch_attr_t attr;
   emscripten_fetch_attr_init(&attr);
   strcpy(attr.requestMethod, ResourcesFetcher::to_string_view(cr).data() );
@@ -216,41 +333,50 @@ bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
   attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
   attr.onsuccess  = emscripten_download_succeeded;
   attr.onerror    = emscripten_download_failed;
-  emscripten_fetch(&attr, url.c_str() );
+  /* Browser aborts the fetch, and onerror is called, when deadline expires */
+  attr.timeoutMSecs = deadline;
 
-  return true;
+  /* Priority is not available, browser schedules requests by itself */
+  (void)priority;
+  emscripten_fetch_t* _fetch = emscripten_fetch(&attr, url.c_str() );
+  if ( _fetch != nullptr )
+    s_fetches[_request] = _fetch;
+
+  return _request;
 } 
 
-bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events, 
-                                std::string&&           app_id,
-                                std::string&&           name, 
-                                const std::type_info&   type, 
-                                std::string&&           url, 
-                                customer_request_t      cr,
-                                http_headers_t&&        headers,
-                                http_body_t&&           body,
-                                bool                    verify_ssl
-                              ) noexcept(true)
+ResourcesFetcher::request_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events, 
+                                                     std::string&&           app_id,
+                                                     std::string&&           name, 
+                                                     const std::type_info&   type, 
+                                                     std::string&&           url, 
+                                                     customer_request_t      cr,
+                                                     http_headers_t&&        headers,
+                                                     http_body_t&&           body,
+                                                     bool                    verify_ssl,
+                                                     uint32_t                delivery,
+                                                     int32_t                 priority,
+                                                     uint32_t                deadline
+                                                   ) noexcept(true)
 {
   if ( name.empty() || url.empty() )
-    return false;
+    return k_invalid_request;
 
-  std::string     _name = core::utils::format( "%s:%s:%s", to_string_view(cr).data(), name.c_str(), app_id.c_str() );
+  request_t       _request = k_invalid_request;
   std::lock_guard _mtx(m_mtx_fetch);
 
   /***/
-  if ( m_fetching.contains( _name ) == true )
-    return true;
+  if ( add_request( get_key( app_id, name, cr ), _request ) == false )
+    return _request;
 
-  resource_t* _resource = new(std::nothrow)resource_t( events, std::move(app_id), std::move(name), type, cr, std::move(headers), std::move(body), verify_ssl );
+  resource_t* _resource = new(std::nothrow)resource_t( events, std::move(app_id), std::move(name), type, cr, std::move(headers), std::move(body), verify_ssl, delivery, _request );
   if ( _resource == nullptr )
   {
-    return false;
+    m_fetching.erase( m_requests[_request] );
+    m_requests.erase( _request );
+    return k_invalid_request;
   }
 
-  /***/
-  m_fetching.insert(_name);
-
   emscripten_fetch_attr_t attr;
   emscripten_fetch_attr_init(&attr);
   strcpy(attr.requestMethod, ResourcesFetcher::to_string_view(cr).data() );
@@ -270,17 +396,53 @@ bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
   attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
   attr.onsuccess  = emscripten_download_succeeded;
   attr.onerror    = emscripten_download_failed;
-  emscripten_fetch(&attr, url.c_str() );
+  /* Browser aborts the fetch, and onerror is called, when deadline expires */
+  attr.timeoutMSecs = deadline;
 
-  return true;
+  /* Priority is not available, browser schedules requests by itself */
+  (void)priority;
+  emscripten_fetch_t* _fetch = emscripten_fetch(&attr, url.c_str() );
+  if ( _fetch != nullptr )
+    s_fetches[_request] = _fetch;
+
+  return _request;
 } 
 
+bool_t ResourcesFetcher::set_priority( request_t request, [[maybe_unused]] int32_t priority ) noexcept(true)
+{
+  std::lock_guard _mtx(m_mtx_fetch);
+  return m_requests.contains( request );
+}
+
+bool_t ResourcesFetcher::cancel( request_t request ) noexcept(true)
+{
+  /* Completion can be still waiting for dispatch() */
+  if ( release( request ) == false )
+    return unpost( request );
+
+  auto iter = s_fetches.find( request );
+  if ( iter != s_fetches.end() )
+  {
+    emscripten_fetch_t* _fetch = iter->second;
+    s_fetches.erase( iter );
+
+    /* No callback will be notified for the aborted fetch */
+    delete reinterpret_cast<resource_t*>(_fetch->userData);
+    _fetch->userData = nullptr;
+    emscripten_fetch_close( _fetch );
+  }
+
+  return true;
+}
+
 void_t ResourcesFetcher::on_initialize() noexcept(true)
 {
 }
 
 void_t ResourcesFetcher::on_finalize() noexcept(true)
 {
+  /* Completions not dispatched yet are dropped */
+  clear_completions();
 }
 
 }
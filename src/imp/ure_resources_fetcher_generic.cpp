@@ -22,14 +22,24 @@
  *************************************************************************************************/
 
 #include "ure_resources_fetcher.h"
+#include "ure_http_cache.h"
 
 #include <core/utils.h>
-#include <mailbox.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <thread>
-#include <future>
 #include <memory>
+#include <mutex>
+#include <cctype>
 #include <cstring>
+#include <ctime>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <curl/curl.h>
 
@@ -43,6 +53,10 @@ public:
   using http_headers_t     = ResourcesFetcher::http_headers_t;
   using http_body_t        = ResourcesFetcher::http_body_t;
   using http_headers_in_t  = std::vector<const char*>;
+  using request_t          = ResourcesFetcher::request_t;
+  using completion_t       = ResourcesFetcher::completion_t;
+  using body_t             = ResourcesFetcherEvents::body_t;
+  using clock_t            = std::chrono::steady_clock;
 
   /***/
   resource_t() = delete;
@@ -55,13 +69,19 @@ public:
                         customer_request_t      cr,
                         const http_headers_t&   headers,
                         const http_body_t&      body,
-                        bool                    verify_ssl
+                        bool                    verify_ssl,
+                        uint32_t                delivery,
+                        request_t               request,
+                        int32_t                 priority,
+                        uint32_t                deadline
                       ) noexcept(true)
     : m_events(events), m_app_id(app_id), m_name(name),
       m_type(type), m_url(url),
       m_cr(cr), m_headers({}),
       m_body({}), m_body_internal( body ),
-      m_verify_ssl(verify_ssl)
+      m_verify_ssl(verify_ssl), m_delivery(delivery),
+      m_request(request), m_priority(priority),
+      m_deadline( (deadline > 0)?clock_t::now() + std::chrono::milliseconds(deadline):clock_t::time_point() )
   {
     m_headers_internal.reserve( headers.size() );
     for ( auto& str : headers )
@@ -79,13 +99,19 @@ public:
                         customer_request_t      cr,
                         http_headers_t&&        headers,
                         http_body_t&&           body,
-                        bool                    verify_ssl
+                        bool                    verify_ssl,
+                        uint32_t                delivery,
+                        request_t               request,
+                        int32_t                 priority,
+                        uint32_t                deadline
                       ) noexcept(true)
     : m_events(events), m_app_id( std::move(app_id) ), m_name( std::move(name) ),
       m_type(type), m_url( std::move(url) ),
       m_cr(cr), m_headers( headers ),
       m_body( std::move(body) ), m_body_internal( m_body ),
-      m_verify_ssl(verify_ssl)
+      m_verify_ssl(verify_ssl), m_delivery(delivery),
+      m_request(request), m_priority(priority),
+      m_deadline( (deadline > 0)?clock_t::now() + std::chrono::milliseconds(deadline):clock_t::time_point() )
   {
     m_headers_internal.reserve( m_headers.size() );
     for ( auto& str : m_headers )
@@ -121,6 +147,83 @@ public:
   /***/
   constexpr bool                     verify_ssl() const noexcept(true)
   { return m_verify_ssl; }
+  /***/
+  constexpr uint32_t                 delivery() const noexcept(true)
+  { return m_delivery; }
+  /***/
+  constexpr request_t                request() const noexcept(true)
+  { return m_request; }
+  /***/
+  constexpr int32_t                  priority() const noexcept(true)
+  { return m_priority; }
+  /***/
+  constexpr void_t                   set_priority( int32_t priority ) noexcept(true)
+  { m_priority = priority; }
+  /***/
+  constexpr bool_t                   has_deadline() const noexcept(true)
+  { return m_deadline != clock_t::time_point(); }
+  /***/
+  constexpr clock_t::time_point      deadline() const noexcept(true)
+  { return m_deadline; }
+
+  /**
+   * Remove the request from the fetcher, return false if it has been cancelled
+   * so that no notification must be delivered.
+   */
+  bool_t                             release() const noexcept(true)
+  { 
+    ResourcesFetcher* _fetcher = ResourcesFetcher::get_instance();
+    return _fetcher->release( m_request, _fetcher->get_dispatch() ); 
+  }
+
+  /**
+   * Return true if callbacks can still be notified, must be called with notify() lock held.
+   */
+  bool_t                             is_active() const noexcept(true)
+  { return ResourcesFetcher::get_instance()->is_active( m_request ); }
+
+  /**
+   * Lock held by the I/O thread while notifying callbacks, so that cancel() 
+   * can wait for a callback in progress.
+   */
+  std::unique_lock<std::recursive_mutex> notify() const noexcept(true)
+  { return std::unique_lock<std::recursive_mutex>( ResourcesFetcher::get_instance()->m_mtx_notify ); }
+
+  /**
+   * Queue a completion for ResourcesFetcher::dispatch(), return false when dispatch
+   * is not enabled or the completion cannot be queued, so that it must be notified 
+   * directly; in that case \param body is left to the caller.
+   */
+  bool_t                             post( completion_t::kind_t kind, body_t&& body ) const noexcept(true)
+  {
+    ResourcesFetcher* _fetcher = ResourcesFetcher::get_instance();
+    if ( _fetcher->get_dispatch() == false )
+    {
+      _fetcher->unpost( m_request );
+      return false;
+    }
+
+    completion_t* _completion = new(std::nothrow) completion_t( m_events, m_request, m_app_id, m_name, m_cr, m_type, kind );
+    if ( _completion == nullptr )
+    {
+      _fetcher->unpost( m_request );
+      return false;
+    }
+
+    uint_t _length = body.length();
+    _completion->m_body.attach( body.detach(), _length );
+
+    if ( _fetcher->post( _completion ) == false )
+    {
+      _length = _completion->m_body.length();
+      body.attach( _completion->m_body.detach(), _length );
+      delete _completion;
+
+      _fetcher->unpost( m_request );
+      return false;
+    }
+    return true;
+  }
 
 private:
   ResourcesFetcherEvents&  m_events;
@@ -134,52 +237,235 @@ private:
   const http_body_t        m_body;
   const http_body_t&       m_body_internal;
   const bool               m_verify_ssl;
+  const uint32_t           m_delivery;
+  const request_t          m_request;
+  int32_t                  m_priority;         /* changed by the I/O thread only */
+  const clock_t::time_point m_deadline;
 };
 
 
-using mailbox_type = lock_free::mailbox<resource_t*, core::ds_impl_t::mutex, 0, 
-                                        core::arena_allocator<core::node_t<resource_t*,false,true,false>, uint32_t, 1024, 1024, 0, 0, core::default_allocator<uint32_t>>
-                                        >;
+/* Download buffers kept for next transfers, accessed only by the I/O thread */
+static constexpr std::size_t                 k_max_pooled_buffers = 16;
+static constexpr std::size_t                 k_max_pooled_size    = 4*1024*1024;
+/* Bodies up to this size are copied when moved to consumers, so that buffers stay in the pool */
+static constexpr std::size_t                 k_max_copied_size    = 64*1024;
+static std::vector<std::pair<char*,size_t>>  s_buffers;
 
+/**
+ * Return a pooled buffer with at least \param size bytes, or nullptr if none is available.
+ */
+static char* acquire_buffer( size_t size, size_t& capacity ) noexcept(true)
+{
+  for ( auto iter = s_buffers.begin(); iter != s_buffers.end(); ++iter )
+  {
+    if ( iter->second >= size )
+    {
+      char* _memory = iter->first;
+      capacity = iter->second;
+      s_buffers.erase( iter );
+      return _memory;
+    }
+  }
+  return nullptr;
+}
 
-static mailbox_type*       s_mbx  = nullptr;
-static std::atomic<bool_t> s_exit = false;
-static std::thread         s_scheduler;
-
+/**
+ * Give \param memory back to the pool, or release it when the pool is full or too large.
+ */
+static void_t release_buffer( char* memory, size_t capacity ) noexcept(true)
+{
+  if ( ( s_buffers.size() < k_max_pooled_buffers ) && ( capacity <= k_max_pooled_size ) )
+    s_buffers.emplace_back( memory, capacity );
+  else
+    free( memory );
+}
 
+/***/
 struct MemoryStruct {
   MemoryStruct()
   {
-    memory = nullptr;   /* will be grown as needed by the realloc above */
-    size   = 0;         /* no data at this point */
+    memory   = nullptr;   /* will be grown as needed by reserve() */
+    size     = 0;         /* no data at this point */
+    capacity = 0;
   }
   ~MemoryStruct()
   {
     if ( memory != nullptr )
     {
-      free(memory);
-      memory = nullptr;
-      size   = 0;         /* no data at this point */
+      release_buffer( memory, capacity );
+      memory   = nullptr;
+      size     = 0;         /* no data at this point */
+      capacity = 0;
+    }
+  }
+
+  /**
+   * Make room for \param required bytes plus the terminator. Capacity grows geometrically,
+   * so a body received in many chunks is not reallocated for each of them.
+   */
+  bool_t reserve( size_t required )
+  {
+    if ( required + 1 <= capacity )
+      return true;
+
+    size_t _capacity = std::max( required + 1, capacity + capacity/2 );
+
+    if ( memory == nullptr )
+    {
+      memory = acquire_buffer( _capacity, capacity );
+      if ( memory != nullptr )
+        return true;
+    }
+
+    char* ptr = static_cast<char*>(std::realloc(memory, _capacity));
+    if ( ptr == nullptr )
+      return false;
+
+    memory   = ptr;
+    capacity = _capacity;
+    return true;
+  }
+
+  /**
+   * Release ownership of the memory to the caller, unused capacity is given back 
+   * to the allocator first, so that a large buffer is not kept for a small body.
+   */
+  char* detach()
+  {
+    if ( ( memory != nullptr ) && ( capacity > size + 1 ) )
+    {
+      char* ptr = static_cast<char*>(std::realloc(memory, size + 1));
+      if ( ptr != nullptr )
+        memory = ptr;
     }
+
+    char* _memory = memory;
+    memory   = nullptr;
+    size     = 0;
+    capacity = 0;
+    return _memory;
   }
 
   char *memory;
   size_t size;
+  size_t capacity;
+};
+
+/**
+ * Response headers used by the cache.
+ */
+struct response_t {
+  std::string   etag;
+  std::string   last_modified;
+  std::string   cache_control;
+  std::string   expires;
+  std::string   vary;
+};
+
+/**
+ * Transfer in progress, owned by the I/O thread.
+ */
+struct transfer_t {
+  transfer_t( resource_t* resource, std::string&& host ) noexcept(true)
+    : m_resource( resource ), m_easy_handle( nullptr ), m_headers( nullptr ), m_host( std::move(host) ),
+      m_revalidate( false ), m_keep_body( true )
+  {}
+  ~transfer_t();
+
+  std::unique_ptr<resource_t>   m_resource;
+  CURL*                         m_easy_handle;
+  struct curl_slist*            m_headers;
+  struct MemoryStruct           m_chunk;
+  std::string                   m_host;
+  response_t                    m_response;
+  bool_t                        m_revalidate;       /* conditional request for a cached response */
+  bool_t                        m_keep_body;        /* false when body is only streamed to the consumer */
+};
+
+
+static CURLM*                                s_multi  = nullptr;
+static std::atomic<bool_t>                   s_exit   = false;
+static std::thread                           s_scheduler;
+
+/**
+ * Change requested by set_priority() or cancel() to be applied by the I/O thread.
+ */
+struct command_t {
+  ResourcesFetcher::request_t   request;
+  int32_t                       priority;
+  bool_t                        cancel;
 };
 
+/* Requests submitted by fetch() and not yet started by the I/O thread */
+static std::mutex                            s_mtx_pending;
+static std::deque<resource_t*>               s_pending;
+static std::vector<command_t>                s_commands;
+
+/* Following are accessed only by the I/O thread */
+static CURLSH*                               s_share  = nullptr;
+static std::vector<CURL*>                    s_handles;
+static std::deque<resource_t*>               s_queued;         /* sorted by priority, then by submission */
+static std::unordered_set<transfer_t*>       s_transfers;
+static std::unordered_map<std::string, uint32_t> s_host_transfers;
+static uint32_t                              s_applied_max_transfers      = 0;
+static uint32_t                              s_applied_max_host_transfers = 0;
+
+/* On-disk cache set by set_cache(), guarded by s_mtx_pending, and the copy used by the I/O thread */
+static std::shared_ptr<HttpCache>            s_cache;
+static std::shared_ptr<HttpCache>            s_cache_io;
+static std::time_t                           s_cache_flush = 0;
+
+
+static std::atomic<uint32_t>                 s_new_connections    = 0;
+static std::atomic<uint32_t>                 s_reused_connections = 0;
+static std::atomic<uint32_t>                 s_cache_hits         = 0;
+static std::atomic<uint32_t>                 s_cache_revalidations= 0;
+
+
+transfer_t::~transfer_t()
+{
+  /* keep easy handle, with its state, for next transfers */
+  if ( m_easy_handle != nullptr )
+  {
+    if ( s_handles.size() < ResourcesFetcher::get_instance()->get_max_transfers() )
+      s_handles.push_back( m_easy_handle );
+    else
+      curl_easy_cleanup( m_easy_handle );
+  }
+  /* release previous allocated memory */
+  curl_slist_free_all( m_headers );
+}
+
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) noexcept(true)
 {
-  size_t realsize = size * nmemb;
-  struct MemoryStruct *mem = (struct MemoryStruct *)userp;
- 
-  char *ptr = static_cast<char*>(std::realloc(mem->memory, mem->size + realsize + 1));
-  if(!ptr) {
-    // out of memory! 
-    printf("not enough memory (realloc returned NULL)\n");
-    return 0;
+  size_t       realsize  = size * nmemb;
+  transfer_t*  transfer  = static_cast<transfer_t*>(userp);
+  resource_t*  resource  = transfer->m_resource.get();
+  MemoryStruct *mem      = &transfer->m_chunk;
+
+  if ( resource->delivery() & edfStream )
+  {
+    auto _notify = resource->notify();
+    if ( ( resource->is_active() == false ) ||
+         ( resource->events().on_download_chunk( resource->app_id(), resource->name(), resource->cr(), (const byte_t*)contents, (uint_t)realsize ) == false ) )
+      return 0;
+  }
+
+  if ( transfer->m_keep_body == false )
+    return realsize;
+
+  /* Preallocate whole body when length is known */
+  if ( mem->memory == nullptr )
+  {
+    curl_off_t _length = -1;
+    if ( ( curl_easy_getinfo( transfer->m_easy_handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &_length ) == CURLE_OK ) && ( _length > 0 ) )
+      mem->reserve( (size_t)_length );
   }
+
+  /* Out of memory, transfer is aborted and notified as failed */
+  if ( mem->reserve( mem->size + realsize ) == false )
+    return 0;
  
-  mem->memory = ptr;
   std::memcpy(&(mem->memory[mem->size]), contents, realsize);
   mem->size += realsize;
   mem->memory[mem->size] = 0;
@@ -187,39 +473,333 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
   return realsize;
 }
 
-static void_t async_curl_download( resource_t* resource ) noexcept(true)
+/**
+ * Notify progress for streamed downloads.
+ */
+static int ProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t /*ultotal*/, curl_off_t /*ulnow*/) noexcept(true)
 {
-  std::unique_ptr<resource_t>   _resource    = std::unique_ptr<resource_t>(resource);
-  CURL *                        _easy_handle = curl_easy_init();
+  resource_t* resource = static_cast<resource_t*>(clientp);
 
-  struct MemoryStruct           _chunk;
- 
-  if ( _easy_handle == nullptr )
+  auto _notify = resource->notify();
+  if ( resource->is_active() == false )
+    return 1;
+
+  if ( resource->events().on_download_progress( resource->app_id(), resource->name(), resource->cr(), (uint64_t)dlnow, (uint64_t)dltotal ) == false )
+    return 1;
+
+  return 0;
+}
+
+/**
+ * Collect response headers required by the cache.
+ */
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userdata) noexcept(true)
+{
+  size_t       realsize = size * nitems;
+  response_t*  response = static_cast<response_t*>(userdata);
+  std::string_view line( buffer, realsize );
+
+  /* A new status line starts headers of a new response, as with redirects */
+  if ( line.starts_with( "HTTP/" ) )
   {
-    _resource->events().on_download_failed( _resource->app_id(), _resource->name(), _resource->cr() );
+    *response = {};
+    return realsize;
+  }
 
-    if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
+  std::size_t colon = line.find( ':' );
+  if ( colon == std::string_view::npos )
+    return realsize;
+
+  std::string name( line.substr( 0, colon ) );
+  std::transform( name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); } );
+
+  std::string_view value = line.substr( colon + 1 );
+  while ( ( value.empty() == false ) && ( ( value.front() == ' ' ) || ( value.front() == '\t' ) ) )
+    value.remove_prefix( 1 );
+  while ( ( value.empty() == false ) && ( ( value.back() == '\r' ) || ( value.back() == '\n' ) || ( value.back() == ' ' ) ) )
+    value.remove_suffix( 1 );
+
+  if ( name == "etag" )
+    response->etag = value;
+  else if ( name == "last-modified" )
+    response->last_modified = value;
+  else if ( name == "cache-control" )
+    response->cache_control = value;
+  else if ( name == "expires" )
+    response->expires = value;
+  else if ( name == "vary" )
+    response->vary = response->vary.empty() ? std::string(value) : response->vary + "," + std::string(value);
+
+  return realsize;
+}
+
+/**
+ * Fill cache \param entry from \param response.
+ * @return false if response must not be stored.
+ */
+static bool_t cache_entry_from( const response_t& response, HttpCache::entry_t& entry ) noexcept(true)
+{
+  const std::time_t now = std::time( nullptr );
+
+  entry.etag          = response.etag;
+  entry.last_modified = response.last_modified;
+  entry.expires       = 0;
+
+  /* Cache-Control takes precedence over Expires, directives are matched as whole tokens 
+     so that the ones for shared caches, such as s-maxage, are ignored */
+  bool_t      no_store = false;
+  bool_t      no_cache = false;
+  long        max_age  = -1;
+
+  std::string_view list( response.cache_control );
+  while ( list.empty() == false )
+  {
+    std::size_t      comma     = list.find( ',' );
+    std::string_view directive = list.substr( 0, comma );
+    list.remove_prefix( ( comma == std::string_view::npos ) ? list.size() : comma + 1 );
+
+    const std::size_t equal = directive.find( '=' );
+    std::string_view  value = ( equal == std::string_view::npos ) ? std::string_view() : directive.substr( equal + 1 );
+    std::string       name( directive.substr( 0, equal ) );
+
+    name.erase( 0, name.find_first_not_of( " \t" ) );
+    name.erase( name.find_last_not_of( " \t" ) + 1 );
+    std::transform( name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); } );
+
+    if ( name == "no-store" )
+      no_store = true;
+    else if ( name == "no-cache" )
+      no_cache = true;
+    else if ( name == "max-age" )
     {
-      //@todo
-    } 
+      /* value can be quoted */
+      const std::string digits( value.substr( std::min( value.size(), value.find_first_not_of( " \t\"" ) ) ) );
+      if ( ( digits.empty() == false ) && std::isdigit( (unsigned char)digits[0] ) )
+        max_age = std::strtol( digits.c_str(), nullptr, 10 );
+    }
+  }
+
+  if ( no_store )
+    return false;
+
+  if ( no_cache )
+    return true;
+
+  if ( max_age >= 0 )
+  {
+    entry.expires = now + max_age;
+    return true;
+  }
+
+  if ( response.expires.empty() == false )
+  {
+    std::time_t expires = curl_getdate( response.expires.c_str(), nullptr );
+    entry.expires = ( expires > 0 ) ? expires : 0;
+    return true;
+  }
+
+  /* Heuristic freshness, 10% of the time since last modification */
+  if ( response.last_modified.empty() == false )
+  {
+    std::time_t modified = curl_getdate( response.last_modified.c_str(), nullptr );
+    if ( ( modified > 0 ) && ( modified < now ) )
+      entry.expires = now + ( now - modified ) / 10;
+  }
+
+  return true;
+}
+
+/**
+ * Return true if \param resource can be served or stored by the cache.
+ */
+static bool_t is_cacheable( const resource_t& resource ) noexcept(true)
+{
+  return ( s_cache_io != nullptr ) && ( resource.cr() == customer_request_t::Get ) && resource.body().empty();
+}
+
+/**
+ * Deliver \param data to the consumer according with resource delivery flags. 
+ * When \param owned is provided with edfMove, memory is moved to the consumer without any copy.
+ * Data already notified with chunks is flagged by \param streamed.
+ */
+static void_t deliver_body( resource_t& resource, const byte_t* data, size_t size, MemoryStruct* owned, bool_t streamed ) noexcept(true)
+{
+  const uint32_t _delivery = resource.delivery();
 
+  /* Request has been cancelled in the meantime */
+  auto _notify = resource.notify();
+  if ( resource.release() == false )
     return;
+
+  if ( ( _delivery & edfStream ) && ( streamed == false ) )
+  {
+    resource.events().on_download_progress( resource.app_id(), resource.name(), resource.cr(), size, size );
+    resource.events().on_download_chunk( resource.app_id(), resource.name(), resource.cr(), data, (uint_t)size );
   }
 
-  bool_t options = true;
+  const bool_t _moved    = ( _delivery & edfMove );
+  const bool_t _dispatch = ResourcesFetcher::get_instance()->get_dispatch();
+  /* Bodies only streamed are not delivered at completion */
+  const bool_t _complete = _moved || ( ( _delivery & edfStream ) == 0 );
+
+  if ( _moved || _dispatch )
+  {
+    resource_t::body_t _body;
+    /* Large bodies are moved without any copy, small ones leave their buffer to the pool */
+    if ( _complete && ( owned != nullptr ) && ( owned->memory != nullptr ) && ( owned->size > k_max_copied_size ) )
+    {
+      size_t _size = owned->size;
+      _body.attach( (byte_t*)owned->detach(), (uint_t)_size );
+    }
+    else if ( _complete && ( size > 0 ) )
+    {
+      _body.copy( data, (uint_t)size );
+    }
+
+    if ( _dispatch && resource.post( _moved?resource_t::completion_t::kind_t::eMoved:resource_t::completion_t::kind_t::eSucceeded, std::move(_body) ) )
+      return;
+
+    if ( _moved )
+      resource.events().on_download_moved( resource.app_id(), resource.name(), resource.cr(), resource.type(), std::move(_body) );
+    else
+      resource.events().on_download_succeeded( resource.app_id(), resource.name(), resource.cr(), resource.type(), _body.data(), _body.length() );
+  }
+  else
+  {
+    resource.events().on_download_succeeded( resource.app_id(), resource.name(), resource.cr(), resource.type(), 
+                                              _complete?data:nullptr, _complete?size:0 );
+  }
+}
+
+/**
+ * Deliver body cached for \param resource.
+ */
+static bool_t deliver_cached( resource_t& resource ) noexcept(true)
+{
+  HttpCache::mapped_t _mapped;
+  if ( s_cache_io->open( std::string(resource.url()), resource.headers(), _mapped ) == false )
+    return false;
+
+  deliver_body( resource, _mapped.data(), _mapped.size(), nullptr, false );
+
+  return true;
+}
+
+/**
+ * Return host name, with port if specified, from \param url.
+ */
+static std::string host_from_url( std::string_view url ) noexcept(true)
+{
+  std::size_t _begin = url.find( "://" );
+  _begin = ( _begin == std::string_view::npos ) ? 0 : _begin + 3;
+
+  std::size_t _end   = url.find_first_of( "/?#", _begin );
+  if ( _end == std::string_view::npos )
+    _end = url.length();
+
+  return std::string( url.substr( _begin, _end - _begin ) );
+}
+
+/***/
+static void_t notify_failed( resource_t& resource ) noexcept(true)
+{
+  /* Request has been cancelled in the meantime */
+  auto _notify = resource.notify();
+  if ( resource.release() == false )
+    return;
+
+  if ( resource.post( resource_t::completion_t::kind_t::eFailed, resource_t::body_t() ) )
+    return;
+
+  resource.events().on_download_failed( resource.app_id(), resource.name(), resource.cr() );
+}
+
+/**
+ * Create easy handle for \param transfer and add it to the multi handle.
+ */
+static bool_t start_transfer( transfer_t& transfer ) noexcept(true)
+{
+  resource_t* _resource = transfer.m_resource.get();
+
+  /* Reuse an idle handle when available, options are reset but caches are kept */
+  if ( s_handles.empty() == false )
+  {
+    transfer.m_easy_handle = s_handles.back();
+    s_handles.pop_back();
+
+    curl_easy_reset( transfer.m_easy_handle );
+  }
+  else
+  {
+    transfer.m_easy_handle = curl_easy_init();
+  }
+
+  if ( transfer.m_easy_handle == nullptr )
+    return false;
+
+  CURL*  _easy_handle = transfer.m_easy_handle;
+  bool_t options      = true;
 
   /* Populate CUSTOMER REQUEST */
-  options &= (curl_easy_setopt(_easy_handle, CURLOPT_CUSTOMREQUEST  , ResourcesFetcher::to_string_view( resource->cr()).data() ) == CURLE_OK);
+  options &= (curl_easy_setopt(_easy_handle, CURLOPT_CUSTOMREQUEST  , ResourcesFetcher::to_string_view( _resource->cr()).data() ) == CURLE_OK);
   /* specify URL to get */
   options &= (curl_easy_setopt(_easy_handle, CURLOPT_URL            , _resource->url().data()  ) == CURLE_OK);
   /* send all data to this function  */
   options &= (curl_easy_setopt(_easy_handle, CURLOPT_WRITEFUNCTION  , WriteMemoryCallback      ) == CURLE_OK);
-  /* we pass our 'chunk' struct to the callback function */
-  options &= (curl_easy_setopt(_easy_handle, CURLOPT_WRITEDATA      , (void *)&_chunk          ) == CURLE_OK);
+  /* we pass the transfer to the callback function */
+  options &= (curl_easy_setopt(_easy_handle, CURLOPT_WRITEDATA      , (void *)&transfer        ) == CURLE_OK);
   /* some servers do not like requests that are made without a user-agent field, so we provide one */  
   options &= (curl_easy_setopt(_easy_handle, CURLOPT_USERAGENT      , "libcurl-agent/1.0"      ) == CURLE_OK);
   options &= (curl_easy_setopt(_easy_handle, CURLOPT_FOLLOWLOCATION , 1L                       ) == CURLE_OK);
   options &= (curl_easy_setopt(_easy_handle, CURLOPT_HTTPPROXYTUNNEL, 1L                       ) == CURLE_OK);
+  /* signals cannot be used for timeouts by a thread serving many transfers */
+  options &= (curl_easy_setopt(_easy_handle, CURLOPT_NOSIGNAL       , 1L                       ) == CURLE_OK);
+  /* used to retrieve the transfer when completed */
+  options &= (curl_easy_setopt(_easy_handle, CURLOPT_PRIVATE        , (void *)&transfer        ) == CURLE_OK);
+  /* keep connections alive between requests to the same host */
+  options &= (curl_easy_setopt(_easy_handle, CURLOPT_TCP_KEEPALIVE  , 1L                       ) == CURLE_OK);
+
+  /* Transfer is aborted, and notified as failed, when deadline expires */
+  if ( _resource->has_deadline() )
+  {
+    auto _remaining = std::chrono::duration_cast<std::chrono::milliseconds>( _resource->deadline() - resource_t::clock_t::now() ).count();
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_TIMEOUT_MS , (long)std::max<decltype(_remaining)>( _remaining, 1 ) ) == CURLE_OK);
+  }
+  
+  /* Progress notified only for streamed downloads */
+  if ( _resource->delivery() & edfStream )
+  {
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_XFERINFOFUNCTION, ProgressCallback        ) == CURLE_OK);
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_XFERINFODATA    , (void *)_resource       ) == CURLE_OK);
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_NOPROGRESS      , 0L                      ) == CURLE_OK);
+  }
+
+  /* Body is collected when it has to be delivered at the end or stored in the cache */
+  transfer.m_keep_body = ( ( _resource->delivery() & edfStream ) == 0 ) || 
+                         ( _resource->delivery() & edfMove           ) ||
+                         is_cacheable( *_resource );
+
+  /* Headers used by the cache */
+  if ( is_cacheable( *_resource ) )
+  {
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_HEADERFUNCTION, HeaderCallback                ) == CURLE_OK);
+    options &= (curl_easy_setopt(_easy_handle, CURLOPT_HEADERDATA    , (void *)&transfer.m_response  ) == CURLE_OK);
+
+    const HttpCache::entry_t* _entry = s_cache_io->find( std::string(_resource->url()), _resource->headers() );
+    if ( _entry != nullptr )
+    {
+      if ( _entry->etag.empty() == false )
+        transfer.m_headers = curl_slist_append( transfer.m_headers, core::utils::format( "If-None-Match: %s", _entry->etag.c_str() ).c_str() );
+      if ( _entry->last_modified.empty() == false )
+        transfer.m_headers = curl_slist_append( transfer.m_headers, core::utils::format( "If-Modified-Since: %s", _entry->last_modified.c_str() ).c_str() );
+
+      transfer.m_revalidate = true;
+    }
+  }
+
+  /* DNS and TLS sessions cache shared by all handles */
+  if ( s_share != nullptr )
+  { options &= (curl_easy_setopt(_easy_handle, CURLOPT_SHARE, s_share) == CURLE_OK); }
 
   /* Explicitly disable ssl verification */
   if ( _resource->verify_ssl() == false )
@@ -229,16 +809,15 @@ static void_t async_curl_download( resource_t* resource ) noexcept(true)
   }
   
   /* Set headers */
-  struct curl_slist *_headers = nullptr;
   std::size_t        _ndx  = 0;
   while ( (_resource->headers().size() - _ndx) >= 2 )
   {
-    _headers = curl_slist_append(_headers, core::utils::format( "%s: %s", _resource->headers()[_ndx], _resource->headers()[_ndx+1] ).c_str() );
+    transfer.m_headers = curl_slist_append(transfer.m_headers, core::utils::format( "%s: %s", _resource->headers()[_ndx], _resource->headers()[_ndx+1] ).c_str() );
     _ndx  += 2;
   }
 
-  if ( _headers != nullptr )
-  { options &= (curl_easy_setopt(_easy_handle, CURLOPT_HTTPHEADER, _headers) == CURLE_OK); }
+  if ( transfer.m_headers != nullptr )
+  { options &= (curl_easy_setopt(_easy_handle, CURLOPT_HTTPHEADER, transfer.m_headers) == CURLE_OK); }
 
   /* Set body */
   if ( _resource->body().empty() == false )
@@ -248,145 +827,533 @@ static void_t async_curl_download( resource_t* resource ) noexcept(true)
   }
 
   if ( options == false )
+    return false;
+
+  return ( curl_multi_add_handle( s_multi, _easy_handle ) == CURLM_OK );
+}
+
+/**
+ * Return true if \param lhs must be started before \param rhs.
+ */
+static bool_t queued_before( const resource_t* lhs, const resource_t* rhs ) noexcept(true)
+{
+  if ( lhs->priority() != rhs->priority() )
+    return lhs->priority() > rhs->priority();
+  return lhs->request() < rhs->request();
+}
+
+/**
+ * Apply priority changes and cancellations to queued requests and transfers in progress.
+ */
+static void_t apply_commands( std::vector<command_t>& commands ) noexcept(true)
+{
+  bool_t _sort = false;
+
+  for ( const command_t& _command : commands )
   {
-    _resource->events().on_download_failed( _resource->app_id(), _resource->name(), _resource->cr() );
+    auto iter = std::find_if( s_queued.begin(), s_queued.end(), 
+                              [&_command]( const resource_t* pResource ){ return pResource->request() == _command.request; } );
+    if ( iter != s_queued.end() )
+    {
+      if ( _command.cancel )
+      {
+        delete *iter;
+        s_queued.erase( iter );
+      }
+      else if ( (*iter)->priority() != _command.priority )
+      {
+        (*iter)->set_priority( _command.priority );
+        _sort = true;
+      }
+      continue;
+    }
+
+    if ( _command.cancel == false )
+      continue;
 
-    if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
+    /* Abort transfer in progress */
+    auto transfer = std::find_if( s_transfers.begin(), s_transfers.end(), 
+                                  [&_command]( const transfer_t* pTransfer ){ return pTransfer->m_resource->request() == _command.request; } );
+    if ( transfer != s_transfers.end() )
     {
-      //@todo
+      transfer_t* _transfer = *transfer;
+
+      curl_multi_remove_handle( s_multi, _transfer->m_easy_handle );
+      if ( --s_host_transfers[_transfer->m_host] == 0 )
+        s_host_transfers.erase( _transfer->m_host );
+      s_transfers.erase( transfer );
+
+      delete _transfer;
     }
   }
-  else
+
+  if ( _sort )
+    std::stable_sort( s_queued.begin(), s_queued.end(), queued_before );
+}
+
+/**
+ * Drop queued requests that can no longer be completed before their deadline.
+ */
+static void_t expire_queued() noexcept(true)
+{
+  const resource_t::clock_t::time_point _now = resource_t::clock_t::now();
+
+  auto iter = s_queued.begin();
+  while ( iter != s_queued.end() )
   {
-    /* get it! */
-    CURLcode res = curl_easy_perform(_easy_handle);
-    /* check for errors */
-    if(res != CURLE_OK) 
+    if ( (*iter)->has_deadline() && ( (*iter)->deadline() <= _now ) )
     {
-      fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
+      std::unique_ptr<resource_t> _release( *iter );
+      iter = s_queued.erase( iter );
+
+      notify_failed( *_release );
+      continue;
+    }
+    ++iter;
+  }
+}
+
+/**
+ * Deliver a fresh response for \param pResource from disk, without any transfer.
+ * Return true if \param pResource has been served and released.
+ */
+static bool_t serve_fresh( resource_t* pResource ) noexcept(true)
+{
+  if ( is_cacheable( *pResource ) == false )
+    return false;
+
+  const HttpCache::entry_t* _entry = s_cache_io->find( std::string(pResource->url()), pResource->headers() );
+  if ( ( _entry == nullptr ) || ( _entry->expires <= std::time( nullptr ) ) )
+    return false;
 
-      _resource->events().on_download_failed( _resource->app_id(), _resource->name(), _resource->cr() );
+  if ( deliver_cached( *pResource ) == false )
+    return false;
+
+  s_cache_hits++;
+  delete pResource;
+  return true;
+}
+
+/**
+ * Start queued requests while limits allow it, higher priority first. Requests exceeding 
+ * host limit are skipped, so they don't stall requests to other hosts.
+ * Fresh cached responses are served as soon as requests are submitted, so they never 
+ * take a transfer slot or wait behind transfers in progress.
+ */
+static void_t admit_transfers() noexcept(true)
+{
+  std::deque<resource_t*> _pending;
+  std::vector<command_t>  _commands;
+  {
+    std::lock_guard _mtx( s_mtx_pending );
+    _pending.swap( s_pending );
+    _commands.swap( s_commands );
+  }
+
+  /* Cancelled requests are removed before being served from disk */
+  if ( _commands.empty() == false )
+  {
+    for ( const command_t& _command : _commands )
+    {
+      if ( _command.cancel == false )
+        continue;
 
-      if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
+      auto iter = std::find_if( _pending.begin(), _pending.end(), 
+                                [&_command]( const resource_t* pResource ){ return pResource->request() == _command.request; } );
+      if ( iter != _pending.end() )
       {
-        //@todo
+        delete *iter;
+        _pending.erase( iter );
       }
     }
-    else 
+  }
+
+  for ( resource_t* pResource : _pending )
+  {
+    if ( serve_fresh( pResource ) )
+      continue;
+
+    s_queued.insert( std::upper_bound( s_queued.begin(), s_queued.end(), pResource, queued_before ), pResource );
+  }
+
+  if ( _commands.empty() == false )
+    apply_commands( _commands );
+
+  expire_queued();
+
+  const uint32_t _max_transfers      = ResourcesFetcher::get_instance()->get_max_transfers();
+  const uint32_t _max_host_transfers = ResourcesFetcher::get_instance()->get_max_host_transfers();
+
+  auto iter = s_queued.begin();
+  while ( ( iter != s_queued.end() ) && ( s_transfers.size() < _max_transfers ) )
+  {
+    resource_t* _resource = *iter;
+
+    /* Response stored by a transfer completed while the request was waiting */
+    if ( serve_fresh( _resource ) )
+    {
+      iter = s_queued.erase( iter );
+      continue;
+    }
+
+    std::string _host = host_from_url( _resource->url() );
+
+    auto _host_iter = s_host_transfers.find( _host );
+    if ( ( _host_iter != s_host_transfers.end() ) && ( _host_iter->second >= _max_host_transfers ) )
+    {
+      ++iter;
+      continue;
+    }
+
+    iter = s_queued.erase( iter );
+
+    transfer_t* _transfer = new(std::nothrow) transfer_t( _resource, std::string(_host) );
+    if ( _transfer == nullptr )
     {
-      /*
-      * Now, our chunk.memory points to a memory block that is chunk.size
-      * bytes big and contains the remote file.
-      *
-      * Do something nice with it!
-      */
-      printf("%lu bytes retrieved\n", (unsigned long)_chunk.size);
+      std::unique_ptr<resource_t> _release( _resource );
+      notify_failed( *_release );
+      continue;
+    }
 
-      _resource->events().on_download_succeeded( _resource->app_id(), _resource->name(), _resource->cr(), _resource->type(), (const byte_t*)_chunk.memory, _chunk.size );
+    if ( start_transfer( *_transfer ) == false )
+    {
+      notify_failed( *_transfer->m_resource );
+      delete _transfer;
+      continue;
+    }
 
-      if ( ResourcesFetcher::get_instance()->cancel( _resource->app_id(), _resource->name(), _resource->cr() ) == false )
+    /* Entries are created only for hosts with transfers, and erased when they reach 0 */
+    s_host_transfers[std::move(_host)]++;
+    s_transfers.insert( _transfer );
+  }
+}
+
+/**
+ * Notify completed transfers and release them.
+ */
+static void_t complete_transfers() noexcept(true)
+{
+  CURLMsg* _msg  = nullptr;
+  int      _left = 0;
+
+  while ( ( _msg = curl_multi_info_read( s_multi, &_left ) ) != nullptr )
+  {
+    if ( _msg->msg != CURLMSG_DONE )
+      continue;
+
+    transfer_t* _ptr = nullptr;
+    curl_easy_getinfo( _msg->easy_handle, CURLINFO_PRIVATE, &_ptr );
+    if ( _ptr == nullptr )
+      continue;
+
+    std::unique_ptr<transfer_t> _transfer( _ptr );
+    resource_t*                 _resource = _transfer->m_resource.get();
+    CURLcode                    res       = _msg->data.result;
+
+    curl_multi_remove_handle( s_multi, _transfer->m_easy_handle );
+
+    /* Number of new connections created for the transfer, 0 if an existing one has been used */
+    long _connects = 0;
+    if ( curl_easy_getinfo( _transfer->m_easy_handle, CURLINFO_NUM_CONNECTS, &_connects ) == CURLE_OK )
+    {
+      if ( _connects > 0 )
+        s_new_connections++;
+      else
+        s_reused_connections++;
+    }
+
+    if ( --s_host_transfers[_transfer->m_host] == 0 )
+      s_host_transfers.erase( _transfer->m_host );
+    s_transfers.erase( _ptr );
+
+    long _code = 0;
+    curl_easy_getinfo( _transfer->m_easy_handle, CURLINFO_RESPONSE_CODE, &_code );
+
+    /* check for errors */
+    if(res != CURLE_OK) 
+    {
+      notify_failed( *_resource );
+    }
+    else if ( _transfer->m_revalidate && ( _code == 304 ) && is_cacheable( *_resource ) )
+    {
+      /* Cached body is still valid, only validators and expiration are updated */
+      HttpCache::entry_t _entry;
+      cache_entry_from( _transfer->m_response, _entry );
+      s_cache_io->refresh( std::string(_resource->url()), _resource->headers(), _entry );
+
+      if ( deliver_cached( *_resource ) )
+        s_cache_revalidations++;
+      else
+        notify_failed( *_resource );
+    }
+    else 
+    {
+      if ( ( _code == 200 ) && is_cacheable( *_resource ) )
       {
-        //@todo
-      } 
+        HttpCache::entry_t _entry;
+        if ( cache_entry_from( _transfer->m_response, _entry ) )
+          s_cache_io->store( std::string(_resource->url()), _resource->headers(), _transfer->m_response.vary, 
+                             _entry, (const byte_t*)_transfer->m_chunk.memory, _transfer->m_chunk.size );
+        else
+          s_cache_io->remove( std::string(_resource->url()), _resource->headers() );
+      }
 
+      deliver_body( *_resource, (const byte_t*)_transfer->m_chunk.memory, _transfer->m_chunk.size, &_transfer->m_chunk, true );
     }
   }
+}
 
-  /* cleanup curl stuff */
-  curl_easy_cleanup(_easy_handle);
-  /* release previous allocated memory */
-  curl_slist_free_all(_headers);
+/**
+ * Forward limits changed by set_max_transfers() to the multi handle, so that 
+ * connections opened by curl follow the same limits used to admit transfers.
+ */
+static void_t apply_limits() noexcept(true)
+{
+  const uint32_t _max_transfers      = ResourcesFetcher::get_instance()->get_max_transfers();
+  const uint32_t _max_host_transfers = ResourcesFetcher::get_instance()->get_max_host_transfers();
+
+  if ( _max_transfers != s_applied_max_transfers )
+  {
+    curl_multi_setopt( s_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)_max_transfers );
+    /* Idle connections kept alive for next transfers */
+    curl_multi_setopt( s_multi, CURLMOPT_MAXCONNECTS          , (long)_max_transfers );
+    s_applied_max_transfers = _max_transfers;
+  }
+
+  if ( _max_host_transfers != s_applied_max_host_transfers )
+  {
+    curl_multi_setopt( s_multi, CURLMOPT_MAX_HOST_CONNECTIONS , (long)_max_host_transfers );
+    s_applied_max_host_transfers = _max_host_transfers;
+  }
 }
 
+/**
+ * Single I/O thread driving all transfers.
+ */
 static void_t th_requests_scheduler() noexcept(true)
 {
   while ( s_exit == false )
   {
-    resource_t* pResource = nullptr;
-    if ( s_mbx->read( pResource , 100 ) == core::result_t::eSuccess )
     {
-      auto handle = std::async( async_curl_download, pResource );
+      std::lock_guard _mtx( s_mtx_pending );
+      s_cache_io = s_cache;
+    }
+
+    apply_limits();
+
+    admit_transfers();
+
+    int _running = 0;
+    curl_multi_perform( s_multi, &_running );
+
+    complete_transfers();
+
+    /* Completed transfers leave room for queued requests */
+    if ( s_queued.empty() == false )
+      admit_transfers();
+
+    /* Index is saved from time to time, so a crash will not lose the whole cache */
+    if ( ( s_cache_io != nullptr ) && ( std::time( nullptr ) - s_cache_flush >= 5 ) )
+    {
+      s_cache_io->flush();
+      s_cache_flush = std::time( nullptr );
     }
+
+    /* Wait for activity on transfers, new requests or timeout */
+    curl_multi_poll( s_multi, nullptr, 0, 100, nullptr );
   }
 }
 
-bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
-                                const std::string&      app_id,
-                                const std::string&      name,
-                                const std::type_info&   type,
-                                const std::string&      url,
-                                customer_request_t      cr,
-                                const http_headers_t&   headers,
-                                const http_body_t&      body,
-                                bool                    verify_ssl
-                              ) noexcept(true)
+/**
+ * Queue \param pResource for the I/O thread.
+ */
+static void_t submit( resource_t* pResource ) noexcept(true)
+{
+  {
+    std::lock_guard _mtx( s_mtx_pending );
+    s_pending.push_back( pResource );
+  }
+
+  curl_multi_wakeup( s_multi );
+}
+
+ResourcesFetcher::request_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
+                                                     const std::string&      app_id,
+                                                     const std::string&      name,
+                                                     const std::type_info&   type,
+                                                     const std::string&      url,
+                                                     customer_request_t      cr,
+                                                     const http_headers_t&   headers,
+                                                     const http_body_t&      body,
+                                                     bool                    verify_ssl,
+                                                     uint32_t                delivery,
+                                                     int32_t                 priority,
+                                                     uint32_t                deadline
+                                                   ) noexcept(true)
 {
   if ( name.empty() || url.empty() )
-    return false;
+    return k_invalid_request;
 
-  std::string     _name = core::utils::format( "%s:%s:%s", to_string_view(cr).data(), name.c_str(), app_id.c_str() );
+  request_t       _request = k_invalid_request;
   std::lock_guard _mtx(m_mtx_fetch);
 
   /***/
-  if ( m_fetching.contains( _name ) == true )
-    return true;
+  if ( add_request( get_key( app_id, name, cr ), _request ) == false )
+    return _request;
 
-  resource_t* pResource = new(std::nothrow)resource_t( events, app_id, name, type, url, cr, headers, body, verify_ssl );
+  resource_t* pResource = new(std::nothrow)resource_t( events, app_id, name, type, url, cr, headers, body, verify_ssl, delivery, _request, priority, deadline );
   if ( pResource == nullptr )
   {
-    return false;
+    m_fetching.erase( m_requests[_request] );
+    m_requests.erase( _request );
+    return k_invalid_request;
   }
 
-  /***/
-  m_fetching.insert(_name);
-
-  s_mbx->write( pResource );
+  submit( pResource );
 
-  return true;
+  return _request;
 }
 
-bool_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
-                                std::string&&           app_id,
-                                std::string&&           name,
-                                const std::type_info&   type,
-                                std::string&&           url,
-                                customer_request_t      cr,
-                                http_headers_t&&        headers,
-                                http_body_t&&           body,
-                                bool                    verify_ssl
-                              ) noexcept(true)
+ResourcesFetcher::request_t ResourcesFetcher::fetch( ResourcesFetcherEvents& events,
+                                                     std::string&&           app_id,
+                                                     std::string&&           name,
+                                                     const std::type_info&   type,
+                                                     std::string&&           url,
+                                                     customer_request_t      cr,
+                                                     http_headers_t&&        headers,
+                                                     http_body_t&&           body,
+                                                     bool                    verify_ssl,
+                                                     uint32_t                delivery,
+                                                     int32_t                 priority,
+                                                     uint32_t                deadline
+                                                   ) noexcept(true)
 {
   if ( name.empty() || url.empty() )
-    return false;
+    return k_invalid_request;
 
-  std::string     _name = core::utils::format( "%s:%s:%s", to_string_view(cr).data(), name.c_str(), app_id.c_str() );
+  request_t       _request = k_invalid_request;
   std::lock_guard _mtx(m_mtx_fetch);
 
   /***/
-  if ( m_fetching.contains( _name ) == true )
-    return true;
+  if ( add_request( get_key( app_id, name, cr ), _request ) == false )
+    return _request;
 
-  resource_t* pResource = new(std::nothrow)resource_t( events, std::move(app_id), std::move(name), type, std::move(url), cr, std::move(headers), std::move(body), verify_ssl );
+  resource_t* pResource = new(std::nothrow)resource_t( events, std::move(app_id), std::move(name), type, std::move(url), cr, std::move(headers), std::move(body), verify_ssl, delivery, _request, priority, deadline );
   if ( pResource == nullptr )
   {
-    return false;
+    m_fetching.erase( m_requests[_request] );
+    m_requests.erase( _request );
+    return k_invalid_request;
   }
 
-  /***/
-  m_fetching.insert(_name);
+  submit( pResource );
+
+  return _request;
+}
 
-  s_mbx->write( pResource );
+bool_t ResourcesFetcher::set_priority( request_t request, int32_t priority ) noexcept(true)
+{
+  {
+    std::lock_guard _mtx(m_mtx_fetch);
+    if ( m_requests.contains( request ) == false )
+      return false;
+  }
+
+  {
+    std::lock_guard _mtx( s_mtx_pending );
+    s_commands.push_back( command_t{ request, priority, false } );
+  }
+
+  curl_multi_wakeup( s_multi );
 
   return true;
 }
 
+bool_t ResourcesFetcher::cancel( request_t request ) noexcept(true)
+{
+  /* Wait for a callback in progress, next ones will find the request released */
+  std::lock_guard _notify( m_mtx_notify );
+
+  /* Completion can be still waiting for dispatch() */
+  if ( release( request ) == false )
+    return unpost( request );
+
+  {
+    std::lock_guard _mtx( s_mtx_pending );
+    s_commands.push_back( command_t{ request, 0, true } );
+  }
+
+  curl_multi_wakeup( s_multi );
+
+  return true;
+}
+
+ResourcesFetcher::stats_t ResourcesFetcher::get_stats() const noexcept(true)
+{
+  return stats_t{ s_new_connections, s_reused_connections, s_cache_hits, s_cache_revalidations };
+}
+
+void_t ResourcesFetcher::set_max_transfers( uint32_t max_transfers, uint32_t max_host_transfers ) noexcept(true)
+{
+  m_max_transfers      = (max_transfers      > 0)?max_transfers:1; 
+  m_max_host_transfers = (max_host_transfers > 0)?max_host_transfers:1; 
+
+  /* I/O thread applies new limits, and admits queued requests, as soon as it wakes up */
+  if ( s_multi != nullptr )
+    curl_multi_wakeup( s_multi );
+}
+
+bool_t ResourcesFetcher::set_cache( const std::string& path, uint64_t max_bytes ) noexcept(true)
+{
+  std::shared_ptr<HttpCache> _cache;
+
+  if ( path.empty() == false )
+  {
+    _cache.reset( new(std::nothrow) HttpCache( path, max_bytes ) );
+    if ( ( _cache == nullptr ) || ( _cache->is_valid() == false ) )
+      return false;
+  }
+
+  /* Previous cache, if any, will be released by the I/O thread when not used anymore */
+  std::lock_guard _mtx( s_mtx_pending );
+  s_cache = _cache;
+
+  return true;
+}
+
+void_t ResourcesFetcher::reset_stats() noexcept(true)
+{
+  s_new_connections    = 0;
+  s_reused_connections = 0;
+  s_cache_hits         = 0;
+  s_cache_revalidations= 0;
+}
+
 void_t ResourcesFetcher::on_initialize() noexcept(true)
 {
   curl_global_init(CURL_GLOBAL_ALL);
 
-  s_mbx       = new(std::nothrow) mailbox_type("Resource Requests Mailbox");
-  if ( s_mbx != nullptr )
+  s_exit  = false;
+
+  /* Connection cache is owned by the multi handle, DNS and TLS sessions are shared through s_share.
+   * Both are used only by the I/O thread, so no lock is required. */
+  s_share = curl_share_init();
+  if ( s_share != nullptr )
+  {
+    curl_share_setopt( s_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS         );
+    curl_share_setopt( s_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION );
+  }
+
+  s_multi = curl_multi_init();
+  if ( s_multi != nullptr )
   {
+    /* Connection limits are applied by the I/O thread, see apply_limits() */
+    s_applied_max_transfers      = 0;
+    s_applied_max_host_transfers = 0;
+
+    /* HTTP/2 servers will serve more requests with a single connection */
+    curl_multi_setopt( s_multi, CURLMOPT_PIPELINING          , CURLPIPE_MULTIPLEX );
+
     s_scheduler = std::thread(th_requests_scheduler);
   }
 }
@@ -395,12 +1362,59 @@ void_t ResourcesFetcher::on_finalize() noexcept(true)
 {
   s_exit = true;
 
-  s_scheduler.join();
+  if ( s_multi != nullptr )
+  {
+    curl_multi_wakeup( s_multi );
+  }
+
+  if ( s_scheduler.joinable() )
+  {
+    s_scheduler.join();
+  }
+
+  /* Abort transfers still in progress */
+  for ( transfer_t* _transfer : s_transfers )
+  {
+    curl_multi_remove_handle( s_multi, _transfer->m_easy_handle );
+    delete _transfer;
+  }
+  s_transfers.clear();
+  s_host_transfers.clear();
+
+  for ( CURL* _easy_handle : s_handles )
+    curl_easy_cleanup( _easy_handle );
+  s_handles.clear();
+
+  for ( auto& _buffer : s_buffers )
+    free( _buffer.first );
+  s_buffers.clear();
+
+  /* Completions not dispatched yet are dropped */
+  clear_completions();
+
+  /* Index is saved when the cache is released */
+  s_cache_io.reset();
+  s_cache.reset();
+
+  for ( resource_t* pResource : s_pending )
+    delete pResource;
+  s_pending.clear();
+
+  for ( resource_t* pResource : s_queued )
+    delete pResource;
+  s_queued.clear();
+  s_commands.clear();
+
+  if ( s_multi != nullptr )
+  {
+    curl_multi_cleanup( s_multi );
+    s_multi = nullptr;
+  }
 
-  if ( s_mbx != nullptr )
+  if ( s_share != nullptr )
   {
-    delete s_mbx;
-    s_mbx = nullptr;
+    curl_share_cleanup( s_share );
+    s_share = nullptr;
   }
 
   curl_global_cleanup();
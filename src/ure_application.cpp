@@ -51,6 +51,10 @@ void_t Application::run() noexcept(true)
     /* Processing websockets messages */
     processing_ws();
 #endif
+
+    /* Nothing to render, block until an event or a wake up from background work */
+    if ( ( exit() == false ) && m_events->is_idle() )
+      wait_events( m_idle_timeout );
   }
 #endif
 }
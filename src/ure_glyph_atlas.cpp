@@ -0,0 +1,166 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_glyph_atlas.h"
+
+#include <cstring>
+#include <new>
+
+namespace ure {
+
+GlyphAtlas::GlyphAtlas( sizei_t width, sizei_t height, sizei_t max_height ) noexcept(true)
+  : m_texture( nullptr ), m_max_height( max_height ), m_next_y( 0 )
+{
+  m_texture = std::shared_ptr<Texture>( new(std::nothrow) Texture( width, height, Texture::k_mask_format, Texture::type_t::eUnsignedByte, Texture::lifecycle_t::eObject ) );
+}
+
+GlyphAtlas::~GlyphAtlas() noexcept(true)
+{
+}
+
+const GlyphAtlas::glyph_t*  GlyphAtlas::find( uint32_t code ) const noexcept(true)
+{
+  std::unordered_map<uint32_t, glyph_t>::const_iterator iter = m_mapGlyphs.find( code );
+  if ( iter == m_mapGlyphs.end() )
+    return nullptr;
+
+  return &iter->second;
+}
+
+const GlyphAtlas::glyph_t*  GlyphAtlas::insert( uint32_t code, const glyph_t& glyph, const uint8_t* pBitmap, int_t pitch ) noexcept(true)
+{
+  glyph_t  item = glyph;
+
+  item.x = 0;
+  item.y = 0;
+
+  // Blank glyphs, like spaces, just need metrics.
+  if ( ( item.width > 0 ) && ( item.height > 0 ) && ( pBitmap != nullptr ) )
+  {
+    if ( allocate( item.width + k_padding, item.height + k_padding, item.x, item.y ) == false )
+      return nullptr;
+
+    uint8_t*       pPixels = m_texture->get_pixels();
+    const sizei_t  stride  = m_texture->get_size().width;
+
+    for ( sizei_t row = 0; row < item.height; ++row )
+    {
+      memcpy( &pPixels[(item.y + row) * stride + item.x], &pBitmap[row * pitch], item.width );
+    }
+
+    m_texture->update_rows( item.y, item.height );
+  }
+
+  return &(m_mapGlyphs[code] = item);
+}
+
+bool_t  GlyphAtlas::find_kerning( uint_t left, uint_t right, int_t& value ) const noexcept(true)
+{
+  std::unordered_map<uint64_t, int_t>::const_iterator iter = m_mapKerning.find( (uint64_t(left) << 32) | right );
+  if ( iter == m_mapKerning.end() )
+    return false;
+
+  value = iter->second;
+  return true;
+}
+
+std::size_t  GlyphAtlas::get_memory_usage() const noexcept(true)
+{
+  std::size_t _size = ( m_texture != nullptr )?m_texture->get_memory_usage():0;
+
+  return _size + m_mapGlyphs.size()*sizeof(glyph_t) + m_mapKerning.size()*sizeof(int_t);
+}
+
+void_t  GlyphAtlas::set_kerning( uint_t left, uint_t right, int_t value ) noexcept(true)
+{
+  m_mapKerning[(uint64_t(left) << 32) | right] = value;
+}
+
+bool_t  GlyphAtlas::allocate( sizei_t width, sizei_t height, int_t& x, int_t& y ) noexcept(true)
+{
+  if ( ( m_texture == nullptr ) || ( m_texture->get_pixels() == nullptr ) )
+    return false;
+
+  if ( width > m_texture->get_size().width )
+    return false;
+
+  do
+  {
+    const Size& size = m_texture->get_size();
+
+    // Best fit among existing shelves, that is the lowest one tall enough.
+    shelf_t* pShelf = nullptr;
+    for ( shelf_t& shelf : m_vShelves )
+    {
+      if ( ( shelf.height >= height ) && ( shelf.x + width <= size.width ) )
+      {
+        if ( ( pShelf == nullptr ) || ( shelf.height < pShelf->height ) )
+          pShelf = &shelf;
+      }
+    }
+
+    if ( ( pShelf == nullptr ) && ( m_next_y + height <= size.height ) )
+    {
+      m_vShelves.push_back( { m_next_y, height, 0 } );
+      m_next_y += height;
+
+      pShelf = &m_vShelves.back();
+    }
+
+    if ( pShelf != nullptr )
+    {
+      x = pShelf->x;
+      y = pShelf->y;
+
+      pShelf->x += width;
+      return true;
+    }
+  } while ( grow() );
+
+  return false;
+}
+
+bool_t  GlyphAtlas::grow() noexcept(true)
+{
+  if ( m_texture == nullptr )
+    return false;
+
+  const Size  size   = m_texture->get_size();
+  sizei_t     height = size.height * 2;
+
+  if ( height > m_max_height )
+    return false;
+
+  std::shared_ptr<Texture> texture( new(std::nothrow) Texture( size.width, height, Texture::k_mask_format, Texture::type_t::eUnsignedByte, Texture::lifecycle_t::eObject ) );
+  if ( ( texture == nullptr ) || ( texture->get_pixels() == nullptr ) )
+    return false;
+
+  // New texture will be uploaded as a whole when used for the first time.
+  memcpy( texture->get_pixels(), m_texture->get_pixels(), size.width * size.height );
+
+  m_texture = texture;
+
+  return true;
+}
+
+}
@@ -0,0 +1,543 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_http_cache.h"
+
+#include <core/utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace ure {
+
+/* Index file version, increase when format changes */
+static constexpr const char* k_index_header = "ure-http-cache 2";
+
+/***/
+static uint64_t fnv1a( const byte_t* data, uint64_t size ) noexcept(true)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for ( uint64_t i = 0; i < size; ++i )
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/***/
+static bool_t is_storable( const std::string& value ) noexcept(true)
+{
+  return ( value.find_first_of( "\t\r\n" ) == std::string::npos );
+}
+
+/***/
+static std::string to_lower( std::string_view value ) noexcept(true)
+{
+  std::string lower( value );
+  std::transform( lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); } );
+  return lower;
+}
+
+/***/
+static std::string_view trim( std::string_view value ) noexcept(true)
+{
+  while ( ( value.empty() == false ) && ( ( value.front() == ' ' ) || ( value.front() == '\t' ) ) )
+    value.remove_prefix( 1 );
+  while ( ( value.empty() == false ) && ( ( value.back() == ' ' ) || ( value.back() == '\t' ) ) )
+    value.remove_suffix( 1 );
+  return value;
+}
+
+/**
+ * @return digest of all values for header \param name in \param headers, 
+ *         "-" if header has not been sent.
+ */
+static std::string header_digest( const std::string& name, const HttpCache::headers_t& headers ) noexcept(true)
+{
+  std::string value;
+  bool_t      found = false;
+
+  for ( size_t ndx = 0; ( ndx + 1 ) < headers.size(); ndx += 2 )
+  {
+    if ( to_lower( headers[ndx] ) != name )
+      continue;
+
+    if ( found )
+      value += ',';
+    value += headers[ndx+1];
+    found  = true;
+  }
+
+  if ( found == false )
+    return "-";
+
+  return core::utils::format( "%016llx", (unsigned long long)fnv1a( (const byte_t*)value.data(), value.size() ) );
+}
+
+#if defined(_WIN32)
+
+bool_t  HttpCache::mapped_t::open( const std::string& filename ) noexcept(true)
+{
+  close();
+
+  std::error_code ec;
+  const uint64_t size = std::filesystem::file_size( filename, ec );
+  if ( ec )
+    return false;
+
+  if ( size == 0 )
+    return true;
+
+  FILE* file = std::fopen( filename.c_str(), "rb" );
+  if ( file == nullptr )
+    return false;
+
+  m_data = new(std::nothrow) byte_t[size];
+  if ( ( m_data == nullptr ) || ( std::fread( m_data, 1, size, file ) != size ) )
+  {
+    delete [] m_data;
+    m_data = nullptr;
+    std::fclose( file );
+    return false;
+  }
+
+  m_size = size;
+  std::fclose( file );
+
+  return true;
+}
+
+void_t  HttpCache::mapped_t::close() noexcept(true)
+{
+  delete [] m_data;
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#else
+
+bool_t  HttpCache::mapped_t::open( const std::string& filename ) noexcept(true)
+{
+  close();
+
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    return false;
+
+  struct stat st;
+  if ( fstat( fd, &st ) != 0 )
+  {
+    ::close( fd );
+    return false;
+  }
+
+  m_size = static_cast<uint64_t>(st.st_size);
+
+  if ( m_size > 0 )
+  {
+    void* ptr = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( ptr == MAP_FAILED )
+    {
+      ::close( fd );
+      m_size = 0;
+      return false;
+    }
+
+    m_data = static_cast<byte_t*>(ptr);
+  }
+
+  // Mapping stays valid after closing the descriptor.
+  ::close( fd );
+
+  return true;
+}
+
+void_t  HttpCache::mapped_t::close() noexcept(true)
+{
+  if ( m_data != nullptr )
+  {
+    munmap( m_data, m_size );
+    m_data = nullptr;
+  }
+  m_size = 0;
+}
+
+#endif
+
+HttpCache::HttpCache( const std::string& path, uint64_t budget ) noexcept(true)
+  : m_path( path ), m_budget( budget ), m_size( 0 ), m_valid( false ), m_dirty( false )
+{
+  std::error_code ec;
+  std::filesystem::create_directories( m_path, ec );
+
+  m_valid = std::filesystem::is_directory( m_path, ec );
+  if ( m_valid )
+  {
+    load();
+  }
+}
+
+HttpCache::~HttpCache() noexcept(true)
+{
+  flush();
+}
+
+const HttpCache::entry_t*  HttpCache::find( const std::string& url, const headers_t& headers ) const noexcept(true)
+{
+  auto iter = m_entries.find( make_key( url, headers ) );
+  if ( iter == m_entries.end() )
+    return nullptr;
+
+  // Response has been selected by different request headers
+  if ( ( iter->second.vary.empty() == false ) && ( select( iter->second.vary, headers ) != iter->second.vary ) )
+    return nullptr;
+
+  return &iter->second;
+}
+
+bool_t  HttpCache::open( const std::string& url, const headers_t& headers, mapped_t& mapped ) noexcept(true)
+{
+  if ( find( url, headers ) == nullptr )
+    return false;
+
+  auto iter = m_entries.find( make_key( url, headers ) );
+
+  if ( mapped.open( blob_path( iter->second.hash ) ) == false )
+  {
+    // Blob removed from outside, entry is not valid anymore
+    remove_key( iter->first );
+    return false;
+  }
+
+  iter->second.last_access = std::time( nullptr );
+  m_dirty = true;
+
+  return true;
+}
+
+bool_t  HttpCache::store( const std::string& url, const headers_t& headers, const std::string& vary, 
+                          const entry_t& entry, const byte_t* data, uint64_t size ) noexcept(true)
+{
+  const std::string key = make_key( url, headers );
+
+  remove_key( key );
+
+  if ( ( m_valid == false ) || ( size > m_budget ) || ( is_storable( key ) == false ) ||
+       ( is_storable( entry.etag ) == false ) || ( is_storable( entry.last_modified ) == false ) ||
+       ( vary.find( '*' ) != std::string::npos ) )
+    return false;
+
+  uint64_t hash = fnv1a( data, size );
+
+  // Blobs with the same hash but different content take the next free identifier
+  auto blob = m_blobs.find( hash );
+  while ( ( blob != m_blobs.end() ) && ( is_blob_equal( hash, data, size ) == false ) )
+    blob = m_blobs.find( ++hash );
+
+  if ( blob == m_blobs.end() )
+  {
+    // Write a temporary file first, so that a partial blob is never visible
+    const std::string filename = blob_path( hash );
+    const std::string tmp      = filename + ".tmp";
+
+    std::ofstream file( tmp, std::ios::binary | std::ios::trunc );
+    if ( file.is_open() == false )
+      return false;
+
+    file.write( reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size) );
+    file.close();
+
+    std::error_code ec;
+    if ( file.fail() == false )
+      std::filesystem::rename( tmp, filename, ec );
+
+    if ( file.fail() || ec )
+    {
+      std::filesystem::remove( tmp, ec );
+      return false;
+    }
+
+    blob    = m_blobs.emplace( hash, blob_t{ size, 0 } ).first;
+    m_size += size;
+  }
+
+  blob->second.refs++;
+
+  entry_t& item    = m_entries[key];
+  item             = entry;
+  item.hash        = hash;
+  item.vary        = select( vary, headers );
+  item.size        = size;
+  item.last_access = std::time( nullptr );
+
+  m_dirty = true;
+
+  evict();
+
+  return true;
+}
+
+void_t  HttpCache::refresh( const std::string& url, const headers_t& headers, const entry_t& entry ) noexcept(true)
+{
+  auto iter = m_entries.find( make_key( url, headers ) );
+  if ( iter == m_entries.end() )
+    return;
+
+  // Servers can omit validators in 304 responses, previous ones are still valid
+  if ( entry.etag.empty() == false )
+    iter->second.etag = entry.etag;
+  if ( entry.last_modified.empty() == false )
+    iter->second.last_modified = entry.last_modified;
+
+  iter->second.expires     = entry.expires;
+  iter->second.last_access = std::time( nullptr );
+
+  m_dirty = true;
+}
+
+void_t  HttpCache::remove( const std::string& url, const headers_t& headers ) noexcept(true)
+{
+  remove_key( make_key( url, headers ) );
+}
+
+void_t  HttpCache::remove_key( const std::string& key ) noexcept(true)
+{
+  auto iter = m_entries.find( key );
+  if ( iter == m_entries.end() )
+    return;
+
+  const uint64_t hash = iter->second.hash;
+
+  m_entries.erase( iter );
+  release_blob( hash );
+
+  m_dirty = true;
+}
+
+void_t  HttpCache::flush() noexcept(true)
+{
+  if ( ( m_valid == false ) || ( m_dirty == false ) )
+    return;
+
+  const std::string filename = m_path + "/index";
+  const std::string tmp      = filename + ".tmp";
+
+  std::ofstream file( tmp, std::ios::trunc );
+  if ( file.is_open() == false )
+    return;
+
+  file << k_index_header << '\n';
+
+  // key hash size expires last_access etag last_modified vary
+  for ( const auto& [key, entry] : m_entries )
+  {
+    file << key                << '\t' 
+         << std::hex << entry.hash << std::dec << '\t'
+         << entry.size         << '\t'
+         << entry.expires      << '\t'
+         << entry.last_access  << '\t'
+         << entry.etag         << '\t'
+         << entry.last_modified<< '\t'
+         << entry.vary         << '\n';
+  }
+
+  file.close();
+
+  std::error_code ec;
+  if ( file.fail() == false )
+  {
+    std::filesystem::rename( tmp, filename, ec );
+    m_dirty = ( ec.value() != 0 );
+  }
+}
+
+std::string  HttpCache::make_key( const std::string& url, const headers_t& headers ) noexcept(true)
+{
+  std::string key = url;
+
+  // Space is not valid in urls, so keys with credentials never match a plain url
+  for ( const char* name : { "authorization", "cookie" } )
+  {
+    const std::string digest = header_digest( name, headers );
+    if ( digest != "-" )
+      key += core::utils::format( " %s=%s", name, digest.c_str() );
+  }
+
+  return key;
+}
+
+std::string  HttpCache::select( const std::string& names, const headers_t& headers ) noexcept(true)
+{
+  std::vector<std::string> fields;
+  std::string_view         list( names );
+
+  while ( list.empty() == false )
+  {
+    std::size_t      comma = list.find( ',' );
+    std::string_view field = list.substr( 0, comma );
+    list.remove_prefix( ( comma == std::string_view::npos ) ? list.size() : comma + 1 );
+
+    // Stored selections have digests after the name
+    field = trim( field.substr( 0, field.find( '=' ) ) );
+    if ( field.empty() == false )
+      fields.push_back( to_lower( field ) );
+  }
+
+  std::sort( fields.begin(), fields.end() );
+  fields.erase( std::unique( fields.begin(), fields.end() ), fields.end() );
+
+  std::string selection;
+  for ( const auto& name : fields )
+  {
+    if ( selection.empty() == false )
+      selection += ',';
+    selection += name + '=' + header_digest( name, headers );
+  }
+
+  return selection;
+}
+
+std::string  HttpCache::blob_path( uint64_t hash ) const noexcept(true)
+{
+  return core::utils::format( "%s/%016llx", m_path.c_str(), (unsigned long long)hash );
+}
+
+bool_t  HttpCache::is_blob_equal( uint64_t hash, const byte_t* data, uint64_t size ) const noexcept(true)
+{
+  auto blob = m_blobs.find( hash );
+  if ( ( blob == m_blobs.end() ) || ( blob->second.size != size ) )
+    return false;
+
+  mapped_t mapped;
+  if ( mapped.open( blob_path( hash ) ) == false )
+    return false;
+
+  return ( mapped.size() == size ) && ( ( size == 0 ) || ( std::memcmp( mapped.data(), data, size ) == 0 ) );
+}
+
+void_t  HttpCache::load() noexcept(true)
+{
+  std::ifstream file( m_path + "/index" );
+  if ( file.is_open() == false )
+    return;
+
+  std::string line;
+  if ( ( std::getline( file, line ).fail() ) || ( line != k_index_header ) )
+    return;
+
+  std::error_code ec;
+
+  while ( std::getline( file, line ) )
+  {
+    std::vector<std::string> fields;
+    std::stringstream        ss( line );
+    std::string              field;
+
+    while ( std::getline( ss, field, '\t' ) )
+      fields.push_back( field );
+
+    // Trailing empty fields are not returned by getline()
+    fields.resize( 8 );
+    if ( fields[0].empty() || fields[1].empty() )
+      continue;
+
+    entry_t entry;
+    entry.hash          = std::strtoull( fields[1].c_str(), nullptr, 16 );
+    entry.size          = std::strtoull( fields[2].c_str(), nullptr, 10 );
+    entry.expires       = static_cast<std::time_t>( std::strtoll( fields[3].c_str(), nullptr, 10 ) );
+    entry.last_access   = static_cast<std::time_t>( std::strtoll( fields[4].c_str(), nullptr, 10 ) );
+    entry.etag          = std::move( fields[5] );
+    entry.last_modified = std::move( fields[6] );
+    entry.vary          = std::move( fields[7] );
+
+    // Skip entries whose blob is missing or truncated
+    const std::string filename = blob_path( entry.hash );
+    if ( std::filesystem::file_size( filename, ec ) != entry.size || ec )
+      continue;
+
+    auto blob = m_blobs.find( entry.hash );
+    if ( blob == m_blobs.end() )
+    {
+      blob    = m_blobs.emplace( entry.hash, blob_t{ entry.size, 0 } ).first;
+      m_size += entry.size;
+    }
+    blob->second.refs++;
+
+    m_entries.emplace( std::move(fields[0]), std::move(entry) );
+  }
+
+  evict();
+}
+
+void_t  HttpCache::release_blob( uint64_t hash ) noexcept(true)
+{
+  auto blob = m_blobs.find( hash );
+  if ( blob == m_blobs.end() )
+    return;
+
+  if ( --blob->second.refs > 0 )
+    return;
+
+  std::error_code ec;
+  std::filesystem::remove( blob_path( hash ), ec );
+
+  m_size -= blob->second.size;
+  m_blobs.erase( blob );
+}
+
+void_t  HttpCache::evict() noexcept(true)
+{
+  if ( m_size <= m_budget )
+    return;
+
+  std::vector<std::pair<std::time_t, std::string>> lru;
+  lru.reserve( m_entries.size() );
+
+  for ( const auto& [key, entry] : m_entries )
+    lru.emplace_back( entry.last_access, key );
+
+  std::sort( lru.begin(), lru.end() );
+
+  for ( const auto& [last_access, key] : lru )
+  {
+    if ( m_size <= m_budget )
+      break;
+
+    remove_key( key );
+  }
+}
+
+}
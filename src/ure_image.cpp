@@ -31,8 +31,24 @@
 
 namespace ure {
 
-typedef uint8_t* (*load_image  )( const char*    filename, unsigned int* size, int* width, int* height );
-typedef uint8_t* (*create_image)( const uint8_t* memory  , unsigned int* size, int* width, int* height );
+typedef uint8_t* (*load_image  )( const char*    filename, unsigned int* size, int* width, int* height, int* channels );
+typedef uint8_t* (*create_image)( const uint8_t* memory  , unsigned int* size, int* width, int* height, int* channels );
+
+/**
+ * Map channels returned by loaders to image format.
+ */
+static Image::format_t  channels_to_format( int channels ) noexcept
+{
+  switch ( channels )
+  {
+    case 1: return Image::format_t::eLuminance;
+    case 2: return Image::format_t::eLuminanceAlpha;
+    case 3: return Image::format_t::eRGB;
+    case 4: return Image::format_t::eRGBA;
+    default: break;
+  }
+  return Image::format_t::eUndefined;
+}
 
 Image::~Image()
 {
@@ -80,14 +96,18 @@ bool  Image::load( Image::loader_t il, const std::string& filename ) noexcept
   if ( load == NULL )
     return false;
   
-  m_pData = load( filename.c_str(), &m_uiDataSize, &m_size.width, &m_size.height );
+  int channels = 0;
+
+  m_pData = load( filename.c_str(), &m_uiDataSize, &m_size.width, &m_size.height, &channels );
   if (m_pData==nullptr)
   {
     ure::utils::log( core::utils::format( "Image::load() - Failed to load Image [%s]", filename.c_str() ) );
     return false;
   }
+
+  m_format = channels_to_format( channels );
     
-  ure::utils::log( core::utils::format( "Image::load() - Loaded Image [%s] MEM BYTES [%d] W:[%d] x H:[%d] Pixel D:[32] Bits", filename.c_str(), m_uiDataSize, m_size.width, m_size.height ) );
+  ure::utils::log( core::utils::format( "Image::load() - Loaded Image [%s] MEM BYTES [%d] W:[%d] x H:[%d] Pixel D:[%d] Bits", filename.c_str(), m_uiDataSize, m_size.width, m_size.height, channels*8 ) );
   
   return true;
 }
@@ -135,18 +155,94 @@ bool      Image::create( loader_t il, const byte_t* data, uint32_t datasize ) no
   
   m_uiDataSize = datasize;
 
-  m_pData = load( data, &m_uiDataSize, &m_size.width, &m_size.height );
+  int channels = 0;
+
+  m_pData = load( data, &m_uiDataSize, &m_size.width, &m_size.height, &channels );
   if (m_pData==nullptr)
   {
     ure::utils::log( "Image::create() - Failed to create Image from memory buffer" );
     return false;
   }
+
+  m_format = channels_to_format( channels );
     
-  ure::utils::log( core::utils::format( "Image::create() - Created Image from memory buffer MEM BYTES [%d] W:[%d] x H:[%d] Pixel D:[32] Bits", m_uiDataSize, m_size.width, m_size.height ) );
+  ure::utils::log( core::utils::format( "Image::create() - Created Image from memory buffer MEM BYTES [%d] W:[%d] x H:[%d] Pixel D:[%d] Bits", m_uiDataSize, m_size.width, m_size.height, channels*8 ) );
    
   return true;
 }
 
+bool      Image::convert( format_t format ) noexcept
+{
+  if ( format == m_format )
+    return true;
+
+  if ( m_pData == nullptr )
+    return false;
+
+  const uint32_t srcBpp = get_bytes_per_pixel( m_format );
+  const uint32_t dstBpp = get_bytes_per_pixel( format   );
+  const uint32_t pixels = m_size.width * m_size.height;
+
+  switch ( format )
+  {
+    case format_t::eRGB565:
+    {
+      if ( ( m_format != format_t::eRGB ) && ( m_format != format_t::eRGBA ) )
+        return false;
+    }; break;
+    case format_t::eRGBA4444:
+    {
+      if ( m_format != format_t::eRGBA )
+        return false;
+    }; break;
+    case format_t::eAlpha:
+    {
+      // Same layout, coverage moves from luminance to alpha.
+      if ( m_format == format_t::eLuminance )
+      {
+        m_format = format;
+        return true;
+      }
+
+      if ( m_format != format_t::eRGBA )
+        return false;
+    }; break;
+    default:
+      return false;
+  }
+
+  byte_t* pData = (byte_t*)malloc( pixels * dstBpp );
+  if ( pData == nullptr )
+    return false;
+
+  const byte_t* pSrc = m_pData;
+  uint16_t*     pDst = reinterpret_cast<uint16_t*>(pData);
+
+  for ( uint32_t i = 0; i < pixels; ++i, pSrc += srcBpp )
+  {
+    switch ( format )
+    {
+      case format_t::eRGB565:
+        pDst[i] = uint16_t( ((pSrc[0] >> 3) << 11) | ((pSrc[1] >> 2) << 5) | (pSrc[2] >> 3) );
+      break;
+      case format_t::eRGBA4444:
+        pDst[i] = uint16_t( ((pSrc[0] >> 4) << 12) | ((pSrc[1] >> 4) << 8) | ((pSrc[2] >> 4) << 4) | (pSrc[3] >> 4) );
+      break;
+      default:
+        pData[i] = pSrc[3];
+      break;
+    }
+  }
+
+  free( m_pData );
+
+  m_pData      = pData;
+  m_uiDataSize = pixels * dstBpp;
+  m_format     = format;
+
+  return true;
+}
+
 uint8_t*  Image::detach( uint32_t* datasize ) noexcept
 {
   uint8_t* _pRetValue = m_pData;
@@ -0,0 +1,231 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_image_decoder.h"
+#include "ure_application.h"
+
+namespace ure {
+
+/* DevIL keeps the bound image in a global state, so only one thread at time can use it. */
+static std::mutex s_mtxDevIL;
+
+ImageDecoder::ImageDecoder( uint32_t workers ) noexcept(true)
+  : m_workers( workers ), m_running( 0 ), m_exit( false ), m_next_id( k_invalid_request )
+{
+  if ( m_workers == 0 )
+  {
+    uint32_t cores = std::thread::hardware_concurrency();
+    m_workers = ( cores > 1 ) ? (cores - 1) : 1;
+  }
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  m_workers = 0;
+#endif
+}
+
+ImageDecoder::request_id_t  ImageDecoder::decode( Image::loader_t il, const std::string& name, const std::string& filename ) noexcept(true)
+{
+  if ( filename.empty() )
+    return k_invalid_request;
+
+  return push( request_t{ k_invalid_request, il, name, filename, {}, nullptr, {} } );
+}
+
+ImageDecoder::request_id_t  ImageDecoder::decode( Image::loader_t il, const std::string& name, std::vector<byte_t>&& data ) noexcept(true)
+{
+  if ( data.empty() )
+    return k_invalid_request;
+
+  return push( request_t{ k_invalid_request, il, name, {}, std::move(data), nullptr, {} } );
+}
+
+ImageDecoder::request_id_t  ImageDecoder::decode( Image::loader_t il, const std::string& name, const byte_t* data, uint32_t length ) noexcept(true)
+{
+  if ( ( data == nullptr ) || ( length == 0 ) )
+    return k_invalid_request;
+
+  return decode( il, name, std::vector<byte_t>( data, data + length ) );
+}
+
+ImageDecoder::request_id_t  ImageDecoder::decode( Image::loader_t il, const std::string& name, std::vector<byte_t>&& data, 
+                                                  std::shared_ptr<ImageDecoderEvents> events ) noexcept(true)
+{
+  if ( data.empty() || ( events == nullptr ) )
+    return k_invalid_request;
+
+  return push( request_t{ k_invalid_request, il, name, {}, std::move(data), std::move(events), {} } );
+}
+
+ImageDecoder::request_id_t  ImageDecoder::decode( Image::loader_t il, const std::string& name, data_t&& data, 
+                                                  std::shared_ptr<ImageDecoderEvents> events ) noexcept(true)
+{
+  if ( ( data.data() == nullptr ) || ( data.length() == 0 ) || ( events == nullptr ) )
+    return k_invalid_request;
+
+  return push( request_t{ k_invalid_request, il, name, {}, {}, std::move(events), std::move(data) } );
+}
+
+bool_t  ImageDecoder::pop( decoded_t& decoded ) noexcept(true)
+{
+  std::lock_guard _mtx( m_mtxDecoded );
+
+  if ( m_decoded.empty() )
+    return false;
+
+  decoded = std::move( m_decoded.front() );
+  m_decoded.pop_front();
+
+  return true;
+}
+
+std::size_t  ImageDecoder::get_pending() const noexcept(true)
+{
+  std::lock_guard _mtx( m_mtxRequests );
+
+  return m_requests.size() + m_running;
+}
+
+ImageDecoder::request_id_t  ImageDecoder::push( request_t&& request ) noexcept(true)
+{
+  std::unique_lock _lock( m_mtxRequests );
+
+  request.id = ++m_next_id;
+
+  const request_id_t id = request.id;
+
+  // Without workers decoding happens here, results are delivered in the same way.
+  if ( m_vWorkers.empty() )
+  {
+    _lock.unlock();
+    run( request );
+    return id;
+  }
+
+  m_requests.push_back( std::move(request) );
+  _lock.unlock();
+
+  m_cvRequests.notify_one();
+
+  return id;
+}
+
+void_t  ImageDecoder::run( request_t& request ) noexcept(true)
+{
+  std::unique_ptr<Image> image( new(std::nothrow) Image() );
+  if ( image != nullptr )
+  {
+    std::unique_lock<std::mutex> _devil( s_mtxDevIL, std::defer_lock );
+    if ( request.loader == Image::loader_t::eDevIL )
+      _devil.lock();
+
+    bool_t decoded = false;
+    if ( request.filename.empty() == false )
+      decoded = image->load  ( request.loader, request.filename );
+    else if ( request.memory.data() != nullptr )
+      decoded = image->create( request.loader, request.memory.data(), static_cast<uint32_t>(request.memory.length()) );
+    else
+      decoded = image->create( request.loader, request.data.data(), static_cast<uint32_t>(request.data.size()) );
+
+    if ( decoded == false )
+      image.reset();
+  }
+
+  // Source buffer is not needed anymore
+  request.data   = {};
+  request.memory = {};
+
+  if ( request.events != nullptr )
+  {
+    std::shared_ptr<ImageDecoderEvents> events = std::move(request.events);
+    events->on_image_decoded( decoded_t{ request.id, std::move(request.name), std::move(image) } );
+  }
+  else
+  {
+    std::lock_guard _mtx( m_mtxDecoded );
+    m_decoded.push_back( decoded_t{ request.id, std::move(request.name), std::move(image) } );
+  }
+
+  // Main loop can be waiting for events when nothing has to be rendered.
+  Application::wake_up();
+}
+
+void_t  ImageDecoder::worker() noexcept(true)
+{
+  while ( true )
+  {
+    std::unique_lock _lock( m_mtxRequests );
+
+    m_cvRequests.wait( _lock, [this]() { return m_exit || ( m_requests.empty() == false ); } );
+    if ( m_exit )
+      break;
+
+    request_t request = std::move( m_requests.front() );
+    m_requests.pop_front();
+    m_running++;
+
+    _lock.unlock();
+
+    run( request );
+
+    _lock.lock();
+    m_running--;
+  }
+}
+
+void_t  ImageDecoder::on_initialize() noexcept(true)
+{
+  m_vWorkers.reserve( m_workers );
+
+  for ( uint32_t i = 0; i < m_workers; ++i )
+  {
+    m_vWorkers.emplace_back( &ImageDecoder::worker, this );
+  }
+}
+
+void_t  ImageDecoder::on_finalize() noexcept(true)
+{
+  {
+    std::lock_guard _mtx( m_mtxRequests );
+    m_exit = true;
+  }
+  m_cvRequests.notify_all();
+
+  for ( std::thread& th : m_vWorkers )
+  {
+    if ( th.joinable() )
+      th.join();
+  }
+  m_vWorkers.clear();
+
+  // Consumers waiting for their images can release the resources held for them.
+  for ( request_t& request : m_requests )
+  {
+    if ( request.events != nullptr )
+      request.events->on_image_decoded( decoded_t{ request.id, std::move(request.name), nullptr } );
+  }
+
+  m_requests.clear();
+  m_decoded.clear();
+}
+
+}
@@ -38,6 +38,17 @@ Program*   ProgramsCollector::find( const std::string& name ) noexcept
 
   return iter->second.get();
 }
+
+Program*   ProgramsCollector::find( program_ref_t& ref ) noexcept
+{
+  if ( ref.generation != s_generation )
+  {
+    ref.program    = find( ref.name );
+    ref.generation = s_generation;
+  }
+  
+  return ref.program;
+}
     
 Program*   ProgramsCollector::create( const std::string& name, const std::vector< std::pair<int,std::string> >& attributes ) noexcept
 {
@@ -97,6 +108,7 @@ bool  ProgramsCollector::attach( const std::string& name, Program* pProgram ) no
     return false;
   
   m_mapPrograms[name] = std::unique_ptr<Program>(pProgram); 
+  s_generation++;
   
   return true;
 }
@@ -110,6 +122,7 @@ Program*  ProgramsCollector::detach( const std::string& name ) noexcept
   Program* pProgram = iter->second.release();
   
   m_mapPrograms.erase(iter);
+  s_generation++;
   
   return pProgram;
 }
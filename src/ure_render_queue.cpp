@@ -0,0 +1,104 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_render_queue.h"
+#include "ure_scene_node_base.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace ure {
+
+void_t  RenderQueue::clear() noexcept(true)
+{
+  m_vItems.clear();
+  m_vMatrices.clear();
+}
+
+void_t  RenderQueue::push( uint64_t key, SceneNodeBase* node, const glm::mat4& mvp ) noexcept(true)
+{
+  m_vItems.push_back( item_t{ key, node, static_cast<uint32_t>(m_vMatrices.size()) } );
+  m_vMatrices.push_back( mvp );
+}
+
+void_t  RenderQueue::sort() noexcept(true)
+{
+  const auto _start = std::chrono::steady_clock::now();
+
+  const std::size_t _count = m_vItems.size();
+
+  m_vScratch.resize( _count );
+
+  /* One histogram for each byte, computed in a single pass */
+  std::array<std::array<uint32_t,256>,8> _histograms = {};
+
+  for ( const item_t& item : m_vItems )
+  {
+    for ( uint32_t b = 0; b < 8; ++b )
+      _histograms[b][ ( item.key >> ( b * 8 ) ) & 0xFF ]++;
+  }
+
+  item_t* pSrc = m_vItems.data();
+  item_t* pDst = m_vScratch.data();
+
+  for ( uint32_t b = 0; b < 8; ++b )
+  {
+    std::array<uint32_t,256>& _counts = _histograms[b];
+
+    /* All keys share this byte, order would not change */
+    if ( ( _count == 0 ) || ( _counts[ ( pSrc[0].key >> ( b * 8 ) ) & 0xFF ] == _count ) )
+      continue;
+
+    uint32_t _offset = 0;
+    for ( uint32_t& c : _counts )
+    {
+      const uint32_t _c = c;
+      c        = _offset;
+      _offset += _c;
+    }
+
+    for ( std::size_t i = 0; i < _count; ++i )
+      pDst[ _counts[ ( pSrc[i].key >> ( b * 8 ) ) & 0xFF ]++ ] = pSrc[i];
+
+    std::swap( pSrc, pDst );
+  }
+
+  if ( pSrc != m_vItems.data() )
+    m_vItems.swap( m_vScratch );
+
+  m_stats.items       = static_cast<uint32_t>(_count);
+  m_stats.translucent = static_cast<uint32_t>( std::count_if( m_vItems.begin(), m_vItems.end(), []( const item_t& item ) { return is_translucent( item.key ); } ) );
+  m_stats.sort_us     = static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - _start ).count() );
+  m_stats.max_sort_us = std::max( m_stats.max_sort_us, m_stats.sort_us );
+}
+
+void_t  RenderQueue::submit( const camera_ptr& camera ) noexcept(true)
+{
+  for ( const item_t& item : m_vItems )
+  {
+    item.node->draw_item( m_vMatrices[item.matrix], camera );
+  }
+}
+
+}
@@ -23,6 +23,102 @@
 
 #include "ure_resources_collector.h"
 
+#include <algorithm>
+
 namespace ure {
 
+void_t  ResourcesCollector::set_budget( std::size_t bytes ) noexcept(true)
+{
+  m_budget = bytes;
+
+  trim();
+}
+
+uint32_t  ResourcesCollector::trim() noexcept(true)
+{
+  /* Usage is kept up to date by attach(), detach() and update_cost() */
+  if ( ( m_budget == 0 ) || ( m_stats.usage <= m_budget ) )
+    return 0;
+
+  uint32_t _evicted = 0;
+
+  /* Most recently used resource is never released, it has just been attached or requested */
+  auto iter = m_lstLRU.end();
+  while ( ( m_stats.usage > m_budget ) && ( iter != m_lstLRU.begin() ) && ( std::prev(iter) != m_lstLRU.begin() ) )
+  {
+    --iter;
+
+    map_resources_t::iterator _res  = m_mapResources.find( *iter );
+    const item_t&             _item = *_res->second;
+
+    if ( ( _item._flags & word_t(resource_flag_t::PRESERVE) ) || ( _item._obj.use_count() > 1 ) )
+      continue;
+
+    const std::string _name = std::move( *iter );
+    const std::size_t _cost = _item._cost;
+
+    m_slots.erase( _item._handle );
+    iter = m_lstLRU.erase( iter );
+    m_mapResources.erase( _res );
+
+    m_stats.resources--;
+    m_stats.usage -= _cost;
+    m_stats.evictions++;
+    m_stats.evicted_bytes += _cost;
+    ++_evicted;
+
+    for ( ResourcesCollectorEvents* pEvents : m_vEvents )
+      pEvents->on_resource_evicted( _name, _cost );
+  }
+
+  return _evicted;
+}
+
+bool_t  ResourcesCollector::update_cost( const node_handle_t& handle, std::size_t size ) noexcept(true)
+{
+  item_t** ppItem = m_slots.get( handle );
+  if ( ppItem == nullptr )
+    return false;
+
+  item_t& _item = **ppItem;
+
+  _item._size    = size;
+  m_stats.usage -= _item._cost;
+  _item._cost    = _item.get_cost();
+  m_stats.usage += _item._cost;
+  m_stats.peak   = std::max( m_stats.peak, m_stats.usage );
+
+  trim();
+
+  return true;
+}
+
+bool_t  ResourcesCollector::update_cost( const std::string& name, std::size_t size ) noexcept(true)
+{
+  map_resources_t::iterator  iter = m_mapResources.find( name );
+  if ( iter == m_mapResources.end() )
+    return false;
+
+  return update_cost( iter->second->_handle, size );
+}
+
+bool_t  ResourcesCollector::connect( ResourcesCollectorEvents* pEvents ) noexcept(true)
+{
+  if ( ( pEvents == nullptr ) || ( std::find( m_vEvents.begin(), m_vEvents.end(), pEvents ) != m_vEvents.end() ) )
+    return false;
+
+  m_vEvents.push_back( pEvents );
+  return true;
+}
+
+bool_t  ResourcesCollector::disconnect( ResourcesCollectorEvents* pEvents ) noexcept(true)
+{
+  auto iter = std::find( m_vEvents.begin(), m_vEvents.end(), pEvents );
+  if ( iter == m_vEvents.end() )
+    return false;
+
+  m_vEvents.erase( iter );
+  return true;
+}
+
 }
\ No newline at end of file
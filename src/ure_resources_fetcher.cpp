@@ -0,0 +1,98 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_resources_fetcher.h"
+#include "ure_application.h"
+
+#include <chrono>
+
+namespace ure {
+
+bool_t ResourcesFetcher::post( completion_t* completion ) noexcept(true)
+{
+  if ( m_mbxCompletions.write( completion ) != core::result_t::eSuccess )
+    return false;
+
+  // Main loop can be waiting for events when nothing has to be rendered.
+  Application::wake_up();
+
+  return true;
+}
+
+void_t ResourcesFetcher::clear_completions() noexcept(true)
+{
+  completion_t* pCompletion = nullptr;
+  while ( m_mbxCompletions.read( pCompletion, 0 ) == core::result_t::eSuccess )
+  {
+    delete pCompletion;
+  }
+
+  std::lock_guard _mtx(m_mtx_fetch);
+  m_posted.clear();
+}
+
+uint32_t ResourcesFetcher::dispatch( uint32_t max_completions, uint32_t max_time_us ) noexcept(true)
+{
+  using clock_t = std::chrono::steady_clock;
+
+  const clock_t::time_point _start       = clock_t::now();
+  uint32_t                  _completions = 0;
+  completion_t*             pCompletion  = nullptr;
+
+  while ( ( max_completions == 0 ) || ( _completions < max_completions ) )
+  {
+    if ( m_mbxCompletions.read( pCompletion, 0 ) != core::result_t::eSuccess )
+      break;
+
+    std::unique_ptr<completion_t> _completion( pCompletion );
+
+    /* Callbacks are serialized with cancel(), that drops completions not yet notified */
+    std::lock_guard _notify( m_mtx_notify );
+    if ( unpost( _completion->m_request ) == false )
+      continue;
+
+    switch ( _completion->m_kind )
+    {
+      case completion_t::kind_t::eSucceeded:
+        _completion->m_events.on_download_succeeded( _completion->m_app_id, _completion->m_name, _completion->m_cr, _completion->m_type, 
+                                                     _completion->m_body.data(), _completion->m_body.length() );
+      break;
+      case completion_t::kind_t::eMoved:
+        _completion->m_events.on_download_moved( _completion->m_app_id, _completion->m_name, _completion->m_cr, _completion->m_type, 
+                                                 std::move(_completion->m_body) );
+      break;
+      case completion_t::kind_t::eFailed:
+        _completion->m_events.on_download_failed( _completion->m_app_id, _completion->m_name, _completion->m_cr );
+      break;
+    }
+
+    ++_completions;
+
+    if ( ( max_time_us > 0 ) && ( std::chrono::duration_cast<std::chrono::microseconds>( clock_t::now() - _start ).count() >= max_time_us ) )
+      break;
+  }
+
+  return _completions;
+}
+
+}
@@ -26,7 +26,7 @@
 
 namespace ure {
 
-bool_t SceneLayerNode::render( const glm::mat4& mProjection, const camera_ptr& camera ) noexcept(true)
+bool_t SceneLayerNode::render( const glm::mat4& mViewProjection, const camera_ptr& camera ) noexcept(true)
 {
   std::shared_ptr<widgets::Layer> layer = get_object<widgets::Layer>();
   if ( layer == nullptr )
@@ -35,16 +35,94 @@ bool_t SceneLayerNode::render( const glm::mat4& mProjection, const camera_ptr& c
   if ( layer->is_visible() == false )
     return false;
 
-  // Retrieving camera (view) matrix from active camera.
-  // If not present an identity matrix will be used.
-  glm::mat4  mView = (camera==nullptr)?glm::mat4(1.0f):camera->get_view_matrix().get();
-  
-  glm::mat4  mvp =  mProjection * mView * m_matModel.get();
+  const glm::mat4 mvp     = get_mvp( mViewProjection );
+  bool_t          _retval = false;
 
-  if (has_animation() == true )
-    mvp *= get_animation().get_matrix().get();
+  if ( is_culled( mvp ) == false )
+    _retval = layer->render( mvp );
+
+  // Child nodes are drawn over the layer.
+  render_children( mViewProjection, camera );
+
+  return _retval;
+}
+
+void_t SceneLayerNode::enqueue( RenderQueue& queue, const glm::mat4& mViewProjection, const camera_ptr& camera ) noexcept(true)
+{
+  std::shared_ptr<widgets::Layer> layer = get_object<widgets::Layer>();
+  if ( ( layer == nullptr ) || ( layer->is_visible() == false ) )
+    return;
+
+  const glm::mat4 mvp = get_mvp( mViewProjection );
+
+  if ( is_culled( mvp ) == false )
+  {
+    // Sort by depth of layer center, background texture is the only known state.
+    aabb_t    box;
+    get_bounds( box );
+
+    const glm::vec4 center  = mvp * glm::vec4( ( box.min.x + box.max.x ) * 0.5f, ( box.min.y + box.max.y ) * 0.5f, 0.0f, 1.0f );
+    const float_t   depth   = ( center.w != 0.0f )? center.z / center.w : 0.0f;
+    const uint32_t  texture = ( layer->get_bk_image() != nullptr )? layer->get_bk_image()->get_id() : 0;
+
+    queue.push( RenderQueue::make_key( get_render_order(), !is_opaque(), 0, texture, depth ), this, mvp );
+  }
+
+  enqueue_children( queue, mViewProjection, camera );
+}
+
+bool_t SceneLayerNode::draw_item( const glm::mat4& mvp, [[maybe_unused]] const camera_ptr& camera ) noexcept(true)
+{
+  std::shared_ptr<widgets::Layer> layer = get_object<widgets::Layer>();
+  if ( layer == nullptr )
+    return false;
 
   return layer->render( mvp );
 }
 
+glm::mat4 SceneLayerNode::get_mvp( const glm::mat4& mViewProjection ) noexcept(true)
+{
+  // Camera (view) matrix is already part of view projection matrix, 
+  // world matrix includes parent nodes transformations.
+  glm::mat4  mvp =  mViewProjection * get_world_matrix();
+
+  if ( has_animation() == true )
+    mvp *= get_animation().get_matrix().get();
+
+  return mvp;
+}
+
+bool_t SceneLayerNode::is_culled( const glm::mat4& mvp ) const noexcept(true)
+{
+  // Layer outside the view frustum is skipped, child nodes have their own bounds.
+  aabb_t        box;
+  cull_stats_t* pStats  = get_cull_counters();
+  const bool_t  _culled = get_bounds( box ) && is_outside_frustum( mvp, box );
+
+  if ( pStats != nullptr )
+  {
+    if ( _culled )
+      pStats->culled++;
+    else
+      pStats->visible++;
+  }
+
+  return _culled;
+}
+
+bool_t SceneLayerNode::get_bounds( aabb_t& box ) const noexcept(true)
+{
+  std::shared_ptr<widgets::Layer> layer = get_object<widgets::Layer>();
+  if ( layer == nullptr )
+    return false;
+
+  const float_t x = layer->get_position().x;
+  const float_t y = layer->get_position().y;
+
+  box.min = glm::vec3( x, y, 0.0f );
+  box.max = glm::vec3( x + layer->get_size().width, y + layer->get_size().height, 0.0f );
+
+  return true;
+}
+
 }
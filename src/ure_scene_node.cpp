@@ -25,7 +25,16 @@
 
 namespace ure {
 
-bool_t  SceneNode::add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true)
+cull_stats_t* SceneNode::s_pCullStats = nullptr;
+
+cull_stats_t* SceneNode::set_cull_counters( cull_stats_t* pStats ) noexcept(true)
+{
+  cull_stats_t* pPrevious = s_pCullStats;
+  s_pCullStats = pStats;
+  return pPrevious;
+}
+
+node_handle_t  SceneNode::add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true)
 {  
   const std::string& sNodeType       = pSceneNode->type();
   
@@ -41,14 +50,32 @@ bool_t  SceneNode::add_scene_node( SceneNodeBase* pSceneNode ) noexcept(true)
   
   scene_node_map_t& rSceneNodeMap = *_iter->second.get();
   
-  // If a scene node with the same instance name is already present the function return false.
+  // If a scene node with the same instance name is already present the function return an invalid handle.
   if ( rSceneNodeMap.find(pSceneNode->name()) != rSceneNodeMap.end() )
-    return false;
+    return k_invalid_handle;
 
-  // Scene Node will be registered and then function return TRUE 
+  // Scene Node will be registered and then function return its handle 
   rSceneNodeMap[pSceneNode->name()] = std::unique_ptr<SceneNodeBase>(pSceneNode);
+  m_vChildren.push_back( pSceneNode );
+
+  // World matrix of the node will be relative to this node.
+  if ( TransformSystem::is_valid() && ( get_transform() != TransformSystem::k_invalid_transform ) )
+    TransformSystem::get_instance()->set_parent( pSceneNode->get_transform(), get_transform() );
+
+  if ( on_add_scene_node(pSceneNode) == false )
+  {
+    // Rollback registration, ownership goes back to the caller.
+    if ( TransformSystem::is_valid() && ( get_transform() != TransformSystem::k_invalid_transform ) )
+      TransformSystem::get_instance()->set_parent( pSceneNode->get_transform(), TransformSystem::k_invalid_transform );
+
+    m_vChildren.pop_back();
+    rSceneNodeMap[pSceneNode->name()].release();
+    rSceneNodeMap.erase( pSceneNode->name() );
+
+    return k_invalid_handle;
+  }
 
-  return on_add_scene_node(pSceneNode);
+  return m_nodes.insert( pSceneNode );
 }
 
 const SceneNode::scene_node_map_t*   SceneNode::get_scene_node_map( const std::string& sNodeType ) const noexcept(true)
@@ -22,30 +22,47 @@
  *************************************************************************************************/
 
  #include "ure_texture.h"
+#include "ure_texture_residency.h"
+
+#include <algorithm>
 
 namespace ure {
 
-Texture::Texture( sizei_t width, sizei_t height, format_t format, type_t type ) noexcept(true)
+Texture::Texture( sizei_t width, sizei_t height, format_t format, type_t type, lifecycle_t lifecycle ) noexcept(true)
   : HandledObject(URE_INVALID_HANDLE),
-    m_size( width, height ), m_format( format ), m_type( type ), m_lifecycle(lifecycle_t::eRender),
-    m_length( 0 ), m_pixels( nullptr )
+    m_size( width, height ), m_format( format ), m_type( type ), m_lifecycle( lifecycle ),
+    m_length( 0 ), m_pixels( nullptr ), m_dirty_first( 0 ), m_dirty_last( 0 )
 { 
-  tex_alloc();
+  if ( lifecycle == lifecycle_t::eTarget )
+    m_length = m_size.width*m_size.height*get_bytes_per_pixel();
+  else
+    tex_alloc();
 }
 
 Texture::Texture( Image&& image, lifecycle_t lifecycle,
                   int_t tws,
                   int_t twt
                 ) noexcept(true)
-  : HandledObject(URE_INVALID_HANDLE)
+  : HandledObject(URE_INVALID_HANDLE),
+    m_size( 0, 0 ), m_format( format_t::eUndefined ), m_type( type_t::eUndefined ), m_lifecycle( lifecycle ),
+    m_length( 0 ), m_pixels( nullptr ), m_dirty_first( 0 ), m_dirty_last( 0 )
 {
-  if ( image.get_format() == Image::format_t::eRGBA )
+  switch ( image.get_format() )
+  {
+    case Image::format_t::eAlpha         : m_format = format_t::eAlpha         ; m_type = type_t::eUnsignedByte      ; break;
+    case Image::format_t::eLuminance     : m_format = format_t::eLuminance     ; m_type = type_t::eUnsignedByte      ; break;
+    case Image::format_t::eLuminanceAlpha: m_format = format_t::eLuminanceAlpha; m_type = type_t::eUnsignedByte      ; break;
+    case Image::format_t::eRGB           : m_format = format_t::eRGB           ; m_type = type_t::eUnsignedByte      ; break;
+    case Image::format_t::eRGBA          : m_format = format_t::eRGBA          ; m_type = type_t::eUnsignedByte      ; break;
+    case Image::format_t::eRGB565        : m_format = format_t::eRGB           ; m_type = type_t::eUnsignedShort565  ; break;
+    case Image::format_t::eRGBA4444      : m_format = format_t::eRGBA          ; m_type = type_t::eUnsignedShort4444 ; break;
+    default: break;
+  }
+
+  if ( m_format != format_t::eUndefined )
   {
     m_size      = image.get_size();
-    m_format    = format_t::eRGBA;
-    m_type      = type_t::eUnsignedByte;
     m_pixels    = image.detach(&m_length);
-    m_lifecycle = lifecycle;
     if ( lifecycle == lifecycle_t::eObject )
     {
       if ( tex_create( GL_TEXTURE_2D, 0, tws, twt ) == true )
@@ -62,12 +79,34 @@ Texture::Texture( Image&& image, lifecycle_t lifecycle,
 
 Texture::~Texture() noexcept(true)
 {
+  if ( TextureResidency::is_valid() )
+    TextureResidency::get_instance()->remove( *this );
+
+  tex_destroy();
+
   tex_free(); 
 }
 
+void_t  Texture::update_rows( sizei_t first, sizei_t count ) noexcept(true)
+{
+  if ( ( count <= 0 ) || ( first < 0 ) || ( first + count > m_size.height ) )
+    return;
+
+  if ( m_dirty_last == m_dirty_first )
+  {
+    m_dirty_first = first;
+    m_dirty_last  = first + count;
+  }
+  else
+  {
+    m_dirty_first = std::min( m_dirty_first, first         );
+    m_dirty_last  = std::max( m_dirty_last , first + count );
+  }
+}
+
 bool_t  Texture::tex_alloc() noexcept(true)
 {
-  if ( m_type != type_t::eUnsignedByte )
+  if ( m_type == type_t::eUndefined )
     return false;
 
   if ( m_pixels != nullptr )
@@ -75,15 +114,7 @@ bool_t  Texture::tex_alloc() noexcept(true)
     free( m_pixels );
     m_pixels = nullptr;
   }
-  // Accepted values
-  int bpp = 4;
-  switch ( m_format )
-  {
-    case format_t::eRGB : bpp = 3; break;
-    default:              bpp = 4; break;
-  }
-
-  m_length      = m_size.width*m_size.height*bpp;
+  m_length      = m_size.width*m_size.height*get_bytes_per_pixel();
 
   if ( m_pixels == nullptr )
   {
@@ -0,0 +1,436 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_texture_loader.h"
+#include "ure_texture.h"
+#include "ure_image_decoder.h"
+#include "ure_resources_collector.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace ure {
+
+/**
+ * Completions are only queued here, they are moved through the stages by update().
+ */
+class TextureLoader::pipe_t final : public ResourcesFetcherEvents, public ImageDecoderEvents
+{
+public:
+  /***/
+  struct downloaded_t {
+    std::string             name;
+    ImageDecoder::data_t    body;
+    bool_t                  succeeded;
+  };
+
+  /**
+   * Requests are made with edfMove, so the body is taken without any copy.
+   */
+  virtual void_t    on_download_moved    ( [[maybe_unused]] const std::string_view app_id,
+                                           const std::string_view name,
+                                           [[maybe_unused]] customer_request_t cr,
+                                           [[maybe_unused]] const std::type_info& type,
+                                           body_t&& body
+                                         ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_downloaded.push_back( downloaded_t{ std::string(name), std::move(body), true } );
+  }
+
+  /***/
+  virtual void_t    on_download_succeeded( [[maybe_unused]] const std::string_view app_id,
+                                           const std::string_view name,
+                                           [[maybe_unused]] customer_request_t cr,
+                                           [[maybe_unused]] const std::type_info& type,
+                                           const byte_t* data,
+                                           uint_t length
+                                         ) noexcept(true) override
+  {
+    ImageDecoder::data_t _body;
+    if ( ( data != nullptr ) && ( length > 0 ) )
+      _body.copy( data, length );
+
+    std::lock_guard _mtx( m_mtx );
+    m_downloaded.push_back( downloaded_t{ std::string(name), std::move(_body), true } );
+  }
+  /***/
+  virtual void_t    on_download_failed   ( [[maybe_unused]] const std::string_view app_id,
+                                           const std::string_view name,
+                                           [[maybe_unused]] customer_request_t cr
+                                         ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_downloaded.push_back( downloaded_t{ std::string(name), {}, false } );
+  }
+  /***/
+  virtual void_t    on_image_decoded( ImageDecoder::decoded_t&& decoded ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_decoded.push_back( std::move(decoded) );
+  }
+
+  /**
+   * Take all completions queued so far.
+   */
+  void_t            take( std::deque<downloaded_t>& downloaded, std::deque<ImageDecoder::decoded_t>& decoded ) noexcept(true)
+  {
+    std::lock_guard _mtx( m_mtx );
+    downloaded.swap( m_downloaded );
+    decoded.swap( m_decoded );
+  }
+
+private:
+  std::mutex                            m_mtx;
+  std::deque<downloaded_t>              m_downloaded;
+  std::deque<ImageDecoder::decoded_t>   m_decoded;
+};
+
+
+TextureLoader::TextureLoader( std::shared_ptr<Texture> placeholder, ResourcesCollector* pCollector, Image::loader_t il ) noexcept(true)
+  : m_placeholder( std::move(placeholder) ), m_pCollector( pCollector ), m_loader( il ),
+    m_app_id( core::utils::format( "texture-loader-%p", static_cast<void*>(this) ) ),
+    m_limits( k_default_limits ), m_pipe( new(std::nothrow) pipe_t() ),
+    m_fetching( 0 ), m_decoding( 0 ), m_stats( {} )
+{
+}
+
+TextureLoader::~TextureLoader() noexcept(true)
+{
+  /* Fetcher holds a plain reference to the pipe: once cancel() returns no callback is running
+   * or will be notified for the request, including completions still queued for dispatch(). 
+   * Requests are kept until update() takes their completion, so none of them is missed here. */
+  if ( ResourcesFetcher::is_valid() )
+  {
+    for ( auto& [name, item] : m_items )
+    {
+      if ( item.request != ResourcesFetcher::k_invalid_request )
+      {
+        ResourcesFetcher::get_instance()->cancel( item.request );
+        item.request = ResourcesFetcher::k_invalid_request;
+      }
+    }
+  }
+
+  /* Images still in decoding will be released with the pipe by the last worker using it */
+  m_pipe.reset();
+}
+
+void_t TextureLoader::set_limits( const limits_t& limits ) noexcept(true)
+{
+  m_limits.fetching = std::max( limits.fetching, 1u );
+  m_limits.decoding = std::max( limits.decoding, 1u );
+  m_limits.uploads  = std::max( limits.uploads , 1u );
+}
+
+TextureLoader::handle_t TextureLoader::load( const std::string& name, const std::string& url, int32_t priority, bool_t verify_ssl ) noexcept(true)
+{
+  if ( name.empty() || url.empty() || ( m_pipe == nullptr ) )
+    return nullptr;
+
+  auto iter = m_items.find( name );
+  if ( iter != m_items.end() )
+  {
+    iter->second.cancelled = false;
+    return iter->second.handle;
+  }
+
+  if ( m_pCollector != nullptr )
+  {
+    auto texture = m_pCollector->find<Texture>( name );
+    if ( texture.has_value() )
+      return std::make_shared<Handle>( name, texture.value(), status_t::eResident );
+  }
+
+  handle_t _handle = std::make_shared<Handle>( name, m_placeholder, status_t::eWaiting );
+
+  m_items.emplace( name, item_t{ _handle, url, priority, verify_ssl, false, ResourcesFetcher::k_invalid_request, clock_t::now() } );
+  enqueue( name, priority );
+
+  return _handle;
+}
+
+bool_t TextureLoader::set_priority( const handle_t& handle, int32_t priority ) noexcept(true)
+{
+  if ( handle == nullptr )
+    return false;
+
+  auto iter = m_items.find( handle->get_name() );
+  if ( ( iter == m_items.end() ) || ( iter->second.handle != handle ) )
+    return false;
+
+  item_t& _item = iter->second;
+  _item.priority = priority;
+
+  switch ( handle->m_status )
+  {
+    case status_t::eWaiting:
+      m_waiting.erase( std::find( m_waiting.begin(), m_waiting.end(), handle->get_name() ) );
+      enqueue( handle->get_name(), priority );
+    break;
+    case status_t::eFetching:
+      if ( _item.request != ResourcesFetcher::k_invalid_request )
+        ResourcesFetcher::get_instance()->set_priority( _item.request, priority );
+    break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+bool_t TextureLoader::cancel( const handle_t& handle ) noexcept(true)
+{
+  if ( handle == nullptr )
+    return false;
+
+  auto iter = m_items.find( handle->get_name() );
+  if ( ( iter == m_items.end() ) || ( iter->second.handle != handle ) )
+    return false;
+
+  item_t& _item = iter->second;
+
+  switch ( handle->m_status )
+  {
+    case status_t::eWaiting:
+      m_waiting.erase( std::find( m_waiting.begin(), m_waiting.end(), handle->get_name() ) );
+    break;
+    case status_t::eFetching:
+    {
+      ResourcesFetcher::get_instance()->cancel( _item.request );
+
+      auto downloaded = std::find_if( m_downloaded.begin(), m_downloaded.end(), 
+                                      [&handle]( const auto& body ){ return body.first == handle->get_name(); } );
+      if ( downloaded != m_downloaded.end() )
+        m_downloaded.erase( downloaded );
+
+      m_fetching--;
+    }
+    break;
+    case status_t::eDecoding:
+    {
+      auto decoded = std::find_if( m_decoded.begin(), m_decoded.end(), 
+                                   [&handle]( const auto& image ){ return image.first == handle->get_name(); } );
+      if ( decoded == m_decoded.end() )
+      {
+        /* Decoder can't be stopped, result will be dropped */
+        _item.cancelled = true;
+        return true;
+      }
+
+      m_decoded.erase( decoded );
+    }
+    break;
+    default:
+      return false;
+  }
+
+  m_items.erase( iter );
+  return true;
+}
+
+uint32_t TextureLoader::update( uint32_t max_time_us ) noexcept(true)
+{
+  if ( m_pipe == nullptr )
+    return 0;
+
+  std::deque<pipe_t::downloaded_t>      _downloaded;
+  std::deque<ImageDecoder::decoded_t>   _decoded;
+
+  m_pipe->take( _downloaded, _decoded );
+
+  /* Downloads completed keep their slot until a decoder is available */
+  for ( pipe_t::downloaded_t& _body : _downloaded )
+  {
+    auto iter = m_items.find( _body.name );
+    if ( ( iter == m_items.end() ) || ( iter->second.handle->m_status != status_t::eFetching ) )
+      continue;
+
+    item_t& _item = iter->second;
+    _item.request = ResourcesFetcher::k_invalid_request;
+
+    if ( ( _body.succeeded == false ) || ( _body.body.data() == nullptr ) || ( _body.body.length() == 0 ) )
+    {
+      m_fetching--;
+      fail( _item );
+      m_items.erase( iter );
+      continue;
+    }
+
+    complete( m_stats.fetch, _item.started );
+    m_downloaded.emplace_back( std::move(_body.name), std::move(_body.body) );
+  }
+
+  /* Decoded images keep their slot until they are uploaded */
+  for ( ImageDecoder::decoded_t& _image : _decoded )
+  {
+    auto iter = m_items.find( _image.name );
+    if ( ( iter == m_items.end() ) || ( iter->second.handle->m_status != status_t::eDecoding ) )
+      continue;
+
+    item_t& _item = iter->second;
+    m_decoding--;
+
+    if ( _item.cancelled || ( _image.image == nullptr ) )
+    {
+      if ( _item.cancelled == false )
+        fail( _item );
+      m_items.erase( iter );
+      continue;
+    }
+
+    complete( m_stats.decode, _item.started );
+    _item.started = clock_t::now();
+    m_decoded.emplace_back( std::move(_image.name), std::move(_image.image) );
+  }
+
+  /* Upload stage, bounded in count and time since it runs on the render thread */
+  const clock_t::time_point _start   = clock_t::now();
+  uint32_t                  _uploads = 0;
+
+  while ( ( m_decoded.empty() == false ) && ( _uploads < m_limits.uploads ) )
+  {
+    if ( ( max_time_us > 0 ) && ( std::chrono::duration_cast<std::chrono::microseconds>( clock_t::now() - _start ).count() >= max_time_us ) )
+      break;
+
+    std::string            _name  = std::move( m_decoded.front().first );
+    std::unique_ptr<Image> _image = std::move( m_decoded.front().second );
+    m_decoded.pop_front();
+
+    auto iter = m_items.find( _name );
+    if ( iter == m_items.end() )
+      continue;
+
+    item_t& _item = iter->second;
+
+    std::shared_ptr<Texture> _texture( new(std::nothrow) Texture( std::move(*_image) ) );
+    if ( ( _texture == nullptr ) || ( _texture->bind( GL_TEXTURE_2D, 0 ) == false ) )
+    {
+      fail( _item );
+      m_items.erase( iter );
+      continue;
+    }
+    _texture->unbind( GL_TEXTURE_2D );
+
+    if ( m_pCollector != nullptr )
+      m_pCollector->attach<Texture>( _name, _texture );
+
+    _item.handle->m_texture = std::move(_texture);
+    _item.handle->m_status  = status_t::eResident;
+
+    complete( m_stats.upload, _item.started );
+    m_items.erase( iter );
+    ++_uploads;
+  }
+
+  /* Start decoding when there is room for the image */
+  while ( ( m_downloaded.empty() == false ) && ( m_decoding + m_decoded.size() < m_limits.decoding ) )
+  {
+    std::string          _name = std::move( m_downloaded.front().first );
+    ImageDecoder::data_t _body = std::move( m_downloaded.front().second );
+    m_downloaded.pop_front();
+    m_fetching--;
+
+    item_t& _item = m_items.at( _name );
+    _item.handle->m_status = status_t::eDecoding;
+    _item.started          = clock_t::now();
+    m_decoding++;
+
+    /* Without workers the image is decoded and queued within the call */
+    if ( ImageDecoder::get_instance()->decode( m_loader, _name, std::move(_body), m_pipe ) == ImageDecoder::k_invalid_request )
+    {
+      m_decoding--;
+      fail( _item );
+      m_items.erase( _name );
+    }
+  }
+
+  /* Start downloads when there is room for the body */
+  while ( ( m_waiting.empty() == false ) && ( m_fetching < m_limits.fetching ) )
+  {
+    std::string _name = std::move( m_waiting.front() );
+    m_waiting.pop_front();
+
+    item_t& _item = m_items.at( _name );
+    _item.handle->m_status = status_t::eFetching;
+    _item.started          = clock_t::now();
+    _item.request          = ResourcesFetcher::get_instance()->fetch( *m_pipe, std::string(m_app_id), std::string(_name), typeid(Texture), std::string(_item.url), 
+                                                                      customer_request_t::Get, {}, {}, _item.verify_ssl, edfMove, _item.priority );
+    if ( _item.request == ResourcesFetcher::k_invalid_request )
+    {
+      fail( _item );
+      m_items.erase( _name );
+      continue;
+    }
+
+    m_fetching++;
+  }
+
+  return _uploads;
+}
+
+bool_t TextureLoader::is_idle() const noexcept(true)
+{
+  return m_waiting.empty() && ( m_fetching == 0 ) && ( m_decoding == 0 ) && m_decoded.empty();
+}
+
+TextureLoader::stats_t TextureLoader::get_stats() const noexcept(true)
+{
+  stats_t _stats = m_stats;
+
+  _stats.waiting       = static_cast<uint32_t>( m_waiting.size() );
+  _stats.fetch.depth   = m_fetching;
+  _stats.decode.depth  = m_decoding;
+  _stats.upload.depth  = static_cast<uint32_t>( m_decoded.size() );
+
+  return _stats;
+}
+
+void_t TextureLoader::reset_stats() noexcept(true)
+{
+  m_stats = {};
+}
+
+void_t TextureLoader::fail( item_t& item ) noexcept(true)
+{
+  item.handle->m_status = status_t::eFailed;
+  m_stats.failed++;
+}
+
+void_t TextureLoader::enqueue( const std::string& name, int32_t priority ) noexcept(true)
+{
+  auto iter = std::find_if( m_waiting.begin(), m_waiting.end(), 
+                            [this, priority]( const std::string& waiting ){ return m_items.at( waiting ).priority < priority; } );
+  m_waiting.insert( iter, name );
+}
+
+void_t TextureLoader::complete( stage_stats_t& stage, clock_t::time_point started ) noexcept(true)
+{
+  const uint64_t _elapsed = static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::microseconds>( clock_t::now() - started ).count() );
+
+  stage.completed++;
+  stage.total_us += _elapsed;
+  stage.max_us    = std::max( stage.max_us, _elapsed );
+}
+
+}
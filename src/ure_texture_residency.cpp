@@ -0,0 +1,105 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_texture_residency.h"
+#include "ure_texture.h"
+
+namespace ure {
+
+void_t  TextureResidency::set_budget( uint64_t bytes ) noexcept(true)
+{
+  m_budget = bytes;
+
+  evict( 0 );
+}
+
+void_t  TextureResidency::insert( Texture& texture ) noexcept(true)
+{
+  if ( m_mapLru.find( &texture ) != m_mapLru.end() )
+  {
+    touch( texture );
+    return;
+  }
+
+  const uint64_t bytes = texture.get_length();
+
+  evict( bytes );
+
+  m_lru.push_front( &texture );
+  m_mapLru[&texture] = m_lru.begin();
+
+  m_stats.textures++;
+  m_stats.resident_bytes += bytes;
+  m_stats.uploads++;
+  m_stats.uploaded_bytes += bytes;
+}
+
+void_t  TextureResidency::touch( const Texture& texture ) noexcept(true)
+{
+  auto iter = m_mapLru.find( &texture );
+  if ( iter == m_mapLru.end() )
+    return;
+
+  m_lru.splice( m_lru.begin(), m_lru, iter->second );
+}
+
+void_t  TextureResidency::remove( const Texture& texture ) noexcept(true)
+{
+  auto iter = m_mapLru.find( &texture );
+  if ( iter == m_mapLru.end() )
+    return;
+
+  m_stats.textures--;
+  m_stats.resident_bytes -= texture.get_length();
+
+  m_lru.erase( iter->second );
+  m_mapLru.erase( iter );
+}
+
+void_t  TextureResidency::evict( uint64_t required ) noexcept(true)
+{
+  while ( ( m_lru.empty() == false ) && ( m_stats.resident_bytes + required > m_budget ) )
+  {
+    Texture* pTexture = m_lru.back();
+
+    remove( *pTexture );
+    pTexture->tex_destroy();
+
+    m_stats.evictions++;
+  }
+}
+
+void_t  TextureResidency::on_finalize() noexcept(true)
+{
+  while ( m_lru.empty() == false )
+  {
+    Texture* pTexture = m_lru.back();
+
+    remove( *pTexture );
+    pTexture->tex_destroy();
+  }
+
+  m_stats = {};
+}
+
+}
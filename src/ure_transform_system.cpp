@@ -0,0 +1,217 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "ure_transform_system.h"
+
+#include <algorithm>
+
+namespace ure {
+
+TransformSystem::transform_t  TransformSystem::allocate() noexcept(true)
+{
+  transform_t transform = k_invalid_transform;
+
+  if ( m_vFree.empty() == false )
+  {
+    transform = m_vFree.back();
+    m_vFree.pop_back();
+  }
+  else
+  {
+    transform = static_cast<transform_t>(m_vUsed.size());
+
+    if ( ( m_local.reserve( transform + 1 ) == false ) || ( m_world.reserve( transform + 1 ) == false ) )
+      return k_invalid_transform;
+
+    m_vParent.push_back( k_invalid_transform );
+    m_vDirty.push_back( 0 );
+    m_vUsed.push_back( 0 );
+  }
+
+  m_local[transform]   = glm::mat4( 1.0f );
+  m_world[transform]   = glm::mat4( 1.0f );
+  m_vParent[transform] = k_invalid_transform;
+  m_vDirty[transform]  = 0;
+  m_vUsed[transform]   = 1;
+
+  m_order_dirty = true;
+  m_changes++;
+  m_stats.transforms++;
+
+  return transform;
+}
+
+void_t  TransformSystem::release( transform_t transform ) noexcept(true)
+{
+  if ( ( transform >= m_vUsed.size() ) || ( m_vUsed[transform] == 0 ) )
+    return;
+
+  m_vUsed[transform]   = 0;
+  m_vParent[transform] = k_invalid_transform;
+  m_vDirty[transform]  = 0;
+  m_vFree.push_back( transform );
+
+  /* Children left behind become roots */
+  for ( transform_t t = 0; t < m_vParent.size(); ++t )
+  {
+    if ( m_vParent[t] == transform )
+    {
+      m_vParent[t] = k_invalid_transform;
+      m_vDirty[t]  = 1;
+      m_dirty      = true;
+    }
+  }
+
+  m_order_dirty = true;
+  m_changes++;
+  m_stats.transforms--;
+}
+
+bool_t  TransformSystem::set_parent( transform_t transform, transform_t parent ) noexcept(true)
+{
+  if ( ( transform >= m_vUsed.size() ) || ( m_vUsed[transform] == 0 ) || ( transform == parent ) )
+    return false;
+
+  if ( ( parent != k_invalid_transform ) && ( ( parent >= m_vUsed.size() ) || ( m_vUsed[parent] == 0 ) ) )
+    return false;
+
+  /* Cycles are not allowed */
+  for ( transform_t p = parent; p != k_invalid_transform; p = m_vParent[p] )
+  {
+    if ( p == transform )
+      return false;
+  }
+
+  m_vParent[transform] = parent;
+  m_vDirty[transform]  = 1;
+  m_dirty              = true;
+  m_changes++;
+
+  /* Reused slots can place a parent after its children */
+  if ( ( parent != k_invalid_transform ) && ( parent > transform ) )
+    m_linear = false;
+
+  m_order_dirty = true;
+
+  return true;
+}
+
+void_t  TransformSystem::set_trs( transform_t transform, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale ) noexcept(true)
+{
+  edit_local( transform ) = glm::translate( glm::mat4( 1.0f ), translation ) * glm::mat4_cast( rotation ) * glm::scale( glm::mat4( 1.0f ), scale );
+}
+
+uint32_t  TransformSystem::update() noexcept(true)
+{
+  if ( m_dirty == false )
+    return 0;
+
+  uint32_t _updates = 0;
+
+  auto _update = [this,&_updates]( transform_t t ) 
+  {
+    const transform_t p = m_vParent[t];
+
+    /* Parent has already been processed, its flag is still set when it changed */
+    if ( p == k_invalid_transform )
+    {
+      if ( m_vDirty[t] == 0 )
+        return;
+
+      m_world[t] = m_local[t].get();
+    }
+    else
+    {
+      if ( ( m_vDirty[t] | m_vDirty[p] ) == 0 )
+        return;
+
+      m_vDirty[t] = 1;
+      m_world[t] = m_world[p] * m_local[t].get();
+    }
+
+    ++_updates;
+  };
+
+  if ( m_order_dirty && ( m_linear == false ) )
+    sort();
+
+  if ( m_linear )
+  {
+    const transform_t _count = static_cast<transform_t>(m_vUsed.size());
+    for ( transform_t t = 0; t < _count; ++t )
+      _update( t );
+  }
+  else
+  {
+    for ( transform_t t : m_vOrder )
+      _update( t );
+  }
+
+  std::fill( m_vDirty.begin(), m_vDirty.end(), 0 );
+  m_dirty = false;
+
+  m_stats.updates += _updates;
+
+  return _updates;
+}
+
+void_t  TransformSystem::sort() noexcept(true)
+{
+  const transform_t _count = static_cast<transform_t>(m_vUsed.size());
+
+  /* Depth of each transform, then parents first */
+  std::vector<uint32_t> _depth( _count, 0 );
+  m_vOrder.clear();
+  m_linear = true;
+
+  for ( transform_t t = 0; t < _count; ++t )
+  {
+    if ( m_vUsed[t] == 0 )
+      continue;
+
+    for ( transform_t p = m_vParent[t]; p != k_invalid_transform; p = m_vParent[p] )
+      _depth[t]++;
+
+    if ( ( m_vParent[t] != k_invalid_transform ) && ( m_vParent[t] > t ) )
+      m_linear = false;
+
+    m_vOrder.push_back( t );
+  }
+
+  std::stable_sort( m_vOrder.begin(), m_vOrder.end(), [&_depth]( transform_t a, transform_t b ) { return _depth[a] < _depth[b]; } );
+
+  m_order_dirty = false;
+}
+
+void_t  TransformSystem::on_finalize() noexcept(true)
+{
+  m_local.clear();
+  m_world.clear();
+  m_vParent.clear();
+  m_vDirty.clear();
+  m_vUsed.clear();
+  m_vFree.clear();
+  m_vOrder.clear();
+}
+
+}
@@ -41,6 +41,7 @@ Window::Window()
    m_ptrWinOptions(nullptr), 
    m_hWindow( nullptr ), 
    m_ptrRenderer( nullptr ),
+   m_ptrState( nullptr ),
    m_mbxMessages( "Window Mailbox" ) 
 {
 }
@@ -40,6 +40,7 @@ bool_t  Button::set_caption( Font* pFont, const std::wstring& sCaption, const gl
 void_t  Button::set_focus( Texture* texture ) noexcept(true)
 {
   m_imFocus.reset(texture);
+  invalidate();
 }
 
 bool    Button::on_widget_draw_background( [[maybe_unused]] const Recti& rect ) noexcept(true)
@@ -33,6 +33,14 @@ Label::Label( Widget* pParent ) noexcept(true)
 {
 }
 
+Label::~Label() noexcept(true)
+{
+  _releaseQuads( 0 );
+
+  if ( m_pText != nullptr )
+    delete m_pText;
+}
+
 bool_t  Label::set_label( Font* pFont, const std::wstring& sLabel, const glm::vec4& fgColor, WidgetTextAligment align ) noexcept(true)
 {
   if ( pFont == nullptr )
@@ -48,15 +56,8 @@ bool_t  Label::set_label( Font* pFont, const std::wstring& sLabel, const glm::ve
   if ( m_pText == nullptr )
     return false;
   
-  // Default Texture coordinates
-  m_vTexCoord.clear();
-  m_vTexCoord.reserve(4);
-  m_vTexCoord.push_back( glm::vec2( 0.0f, 0.0f )  );
-  m_vTexCoord.push_back( glm::vec2( 1.0f, 0.0f )  );
-  m_vTexCoord.push_back( glm::vec2( 0.0f, 1.0f )  );
-  m_vTexCoord.push_back( glm::vec2( 1.0f, 1.0f )  );  
-  
   _updateVertices( align );
+  invalidate();
   
   return true;
 }
@@ -65,7 +66,7 @@ bool    Label::on_widget_draw( [[maybe_unused]] const Recti& rect ) noexcept(tru
 {
   if ( m_pText != nullptr )
   {
-    draw_text( m_vVertices, m_vTexCoord, *m_pText, URE_CLAMP_TO_EDGE, URE_CLAMP_TO_EDGE );
+    draw_text( m_vQuads, *m_pText, URE_CLAMP_TO_EDGE, URE_CLAMP_TO_EDGE );
   }
   
   return true;
@@ -94,9 +95,6 @@ void_t  Label::_updateVertices( WidgetTextAligment align ) noexcept(true)
   if (m_pText == nullptr )
     return;
     
-  // Remove all vertices
-  m_vVertices.clear();
-  
   // Default Vertices coordinates 
   Position   pos = get_position();
   Size       size(0,0);
@@ -110,7 +108,7 @@ void_t  Label::_updateVertices( WidgetTextAligment align ) noexcept(true)
   {
     case wtaAutoResize :
     {
-      size = m_pText->get_texture()->get_size();
+      size = m_pText->get_size();
       
       // Resize client area without notifications
       set_size( size.width, size.height, false );
@@ -122,7 +120,7 @@ void_t  Label::_updateVertices( WidgetTextAligment align ) noexcept(true)
     case wtaCentered:
     {
       Size cSize = get_size();
-      size = m_pText->get_texture()->get_size();
+      size = m_pText->get_size();
       
       float_t x = (float_t)pos.x + ((float_t)cSize.width  / (float_t)2) - ( (float_t)size.width  / (float_t)2);  
       float_t y = (float_t)pos.y + ((float_t)cSize.height / (float_t)2) - ( (float_t)size.height / (float_t)2);
@@ -132,11 +130,55 @@ void_t  Label::_updateVertices( WidgetTextAligment align ) noexcept(true)
     }; break; 
       
   }
+
+  if ( VertexSlab::is_valid() == false )
+    return;
+
+  const std::vector<Text::glyph_t>& glyphs = m_pText->get_glyphs();
+  const Size&                       tSize  = m_pText->get_size();
+
+  // Glyphs are stretched only when text fills client area, otherwise scale is 1.
+  glm::vec2  scale( 1.0f, 1.0f );
+  if ( ( tSize.width > 0 ) && ( tSize.height > 0 ) )
+    scale = glm::vec2( (float_t)size.width / (float_t)tSize.width, (float_t)size.height / (float_t)tSize.height );
+
+  const glm::vec2  origin( pos.x, pos.y );
+  
+  _releaseQuads( glyphs.size() );
   
-  m_vVertices.push_back( glm::vec2( pos.x             , pos.y               ) );
-  m_vVertices.push_back( glm::vec2( pos.x + size.width, pos.y               ) );
-  m_vVertices.push_back( glm::vec2( pos.x             , pos.y + size.height ) );
-  m_vVertices.push_back( glm::vec2( pos.x + size.width, pos.y + size.height ) );
+  std::vector<glm::vec2>    vertices(4);
+  std::vector<glm::vec2>    texCoord(4);
+  
+  for ( std::size_t i = 0; i < glyphs.size(); ++i )
+  {
+    const Text::glyph_t& g = glyphs[i];
+
+    if ( i == m_vQuads.size() )
+      m_vQuads.push_back( VertexSlab::get_instance()->allocate() );
+
+    const glm::vec2  p0 = origin + g.min * scale;
+    const glm::vec2  p1 = origin + g.max * scale;
+
+    vertices[0] = glm::vec2( p0.x, p0.y );  texCoord[0] = glm::vec2( g.uv_min.x, g.uv_min.y );
+    vertices[1] = glm::vec2( p1.x, p0.y );  texCoord[1] = glm::vec2( g.uv_max.x, g.uv_min.y );
+    vertices[2] = glm::vec2( p0.x, p1.y );  texCoord[2] = glm::vec2( g.uv_min.x, g.uv_max.y );
+    vertices[3] = glm::vec2( p1.x, p1.y );  texCoord[3] = glm::vec2( g.uv_max.x, g.uv_max.y );
+
+    VertexSlab::get_instance()->update( m_vQuads[i], vertices, &texCoord, m_pText->get_color() );
+  }
+}
+
+void_t  Label::_releaseQuads( std::size_t count ) noexcept(true)
+{
+  if ( VertexSlab::is_valid() == false )
+    return;
+
+  while ( m_vQuads.size() > count )
+  {
+    if ( m_vQuads.back() != VertexSlab::k_invalid_quad )
+      VertexSlab::get_instance()->release( m_vQuads.back() );
+    m_vQuads.pop_back();
+  }
 }
 
 }
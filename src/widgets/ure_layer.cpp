@@ -30,7 +30,7 @@ namespace widgets {
 
 
 Layer::Layer( ViewPort& rViewPort ) noexcept(true)
- : Widget(nullptr)
+ : Widget(nullptr), m_cull_stats{}
 {
   int_t    x,y = 0;
   sizei_t  w,h = 0;
@@ -39,6 +39,9 @@ Layer::Layer( ViewPort& rViewPort ) noexcept(true)
   
   set_position( x, y, false );
   set_size( w, h, false );
+
+  // Widgets are drawn only inside the layer.
+  set_clipping( true );
 }
 
 Layer::~Layer() noexcept(true)
@@ -51,10 +54,43 @@ bool_t  Layer::render( const glm::mat4& mvp ) noexcept(true)
   if ( is_visible() == false )
     return false;
   
-  // @todo
-  Recti cliRect( get_position().x, get_position().y, get_size().width, get_size().height );
+  // Children are clipped to this area, see set_clipping().
+  Recti cliRect;
+  get_client_area( cliRect );
+
+  m_cull_stats = {};
+  cull_stats_t* pPrevStats = Widget::set_cull_counters( &m_cull_stats );
+  
+  if ( m_draw_list == nullptr )
+  {
+    bool_t bRetVal = draw( mvp, cliRect );
+    Widget::set_cull_counters( pPrevStats );
+    return bRetVal;
+  }
+
+  m_draw_list->reset_stats();
+
+  DrawList* pPrevious = Canvas::set_draw_list( m_draw_list.get() );
+  
+  bool_t bRetVal = draw( mvp, cliRect );
   
-  return draw( mvp, cliRect );
+  Canvas::set_draw_list( pPrevious );
+  Widget::set_cull_counters( pPrevStats );
+  
+  m_draw_list->flush();
+
+  return bRetVal;
+}
+
+void_t  Layer::set_batching( bool_t bEnable ) noexcept(true)
+{
+  if ( bEnable == is_batching() )
+    return;
+
+  if ( bEnable )
+    m_draw_list.reset( new(std::nothrow) DrawList() );
+  else
+    m_draw_list.reset();
 }
 
 /// Implements GLWindowEvents
@@ -0,0 +1,418 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#include "widgets/ure_tile_map_layer.h"
+#include "ure_texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace ure {
+
+namespace widgets {
+
+TileMapLayer::TileMapLayer( ViewPort& rViewPort, const std::string& url ) noexcept(true)
+ : Layer( rViewPort ), m_url( url ), m_loader( nullptr ),
+   m_center_x( 0.5 ), m_center_y( 0.5 ), m_zoom( 2.0 ),
+   m_prefetch( 1 ), m_max_tiles( k_default_max_tiles ), m_view_changed( true ), m_frame( 0 ), m_next_retry( clock_t::time_point::max() ),
+   m_stats( {} ), m_dragging( false ), m_mouse_x( 0.0 ), m_mouse_y( 0.0 )
+{
+}
+
+TileMapLayer::~TileMapLayer() noexcept(true)
+{
+  _releaseQuads( 0 );
+}
+
+void_t  TileMapLayer::set_center( double_t lon, double_t lat ) noexcept(true)
+{
+  /* Web Mercator is not defined at poles */
+  lat = std::clamp( lat, -85.0511287798, 85.0511287798 ) * std::numbers::pi / 180.0;
+
+  m_center_x = ( lon + 180.0 ) / 360.0;
+  m_center_x = m_center_x - std::floor( m_center_x );
+  m_center_y = ( 1.0 - std::log( std::tan( lat ) + 1.0 / std::cos( lat ) ) / std::numbers::pi ) / 2.0;
+
+  m_view_changed = true;
+  invalidate();
+}
+
+void_t  TileMapLayer::get_center( double_t& lon, double_t& lat ) const noexcept(true)
+{
+  lon = m_center_x * 360.0 - 180.0;
+  lat = std::atan( std::sinh( std::numbers::pi * ( 1.0 - 2.0 * m_center_y ) ) ) * 180.0 / std::numbers::pi;
+}
+
+void_t  TileMapLayer::set_zoom( double_t zoom ) noexcept(true)
+{
+  zoom = std::clamp( zoom, 0.0, double_t(k_max_zoom) );
+  if ( zoom == m_zoom )
+    return;
+
+  m_zoom         = zoom;
+  m_view_changed = true;
+  invalidate();
+}
+
+void_t  TileMapLayer::pan( double_t dx, double_t dy ) noexcept(true)
+{
+  /* Map size in pixels at current zoom */
+  const double_t world = k_tile_size * std::exp2( m_zoom );
+
+  m_center_x += dx / world;
+  m_center_x  = m_center_x - std::floor( m_center_x );
+  m_center_y  = std::clamp( m_center_y + dy / world, 0.0, 1.0 );
+
+  m_view_changed = true;
+  invalidate();
+}
+
+void_t  TileMapLayer::set_max_tiles( uint32_t tiles ) noexcept(true)
+{
+  m_max_tiles    = std::max( tiles, 1u );
+  m_view_changed = true;
+  invalidate();
+}
+
+void_t  TileMapLayer::on_widget_begin_drawing( [[maybe_unused]] const Recti& rect ) noexcept(true)
+{
+  const uint32_t _failed = m_loader.get_stats().failed;
+
+  if ( m_loader.update( k_upload_time_us ) > 0 )
+    m_view_changed = true;
+
+  /* New failures must be scheduled for a retry, due ones loaded again */
+  if ( ( m_loader.get_stats().failed != _failed ) || is_retry_due() )
+    m_view_changed = true;
+
+  if ( m_view_changed )
+    update_view();
+
+  // Loader is driven by drawing, so frames are required until all tiles are resident.
+  if ( m_loader.is_idle() == false )
+    invalidate();
+}
+
+bool_t  TileMapLayer::on_widget_draw( [[maybe_unused]] const Recti& rect ) noexcept(true)
+{
+  for ( const draw_t& _draw : m_vDraws )
+  {
+    draw_rect( _draw.quad, *_draw.texture, URE_CLAMP_TO_EDGE, URE_CLAMP_TO_EDGE );
+  }
+
+  return true;
+}
+
+void_t  TileMapLayer::on_widget_size_changed( [[maybe_unused]] const Size& size ) noexcept(true)
+{
+  m_view_changed = true;
+}
+
+void_t  TileMapLayer::on_mouse_button_pressed( [[maybe_unused]] Window* pWindow, mouse_button_t button, [[maybe_unused]] int_t mods ) noexcept(true)
+{
+  if ( ( is_enabled() == false ) || ( button != mouse_button_t::BUTTON_LEFT ) )
+    return;
+
+  m_dragging = true;
+}
+
+void_t  TileMapLayer::on_mouse_button_released( [[maybe_unused]] Window* pWindow, mouse_button_t button, [[maybe_unused]] int_t mods ) noexcept(true)
+{
+  if ( button == mouse_button_t::BUTTON_LEFT )
+    m_dragging = false;
+}
+
+void_t  TileMapLayer::on_mouse_move( [[maybe_unused]] Window* pWindow, double_t dPosX, double_t dPosY ) noexcept(true)
+{
+  /* Map follows the pointer */
+  if ( m_dragging && is_enabled() )
+    pan( m_mouse_x - dPosX, m_mouse_y - dPosY );
+
+  m_mouse_x = dPosX;
+  m_mouse_y = dPosY;
+}
+
+void_t  TileMapLayer::on_mouse_scroll( [[maybe_unused]] Window* pWindow, [[maybe_unused]] double_t dOffsetX, double_t dOffsetY ) noexcept(true)
+{
+  if ( is_enabled() == false )
+    return;
+
+  set_zoom( m_zoom + dOffsetY * 0.5 );
+}
+
+void_t  TileMapLayer::update_view() noexcept(true)
+{
+  m_view_changed = false;
+  m_frame++;
+  m_next_retry   = clock_t::time_point::max();
+
+  const double_t  width    = get_size().width;
+  const double_t  height   = get_size().height;
+
+  /* Tiles from integer level are scaled up to fractional zoom */
+  const uint32_t  zoom     = static_cast<uint32_t>( std::floor( m_zoom ) );
+  const int64_t   tiles    = int64_t(1) << zoom;
+  const double_t  tile_px  = k_tile_size * std::exp2( m_zoom - zoom );
+  const double_t  cx       = m_center_x * tiles;
+  const double_t  cy       = m_center_y * tiles;
+
+  const int64_t   x0       = static_cast<int64_t>( std::floor( cx - width  / 2.0 / tile_px ) );
+  const int64_t   x1       = static_cast<int64_t>( std::floor( cx + width  / 2.0 / tile_px ) );
+  const int64_t   y0       = std::max<int64_t>( static_cast<int64_t>( std::floor( cy - height / 2.0 / tile_px ) ), 0 );
+  const int64_t   y1       = std::min<int64_t>( static_cast<int64_t>( std::floor( cy + height / 2.0 / tile_px ) ), tiles - 1 );
+  const int64_t   ring     = m_prefetch;
+
+  /* Layer center in layer coordinates */
+  const double_t  left     = get_position().x + width  / 2.0;
+  const double_t  top      = get_position().y + height / 2.0;
+
+  std::size_t     _draws   = 0;
+
+  m_stats.visible  = 0;
+  m_stats.resident = 0;
+  m_stats.fallback = 0;
+
+  for ( int64_t y = std::max<int64_t>( y0 - ring, 0 ); y <= std::min<int64_t>( y1 + ring, tiles - 1 ); ++y )
+  {
+    for ( int64_t x = x0 - ring; x <= x1 + ring; ++x )
+    {
+      const bool_t    _visible  = ( x >= x0 ) && ( x <= x1 ) && ( y >= y0 ) && ( y <= y1 );
+      const tile_id_t _id       = { zoom, static_cast<uint32_t>( ( ( x % tiles ) + tiles ) % tiles ), static_cast<uint32_t>( y ) };
+
+      /* Nearest tiles first, prefetched ring after all visible tiles */
+      const double_t  _distance = std::hypot( x + 0.5 - cx, y + 0.5 - cy );
+      const int32_t   _priority = ( _visible ? 0 : -65536 ) - static_cast<int32_t>( _distance * 16.0 );
+
+      tile_t* _tile = request( _id, _priority );
+      if ( _visible == false )
+        continue;
+
+      m_stats.visible++;
+
+      /* Own image if available, otherwise an ancestor scaled up */
+      std::shared_ptr<Texture> _texture;
+      double_t                 u0 = 0.0, v0 = 0.0, uv = 1.0;
+
+      if ( ( _tile != nullptr ) && _tile->handle->is_resident() )
+      {
+        _texture = _tile->handle->get_texture();
+        m_stats.resident++;
+      }
+      else
+      {
+        uint32_t _levels   = 0;
+        tile_t*  _ancestor = find_ancestor( _id, _levels );
+        if ( _ancestor == nullptr )
+          continue;
+
+        const uint32_t _span = 1u << _levels;
+
+        _texture = _ancestor->handle->get_texture();
+        uv       = 1.0 / _span;
+        u0       = ( _id.x % _span ) * uv;
+        v0       = ( _id.y % _span ) * uv;
+        m_stats.fallback++;
+      }
+
+      if ( _draws == m_vDraws.size() )
+      {
+        VertexSlab::quad_t _quad = VertexSlab::get_instance()->allocate();
+        if ( _quad == VertexSlab::k_invalid_quad )
+          continue;
+
+        m_vDraws.push_back( draw_t{ _quad, nullptr } );
+      }
+
+      const float_t _left   = static_cast<float_t>( left + ( x - cx ) * tile_px );
+      const float_t _top    = static_cast<float_t>( top  + ( y - cy ) * tile_px );
+      const float_t _right  = static_cast<float_t>( left + ( x + 1 - cx ) * tile_px );
+      const float_t _bottom = static_cast<float_t>( top  + ( y + 1 - cy ) * tile_px );
+
+      std::vector<glm::vec2> vertices = { 
+                                          glm::vec2( _left , _bottom ), glm::vec2( _right, _bottom ),
+                                          glm::vec2( _left , _top    ), glm::vec2( _right, _top    )
+                                        };
+      std::vector<glm::vec2> texCoord = { 
+                                          glm::vec2( u0     , v0 + uv ), glm::vec2( u0 + uv, v0 + uv ),
+                                          glm::vec2( u0     , v0      ), glm::vec2( u0 + uv, v0      )
+                                        };
+
+      VertexSlab::get_instance()->update( m_vDraws[_draws].quad, vertices, &texCoord, glm::vec4( 1.0f ) );
+      m_vDraws[_draws].texture = std::move(_texture);
+      ++_draws;
+    }
+  }
+
+  _releaseQuads( _draws );
+
+  evict();
+
+  m_stats.cached = static_cast<uint32_t>( m_tiles.size() );
+}
+
+TileMapLayer::tile_t*  TileMapLayer::request( const tile_id_t& id, int32_t priority ) noexcept(true)
+{
+  auto iter = m_tiles.find( id.key() );
+  if ( iter != m_tiles.end() )
+  {
+    tile_t& _tile = iter->second;
+
+    m_lru.splice( m_lru.begin(), m_lru, _tile.lru );
+    _tile.frame = m_frame;
+
+    /* Failed tiles are loaded again after a delay, that doubles with each failure */
+    if ( _tile.handle->get_status() == TextureLoader::status_t::eFailed )
+    {
+      const clock_t::time_point _now = clock_t::now();
+
+      if ( _tile.retry_at == clock_t::time_point() )
+      {
+        const uint32_t _delay = static_cast<uint32_t>( std::min<uint64_t>( uint64_t(k_retry_min_ms) << std::min( _tile.failures, 16u ), k_retry_max_ms ) );
+
+        _tile.retry_at = _now + std::chrono::milliseconds( _delay );
+        _tile.failures++;
+      }
+      else if ( _tile.retry_at <= _now )
+      {
+        TextureLoader::handle_t _handle = m_loader.load( get_name( id ), get_url( id ), priority );
+        if ( _handle != nullptr )
+        {
+          _tile.handle   = std::move(_handle);
+          _tile.priority = priority;
+          _tile.retry_at = clock_t::time_point();
+        }
+      }
+
+      if ( _tile.retry_at != clock_t::time_point() )
+        m_next_retry = std::min( m_next_retry, _tile.retry_at );
+    }
+
+    /* Distance from center changes while panning */
+    if ( ( _tile.priority != priority ) && ( _tile.handle->is_resident() == false ) )
+    {
+      m_loader.set_priority( _tile.handle, priority );
+      _tile.priority = priority;
+    }
+
+    return &_tile;
+  }
+
+  TextureLoader::handle_t _handle = m_loader.load( get_name( id ), get_url( id ), priority );
+  if ( _handle == nullptr )
+    return nullptr;
+
+  m_lru.push_front( id.key() );
+
+  auto [inserted, _] = m_tiles.emplace( id.key(), tile_t{ std::move(_handle), priority, m_lru.begin(), m_frame, clock_t::time_point(), 0 } );
+  return &inserted->second;
+}
+
+TileMapLayer::tile_t*  TileMapLayer::find_ancestor( const tile_id_t& id, uint32_t& levels ) noexcept(true)
+{
+  tile_id_t _id = id;
+
+  for ( levels = 1; ( levels <= k_max_ancestors ) && ( _id.z > 0 ); ++levels )
+  {
+    _id = _id.parent();
+
+    auto iter = m_tiles.find( _id.key() );
+    if ( ( iter == m_tiles.end() ) || ( iter->second.handle->is_resident() == false ) )
+      continue;
+
+    /* Ancestor is in use, so it must not be evicted */
+    m_lru.splice( m_lru.begin(), m_lru, iter->second.lru );
+    iter->second.frame = m_frame;
+
+    return &iter->second;
+  }
+
+  return nullptr;
+}
+
+void_t  TileMapLayer::evict() noexcept(true)
+{
+  /* Tiles still loading that left the view are cancelled, so that downloads follow the view */
+  for ( auto iter = m_tiles.begin(); iter != m_tiles.end(); )
+  {
+    tile_t& _tile = iter->second;
+
+    if ( ( _tile.frame != m_frame ) && 
+         ( _tile.handle->is_resident() == false ) && ( _tile.handle->get_status() != TextureLoader::status_t::eFailed ) )
+    {
+      m_loader.cancel( _tile.handle );
+      m_lru.erase( _tile.lru );
+      iter = m_tiles.erase( iter );
+      continue;
+    }
+    ++iter;
+  }
+
+  /* Least recently used first, tiles needed by current frame are never released */
+  while ( ( m_tiles.size() > m_max_tiles ) && ( m_lru.empty() == false ) )
+  {
+    auto iter = m_tiles.find( m_lru.back() );
+    if ( iter->second.frame == m_frame )
+      break;
+
+    m_lru.pop_back();
+    m_tiles.erase( iter );
+    m_stats.evicted++;
+  }
+}
+
+std::string  TileMapLayer::get_name( const tile_id_t& id ) const noexcept(true)
+{
+  return core::utils::format( "tile-%u-%u-%u", id.z, id.x, id.y );
+}
+
+std::string  TileMapLayer::get_url( const tile_id_t& id ) const noexcept(true)
+{
+  std::string _url = m_url;
+
+  const std::pair<const char*, uint32_t> _fields[] = { { "{z}", id.z }, { "{x}", id.x }, { "{y}", id.y } };
+  for ( const auto& [field, value] : _fields )
+  {
+    std::size_t _pos = _url.find( field );
+    if ( _pos != std::string::npos )
+      _url.replace( _pos, 3, std::to_string( value ) );
+  }
+
+  return _url;
+}
+
+void_t  TileMapLayer::_releaseQuads( std::size_t count ) noexcept(true)
+{
+  if ( VertexSlab::is_valid() == false )
+    return;
+
+  while ( m_vDraws.size() > count )
+  {
+    VertexSlab::get_instance()->release( m_vDraws.back().quad );
+    m_vDraws.pop_back();
+  }
+}
+
+}
+
+}
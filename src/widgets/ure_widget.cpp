@@ -24,16 +24,25 @@
 #include "widgets/ure_widget.h"
 #include "ure_view_port.h"
 
+#include <glm/gtc/matrix_transform.hpp>  // glm::ortho
+
+#include <algorithm>
+
 
 namespace ure {
 
 namespace widgets {
 
 
+cull_stats_t* Widget::s_pCullStats = nullptr;
+uint32_t      Widget::s_changes    = 0;
+
 Widget::Widget( Widget* pParent ) noexcept(true)
  : m_ebo( eboUndefined ), m_pos( 0, 0 ),
    m_size( 0, 0 ), m_visible( true ), m_enabled( true ),
-   m_pParent( nullptr ), m_eBackground( NoBackground ), m_bkg_texture( nullptr )
+   m_pParent( nullptr ), m_eBackground( NoBackground ), m_bkg_texture( nullptr ),
+   m_bkQuad( VertexSlab::k_invalid_quad ),
+   m_clipping( false ), m_cached( false ), m_cache_valid( false ), m_cacheQuad( VertexSlab::k_invalid_quad )
 {
   m_Focus = m_vChildren.end();
   
@@ -44,19 +53,29 @@ Widget::~Widget() noexcept(true)
 {
   // Release signals slot on parent.
   set_parent( nullptr );
+
+  if ( ( m_bkQuad != VertexSlab::k_invalid_quad ) && VertexSlab::is_valid() )
+    VertexSlab::get_instance()->release( m_bkQuad );
+
+  _releaseCache();
 }
 
 bool  Widget::add_child( std::unique_ptr<Widget> widget ) noexcept(true)
 {
+  if ( widget == nullptr )
+    return false;
+
   m_vChildren.push_back( std::move(widget) );
   m_vChildren.shrink_to_fit();
 
   // Update parent 
-  widget->set_parent(this);
+  m_vChildren.back()->set_parent(this);
   
   // Iterator must be updated each time 
   // m_vChildren become changed
   m_Focus = m_vChildren.end();
+
+  invalidate();
   
   return true;
 }
@@ -79,10 +98,14 @@ void_t  Widget::set_position( int_t x, int_t y, bool notify ) noexcept(true)
 { 
   if ( (m_pos.x != x) || (m_pos.y != y) )
   {
+    // Both previous and new area are damaged.
+    invalidate();
+
     m_pos.x = x; 
     m_pos.y = y; 
   
     _updateBkVertices();
+    invalidate();
   }
   
   if ( notify == true )
@@ -95,10 +118,14 @@ void_t  Widget::set_size( sizei_t width, sizei_t height, bool notify ) noexcept(
 { 
   if (( m_size.width != width ) || (m_size.height != height))
   {
+    // Both previous and new area are damaged.
+    invalidate();
+
     m_size.width  = width; 
     m_size.height = height; 
 
     _updateBkVertices();
+    invalidate();
   }
   
   if ( notify == true )
@@ -106,7 +133,25 @@ void_t  Widget::set_size( sizei_t width, sizei_t height, bool notify ) noexcept(
     on_widget_size_changed( m_size );
   }
 }  
+
+void_t  Widget::set_visible( bool_t visible ) noexcept(true)
+{
+  if ( m_visible == visible )
+    return;
+
+  m_visible = visible;
+  invalidate();
+}
   
+void_t  Widget::set_background( const glm::vec4& cr ) noexcept(true)
+{  
+  m_crBackground = cr;     
+  m_eBackground  = SolidColor;
+
+  _updateBkQuad();
+  invalidate();
+}
+
 void_t  Widget::set_background( std::shared_ptr<ure::Texture> texture, BackgroundOptions bo ) noexcept(true)
 { 
   m_bkg_texture = texture;     
@@ -150,14 +195,95 @@ void_t  Widget::set_background( std::shared_ptr<ure::Texture> texture, Backgroun
     
     m_ebo = bo;
   }
+
+  _updateBkQuad();
+  invalidate();
+}
+
+void_t  Widget::set_cached( bool_t bEnable ) noexcept(true)
+{
+  if ( m_cached == bEnable )
+    return;
+
+  m_cached      = bEnable;
+  m_cache_valid = false;
+  m_damage      = Recti();
+
+  if ( m_cached == false )
+    _releaseCache();
+}
+
+void_t  Widget::invalidate() noexcept(true)
+{
+  const Position origin = _get_origin();
+  const Recti    area( origin.x, origin.y, m_size.width, m_size.height );
+
+  s_changes++;
+
+  for ( Widget* pWidget = this; pWidget != nullptr; pWidget = pWidget->m_pParent )
+  {
+    pWidget->m_cache_valid = false;
+
+    if ( pWidget->m_cached )
+      pWidget->_damage( area );
+  }
 }
 
 bool_t  Widget::draw( const glm::mat4& mvp, const Recti& rect ) noexcept(true)
 {
   if ( is_visible() == false )
     return false;
-    
+
+  if ( m_cached == false )
+    return _draw( mvp, rect );
+
+  // Fallback to direct drawing when the cache cannot be used.
+  if ( ( m_cache_valid == false ) && ( _updateCache() == false ) )
+    return _draw( mvp, rect );
+
+  if ( s_pCullStats != nullptr )
+    s_pCullStats->visible++;
+
+  Canvas::set_mvp( mvp );
+
+  draw_rect( m_cacheQuad, m_cache->get_texture(), URE_CLAMP_TO_EDGE, URE_CLAMP_TO_EDGE );
+
+  return true;
+}
+
+bool_t  Widget::_draw( const glm::mat4& mvp, const Recti& rect ) noexcept(true)
+{
   Canvas::set_mvp( mvp );
+
+  // Children are rejected against the intersection of \param rect with widget area.
+  Recti   clip  = rect;
+  bool_t  bClip = false;
+  if ( m_clipping && ( m_size.width > 0 ) && ( m_size.height > 0 ) )
+  {
+    const Position origin = _get_origin();
+
+    const int_t left   = std::max( rect.left              , origin.x                 );
+    const int_t top    = std::max( rect.top               , origin.y                 );
+    const int_t right  = std::min( rect.left + rect.right , origin.x + m_size.width  );
+    const int_t bottom = std::min( rect.top  + rect.bottom, origin.y + m_size.height );
+
+    if ( ( right > left ) && ( bottom > top ) )
+    {
+      clip  = Recti( left, top, right - left, bottom - top );
+      bClip = push_clip( Recti( origin.x, origin.y, m_size.width, m_size.height ) );
+    }
+
+    // Nothing visible on screen.
+    if ( bClip == false )
+    {
+      if ( s_pCullStats != nullptr )
+        s_pCullStats->culled++;
+      return false;
+    }
+  }
+
+  if ( s_pCullStats != nullptr )
+    s_pCullStats->visible++;
   
   on_widget_begin_drawing( rect );
   
@@ -167,28 +293,45 @@ bool_t  Widget::draw( const glm::mat4& mvp, const Recti& rect ) noexcept(true)
     {
       if ( m_eBackground == SolidColor )
       {
-        draw_rect( m_bkVertices, get_bk_color() );
+        draw_rect( m_bkQuad );
       }
   
       if ( ( m_eBackground == ImageBrush ) && (m_bkg_texture.get() != nullptr) )
       {
-        draw_rect( m_bkVertices, m_bkTexCoord, *m_bkg_texture.get(), GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE );
+        draw_rect( m_bkQuad, *m_bkg_texture.get(), GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE );
       }
     }
   }
   
   for( auto& w : m_vChildren )
   {
-    w->draw( mvp, rect );
+    if ( w->is_outside( clip ) )
+    {
+      if ( s_pCullStats != nullptr )
+        s_pCullStats->culled++;
+      continue;
+    }
+
+    w->draw( mvp, clip );
   }
   
   bool bRetVal = on_widget_draw( rect );
   
   on_widget_end_drawing( rect );
+
+  if ( bClip )
+    pop_clip();
   
   return bRetVal;
 }
 
+cull_stats_t* Widget::set_cull_counters( cull_stats_t* pStats ) noexcept(true)
+{
+  cull_stats_t* pPrevious = s_pCullStats;
+  s_pCullStats = pStats;
+  return pPrevious;
+}
+
 void_t  Widget::on_widget_key_released( Window* pWindow, Layer* pLayer, key_t key, int_t iScanCode, word_t wMods ) noexcept(true)
 { 
   if (( has_focus() == false ) || ( is_enabled() == false ))
@@ -221,6 +364,9 @@ bool  Widget::step_focus() noexcept(true)
 {
   if ( has_focusable() == false )
     return true;
+
+  // Focused widgets can be drawn in a different way.
+  invalidate();
   
   // Will restart from first widget
   if ( m_Focus == m_vChildren.end() )
@@ -298,8 +444,174 @@ void_t  Widget::_updateBkVertices( ) noexcept(true)
   m_bkVertices.push_back( glm::vec2( pos.x + size.width, pos.y + size.height ) );
   m_bkVertices.push_back( glm::vec2( pos.x             , pos.y               ) );
   m_bkVertices.push_back( glm::vec2( pos.x + size.width, pos.y               ) );
+
+  _updateBkQuad();
 }
 
+void_t  Widget::_updateBkQuad( ) noexcept(true)
+{
+  // Vertices are not available when specialized class handle them.
+  if ( ( m_bkVertices.size() != 4 ) || ( VertexSlab::is_valid() == false ) )
+    return;
+
+  VertexSlab* pSlab = VertexSlab::get_instance();
+
+  if ( m_bkQuad == VertexSlab::k_invalid_quad )
+  {
+    m_bkQuad = pSlab->allocate();
+    if ( m_bkQuad == VertexSlab::k_invalid_quad )
+      return;
+  }
+
+  // Images are modulated by quad color, so it must be white for them.
+  const glm::vec4 color = (m_eBackground == SolidColor)?m_crBackground:glm::vec4( 1.0f );
+
+  pSlab->update( m_bkQuad, m_bkVertices, (m_bkTexCoord.size() == 4)?&m_bkTexCoord:nullptr, color );
+}
+
+
+bool_t  Widget::_updateCache( ) noexcept(true)
+{
+  if ( ( m_size.width <= 0 ) || ( m_size.height <= 0 ) || ( VertexSlab::is_valid() == false ) )
+    return false;
+
+  // Only damaged area is rendered again, as long as the texture keeps previous content.
+  bool_t bPartial = ( m_damage.right > 0 ) && ( m_damage.bottom > 0 );
+
+  if ( ( m_cache == nullptr ) || ( m_cache->get_size().width  != m_size.width  ) || 
+                                 ( m_cache->get_size().height != m_size.height ) )
+  {
+    m_cache.reset( new(std::nothrow) RenderTarget( m_size.width, m_size.height ) );
+    if ( m_cache == nullptr )
+      return false;
+
+    bPartial = false;
+  }
+
+  if ( m_cacheQuad == VertexSlab::k_invalid_quad )
+  {
+    m_cacheQuad = VertexSlab::get_instance()->allocate();
+    if ( m_cacheQuad == VertexSlab::k_invalid_quad )
+      return false;
+  }
+
+  const Position pos = _get_origin();
+
+  const float_t x0 = (float_t)pos.x;
+  const float_t y0 = (float_t)pos.y;
+  const float_t x1 = (float_t)(pos.x + m_size.width);
+  const float_t y1 = (float_t)(pos.y + m_size.height);
+
+  // Damaged area in texture pixels, first row in the texture is at y0.
+  Recti  dirty;
+  if ( bPartial )
+  {
+    const int_t left   = std::max( m_damage.left                  , pos.x                 );
+    const int_t top    = std::max( m_damage.top                   , pos.y                 );
+    const int_t right  = std::min( m_damage.left + m_damage.right , pos.x + m_size.width  );
+    const int_t bottom = std::min( m_damage.top  + m_damage.bottom, pos.y + m_size.height );
+
+    dirty = Recti( left - pos.x, top - pos.y, right - left, bottom - top );
+  }
+
+  m_damage = Recti();
+
+  if ( bPartial && ( ( dirty.right <= 0 ) || ( dirty.bottom <= 0 ) ) )
+  {
+    // Nothing changed inside the widget area.
+    m_cache_valid = true;
+    return true;
+  }
+
+  // Clip areas in use are related to a different target.
+  Canvas::clips_t clips = Canvas::suspend_clips();
+
+  if ( m_cache->begin( bPartial?&dirty:nullptr ) == false )
+  {
+    Canvas::resume_clips( std::move(clips) );
+    return false;
+  }
+
+  // Subtree is drawn immediately into the target, without counting it as visible.
+  DrawList*     pPrevList  = Canvas::set_draw_list( nullptr );
+  cull_stats_t* pPrevStats = Widget::set_cull_counters( nullptr );
+
+  // Only damaged area is drawn, children outside are skipped.
+  Recti area( pos.x, pos.y, m_size.width, m_size.height );
+  if ( bPartial )
+  {
+    area = Recti( pos.x + dirty.left, pos.y + dirty.top, dirty.right, dirty.bottom );
+    push_scissor( dirty.left, dirty.top, dirty.right, dirty.bottom );
+  }
+
+  // First row in the texture is at y0, so texture coordinates follow vertices.
+  _draw( glm::ortho( x0, x1, y0, y1, -1.0f, 1.0f ), area );
+
+  if ( bPartial )
+    pop_clip();
+
+  Widget::set_cull_counters( pPrevStats );
+  Canvas::set_draw_list( pPrevList );
+
+  m_cache->end();
+
+  Canvas::resume_clips( std::move(clips) );
+
+  const std::vector<glm::vec2>  vertices = { glm::vec2( x0, y1 ), glm::vec2( x1, y1 ), glm::vec2( x0, y0 ), glm::vec2( x1, y0 ) };
+  const std::vector<glm::vec2>  texCoord = { glm::vec2( 0.0f, 1.0f ), glm::vec2( 1.0f, 1.0f ), glm::vec2( 0.0f, 0.0f ), glm::vec2( 1.0f, 0.0f ) };
+
+  VertexSlab::get_instance()->update( m_cacheQuad, vertices, &texCoord, glm::vec4( 1.0f ) );
+
+  m_cache_valid = true;
+
+  return true;
+}
+
+void_t  Widget::_damage( const Recti& area ) noexcept(true)
+{
+  // Empty area means that changes are not bound to the widget area.
+  if ( ( area.right <= 0 ) || ( area.bottom <= 0 ) )
+  {
+    const Position origin = _get_origin();
+    m_damage = Recti( origin.x, origin.y, m_size.width, m_size.height );
+    return;
+  }
+
+  if ( ( m_damage.right <= 0 ) || ( m_damage.bottom <= 0 ) )
+  {
+    m_damage = area;
+    return;
+  }
+
+  const int_t left   = std::min( m_damage.left                  , area.left               );
+  const int_t top    = std::min( m_damage.top                   , area.top                );
+  const int_t right  = std::max( m_damage.left + m_damage.right , area.left + area.right  );
+  const int_t bottom = std::max( m_damage.top  + m_damage.bottom, area.top  + area.bottom );
+
+  m_damage = Recti( left, top, right - left, bottom - top );
+}
+
+Position  Widget::_get_origin( ) const noexcept(true)
+{
+  // Same origin used for background vertices.
+  Position   pos = m_pos;
+  if ( m_pParent != nullptr )
+  {
+    pos += m_pParent->get_position();
+  }
+  return pos;
+}
+
+void_t  Widget::_releaseCache( ) noexcept(true)
+{
+  if ( ( m_cacheQuad != VertexSlab::k_invalid_quad ) && VertexSlab::is_valid() )
+    VertexSlab::get_instance()->release( m_cacheQuad );
+
+  m_cacheQuad   = VertexSlab::k_invalid_quad;
+  m_cache_valid = false;
+  m_damage      = Recti();
+  m_cache.reset();
+}
 
 void_t  Widget::set_parent( Widget* pParent ) noexcept(true)
 {
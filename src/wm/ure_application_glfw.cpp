@@ -24,12 +24,22 @@
 #include "ure_application.h"
 #include "ure_programs_collector.h"
 #include "ure_resources_collector.h"
+#include "ure_texture_residency.h"
+#include "ure_transform_system.h"
+#include "ure_vertex_slab.h"
 
 #include "core/utils.h"
 #include "images/images.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace ure {
 
+/* Cleared before workers are joined, so that late wake ups never reach a terminated GLFW */
+static std::atomic<bool_t>  s_wake_up = false;
+static std::mutex           s_mtx_wake_up;
+
 static void error_callback(int32_t error, const char* description)
 {
   if ( Application::is_valid() )
@@ -47,12 +57,16 @@ Application::Application(
                           core::unique_ptr<ApplicationEvents> events,
                           const std::string& sShadersPath 
                         ) noexcept(true)
-  : m_events( std::move(events) ), m_exit(false)
+  : m_events( std::move(events) ), m_exit(false), m_idle_timeout(0.5)
 {
   glfwSetErrorCallback(error_callback);  /* GLFW 3.3 */
 
   ProgramsCollector::initialize();
   ProgramsCollector::get_instance()->set_shaders_path( sShadersPath );
+
+  VertexSlab::initialize();
+  TextureResidency::initialize();
+  TransformSystem::initialize();
 }
 
 Application::~Application() noexcept(true)
@@ -70,6 +84,26 @@ void_t  Application::wait_events() noexcept(true)
   glfwWaitEvents();
 }
 
+void_t  Application::wait_events( double_t timeout ) noexcept(true)
+{
+  glfwWaitEventsTimeout( timeout );
+}
+
+void_t  Application::post_empty_event() noexcept(true)
+{
+  glfwPostEmptyEvent();
+}
+
+void_t  Application::wake_up() noexcept(true)
+{
+  if ( s_wake_up == false )
+    return;
+
+  std::lock_guard _mtx( s_mtx_wake_up );
+  if ( s_wake_up )
+    glfwPostEmptyEvent();
+}
+
 std::string  Application::get_version() const noexcept(true)
 {
   int major, minor, rev;
@@ -116,6 +150,11 @@ void_t  Application::on_initialize_wm() noexcept(true)
        m_events->on_initialize_error();
     }
   }
+  else
+  {
+    std::lock_guard _mtx( s_mtx_wake_up );
+    s_wake_up = true;
+  }
 
 #ifdef _USE_AVCPP
   if (!av_init())
@@ -148,6 +187,11 @@ void_t  Application::on_initialize_wm() noexcept(true)
 
 void_t  Application::on_finalize_wm() noexcept(true)
 {
+  {
+    std::lock_guard _mtx( s_mtx_wake_up );
+    s_wake_up = false;
+  }
+
   if ( m_events != nullptr )
   {
     m_events->on_finalize();
@@ -173,6 +217,9 @@ void_t  Application::on_finalize_wm() noexcept(true)
   }
 #endif  //_USE_DEVIL
 
+  TransformSystem::get_instance()->finalize();
+  TextureResidency::get_instance()->finalize();
+  VertexSlab::get_instance()->finalize();
   ProgramsCollector::get_instance()->finalize();
 
   glfwTerminate();
@@ -206,6 +206,11 @@ bool_t Window::create( std::unique_ptr<window_options> options, enum_t flags ) n
     return false;
   }
 
+  // Context is current, so from now on GL state goes through the cache.
+  m_ptrState = std::unique_ptr<StateCache>( new(std::nothrow) StateCache() );
+  if ( m_ptrState != nullptr )
+    m_ptrState->make_current();
+
   // Only in windowed mode it is necessary to move window
   // and to make it visible after move.
   if ( pFsMonitor == nullptr )
@@ -258,6 +263,9 @@ void_t Window::make_context_current() noexcept(true)
 {
   assert( m_hWindow != nullptr );
   glfwMakeContextCurrent( m_hWindow );
+  
+  if ( m_ptrState != nullptr )
+    m_ptrState->make_current();
 }
 
 bool_t Window::show( enum_t flags ) noexcept(true)
@@ -486,6 +494,8 @@ bool_t Window::destroy( uint32_t flags ) noexcept(true)
     ImGui::DestroyContext();
 #endif
 
+    m_ptrState = nullptr;
+
     glfwDestroyWindow(m_hWindow);
     m_hWindow = nullptr;
     
@@ -0,0 +1,121 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+/**
+ * RenderQueue benchmark: frames with 10k, 50k and 100k items are sorted with the radix 
+ * sort used by SceneGraph and with std::stable_sort for reference, checking that both
+ * give the same order, that is ascending keys with submission order kept for equal keys.
+ */
+
+#include "ure_render_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace ure;
+
+static constexpr uint32_t k_frames = 20;
+
+/**
+ * Keys similar to a scene: few render orders, programs and textures, 1 item in 4 translucent.
+ */
+static std::vector<uint64_t> make_keys( uint32_t count, std::mt19937& rng ) noexcept(true)
+{
+  std::uniform_int_distribution<uint32_t> _order( 0, 3 );
+  std::uniform_int_distribution<uint32_t> _program( 0, 15 );
+  std::uniform_int_distribution<uint32_t> _texture( 0, 255 );
+  std::uniform_int_distribution<uint32_t> _translucent( 0, 3 );
+  std::uniform_real_distribution<float_t> _depth( -1.0f, 1.0f );
+
+  std::vector<uint64_t> _keys( count );
+  for ( uint64_t& key : _keys )
+    key = RenderQueue::make_key( uint8_t(_order(rng)), _translucent(rng) == 0, _program(rng), _texture(rng), _depth(rng) );
+
+  return _keys;
+}
+
+/**
+ * @return false if \param items are not sorted by key or equal keys lost submission order.
+ */
+static bool_t is_sorted( const std::vector<RenderQueue::item_t>& items ) noexcept(true)
+{
+  for ( std::size_t i = 1; i < items.size(); ++i )
+  {
+    if ( ( items[i-1].key > items[i].key ) || 
+         ( ( items[i-1].key == items[i].key ) && ( items[i-1].matrix > items[i].matrix ) ) )
+      return false;
+  }
+  return true;
+}
+
+int main( [[maybe_unused]] int argc, [[maybe_unused]] char** argv )
+{
+  std::mt19937    _rng( 2022 );
+  const glm::mat4 _mvp( 1.0f );
+  bool_t          _passed = true;
+
+  for ( uint32_t count : { 10000u, 50000u, 100000u } )
+  {
+    RenderQueue _queue;
+    uint64_t    _radix_us  = 0;
+    uint64_t    _stable_us = 0;
+
+    for ( uint32_t frame = 0; frame < k_frames; ++frame )
+    {
+      const std::vector<uint64_t> _keys = make_keys( count, _rng );
+
+      _queue.clear();
+      for ( uint64_t key : _keys )
+        _queue.push( key, nullptr, _mvp );
+
+      /* Reference order, matrix index is the submission order */
+      std::vector<RenderQueue::item_t> _reference = _queue.get_items();
+
+      const auto _start = std::chrono::steady_clock::now();
+      std::stable_sort( _reference.begin(), _reference.end(), []( const RenderQueue::item_t& a, const RenderQueue::item_t& b ) { return a.key < b.key; } );
+      _stable_us += std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - _start ).count();
+
+      _queue.sort();
+      _radix_us += _queue.get_stats().sort_us;
+
+      const std::vector<RenderQueue::item_t>& _items = _queue.get_items();
+      if ( ( is_sorted( _items ) == false ) || 
+           ( std::equal( _items.begin(), _items.end(), _reference.begin(), _reference.end(), 
+                         []( const RenderQueue::item_t& a, const RenderQueue::item_t& b ) { return ( a.key == b.key ) && ( a.matrix == b.matrix ); } ) == false ) )
+      {
+        std::printf( "%6u items: wrong order in frame %u\n", count, frame );
+        _passed = false;
+        break;
+      }
+    }
+
+    std::printf( "%6u items: sort() %6.1f us/frame, std::stable_sort %6.1f us/frame, %u translucent, max %u us\n",
+                 count, double(_radix_us) / k_frames, double(_stable_us) / k_frames, 
+                 _queue.get_stats().translucent, _queue.get_stats().max_sort_us );
+  }
+
+  return _passed?EXIT_SUCCESS:EXIT_FAILURE;
+}
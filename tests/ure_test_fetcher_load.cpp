@@ -0,0 +1,178 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+/**
+ * Load test for ResourcesFetcher: the same batch of requests is fetched from a loopback
+ * server with added latency, first with a single transfer at a time and then with the
+ * default limits, checking that limits are respected and reporting throughput.
+ */
+
+#include "ure_resources_fetcher.h"
+#include "ure_test_http_server.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace ure;
+
+static constexpr uint32_t k_requests    = 64;
+static constexpr uint32_t k_body_size   = 16 * 1024;
+static constexpr uint32_t k_latency_ms  = 50;
+static constexpr uint32_t k_timeout_s   = 60;
+
+/**
+ * Count completions notified by the fetcher thread.
+ */
+class receiver_t : public ResourcesFetcherEvents
+{
+public:
+  /***/
+  virtual void_t  on_download_succeeded( [[maybe_unused]] const std::string_view app_id,
+                                         [[maybe_unused]] const std::string_view name,
+                                         [[maybe_unused]] customer_request_t cr,
+                                         [[maybe_unused]] const std::type_info& type,
+                                         [[maybe_unused]] const byte_t* data,
+                                         uint_t length
+                                       ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_succeeded += ( length == k_body_size )?1:0;
+    m_failed    += ( length == k_body_size )?0:1;
+    m_cv.notify_all();
+  }
+  /***/
+  virtual void_t  on_download_failed( [[maybe_unused]] const std::string_view app_id,
+                                      [[maybe_unused]] const std::string_view name,
+                                      [[maybe_unused]] customer_request_t cr
+                                    ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_failed++;
+    m_cv.notify_all();
+  }
+
+  /**
+   * @return false if \param count completions are not notified in time.
+   */
+  bool_t          wait( uint32_t count ) noexcept(true)
+  {
+    std::unique_lock _lock( m_mtx );
+    return m_cv.wait_for( _lock, std::chrono::seconds( k_timeout_s ), [&]() { return ( m_succeeded + m_failed ) >= count; } );
+  }
+
+  uint32_t                  m_succeeded = 0;
+  uint32_t                  m_failed    = 0;
+
+private:
+  std::mutex                m_mtx;
+  std::condition_variable   m_cv;
+};
+
+/**
+ * Fetch the batch with \param max_transfers, return elapsed milliseconds or 0 on failure.
+ */
+static uint64_t run( test::HttpTestServer& server, uint32_t max_transfers, uint32_t round ) noexcept(true)
+{
+  ResourcesFetcher* pFetcher = ResourcesFetcher::get_instance();
+  receiver_t        _receiver;
+
+  pFetcher->set_max_transfers( max_transfers, max_transfers );
+  pFetcher->reset_stats();
+  server.reset_counters();
+
+  const auto _start = std::chrono::steady_clock::now();
+
+  for ( uint32_t i = 0; i < k_requests; ++i )
+  {
+    ResourcesFetcher::request_t _request = pFetcher->fetch( _receiver, "load", core::utils::format( "%u-%u", round, i ), typeid(std::string),
+                                                            server.get_url( core::utils::format( "/item/%u/%u", round, i ) ),
+                                                            customer_request_t::Get, {}, {} );
+    if ( _request == ResourcesFetcher::k_invalid_request )
+    {
+      std::printf( "fetch() failed for request %u\n", i );
+      return 0;
+    }
+  }
+
+  if ( _receiver.wait( k_requests ) == false )
+  {
+    std::printf( "max_transfers %2u: timeout, %u completed\n", max_transfers, _receiver.m_succeeded + _receiver.m_failed );
+    return 0;
+  }
+
+  const uint64_t _elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - _start ).count();
+  const ResourcesFetcher::stats_t _stats = pFetcher->get_stats();
+
+  std::printf( "max_transfers %2u: %u requests in %5lu ms, %7.1f req/s, %u concurrent at most, %u new and %u reused connections\n",
+               max_transfers, k_requests, (unsigned long)_elapsed_ms, ( k_requests * 1000.0 ) / double( std::max<uint64_t>( _elapsed_ms, 1 ) ),
+               server.get_max_active(), _stats.new_connections, _stats.reused_connections );
+
+  if ( ( _receiver.m_succeeded != k_requests ) || ( server.get_requests() != k_requests ) )
+  {
+    std::printf( "max_transfers %2u: %u succeeded, %u failed, %u served\n", max_transfers, _receiver.m_succeeded, _receiver.m_failed, server.get_requests() );
+    return 0;
+  }
+
+  if ( server.get_max_active() > max_transfers )
+  {
+    std::printf( "max_transfers %2u: limit exceeded\n", max_transfers );
+    return 0;
+  }
+
+  return std::max<uint64_t>( _elapsed_ms, 1 );
+}
+
+int main( [[maybe_unused]] int argc, [[maybe_unused]] char** argv )
+{
+  const std::string _body( k_body_size, 'x' );
+
+  test::HttpTestServer _server( [&_body]( [[maybe_unused]] const std::string& path, [[maybe_unused]] const std::string& headers, 
+                                          test::HttpTestServer::response_t& response ) 
+                                {
+                                  response.body = _body;
+                                  return true;
+                                } );
+  if ( _server.start() == false )
+  {
+    std::printf( "unable to start loopback server\n" );
+    return EXIT_FAILURE;
+  }
+  _server.set_latency( k_latency_ms );
+
+  ResourcesFetcher::initialize();
+
+  const uint64_t _serial   = run( _server,  1, 0 );
+  const uint64_t _parallel = run( _server, ResourcesFetcher::k_default_max_transfers, 1 );
+
+  ResourcesFetcher::get_instance()->finalize();
+  _server.stop();
+
+  if ( ( _serial == 0 ) || ( _parallel == 0 ) )
+    return EXIT_FAILURE;
+
+  std::printf( "speedup %.1fx\n", double(_serial) / double(_parallel) );
+
+  /* Latency dominates, so concurrent transfers must be much faster than a single one */
+  return ( _serial >= 2 * _parallel )?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -0,0 +1,215 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+/**
+ * HttpCache test through ResourcesFetcher against a loopback server: fresh responses
+ * are served from disk without requests, stale ones are revalidated with ETag, entries
+ * are kept apart by credentials and by headers listed in Vary, and the index survives
+ * the cache being released and opened again.
+ */
+
+#include "ure_http_cache.h"
+#include "ure_resources_fetcher.h"
+#include "ure_test_http_server.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+
+using namespace ure;
+
+static constexpr uint32_t k_timeout_s = 30;
+
+/**
+ * Wait for a single completion notified by the fetcher thread.
+ */
+class receiver_t : public ResourcesFetcherEvents
+{
+public:
+  /***/
+  virtual void_t  on_download_succeeded( [[maybe_unused]] const std::string_view app_id,
+                                         [[maybe_unused]] const std::string_view name,
+                                         [[maybe_unused]] customer_request_t cr,
+                                         [[maybe_unused]] const std::type_info& type,
+                                         const byte_t* data,
+                                         uint_t length
+                                       ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_body = std::string( reinterpret_cast<const char*>(data), length );
+    m_done = true;
+    m_cv.notify_all();
+  }
+  /***/
+  virtual void_t  on_download_failed( [[maybe_unused]] const std::string_view app_id,
+                                      [[maybe_unused]] const std::string_view name,
+                                      [[maybe_unused]] customer_request_t cr
+                                    ) noexcept(true) override
+  {
+    std::lock_guard _mtx( m_mtx );
+    m_done = true;
+    m_cv.notify_all();
+  }
+
+  /***/
+  std::optional<std::string>  wait() noexcept(true)
+  {
+    std::unique_lock _lock( m_mtx );
+    if ( m_cv.wait_for( _lock, std::chrono::seconds( k_timeout_s ), [this]() { return m_done; } ) == false )
+      return std::nullopt;
+
+    return m_body;
+  }
+
+private:
+  std::mutex                  m_mtx;
+  std::condition_variable     m_cv;
+  bool_t                      m_done = false;
+  std::optional<std::string>  m_body;
+};
+
+static uint32_t s_failures = 0;
+
+/***/
+static void_t check( bool_t condition, const char* description ) noexcept(true)
+{
+  std::printf( "%s: %s\n", condition?"pass":"FAIL", description );
+  if ( condition == false )
+    s_failures++;
+}
+
+/**
+ * Fetch \param path with \param headers and wait for the body.
+ */
+static std::optional<std::string> get( test::HttpTestServer& server, const std::string& path, ResourcesFetcher::http_headers_t headers = {} ) noexcept(true)
+{
+  static uint32_t s_name = 0;
+  receiver_t      _receiver;
+
+  ResourcesFetcher::request_t _request = ResourcesFetcher::get_instance()->fetch( _receiver, std::string("cache"), std::to_string( ++s_name ), typeid(std::string),
+                                                                                  server.get_url( path ), customer_request_t::Get, 
+                                                                                  std::move(headers), {} );
+  if ( _request == ResourcesFetcher::k_invalid_request )
+    return std::nullopt;
+
+  return _receiver.wait();
+}
+
+int main( [[maybe_unused]] int argc, [[maybe_unused]] char** argv )
+{
+  const std::filesystem::path _path = std::filesystem::temp_directory_path() / core::utils::format( "ure_test_http_cache_%d", int(getpid()) );
+  std::error_code             _ec;
+  std::filesystem::remove_all( _path, _ec );
+
+  test::HttpTestServer _server( []( const std::string& path, const std::string& headers, test::HttpTestServer::response_t& response )
+                                {
+                                  if ( path == "/fresh" )
+                                  {
+                                    response.body          = "fresh body";
+                                    response.etag          = "\"f1\"";
+                                    response.cache_control = "max-age=3600";
+                                  }
+                                  else if ( path == "/revalidate" )
+                                  {
+                                    response.body          = "revalidated body";
+                                    response.etag          = "\"r1\"";
+                                    response.cache_control = "no-cache";
+                                  }
+                                  else if ( path == "/private" )
+                                  {
+                                    response.body          = "private " + test::HttpTestServer::get_header( headers, "authorization" );
+                                    response.cache_control = "max-age=3600";
+                                  }
+                                  else if ( path == "/vary" )
+                                  {
+                                    response.body          = "vary " + test::HttpTestServer::get_header( headers, "accept-language" );
+                                    response.cache_control = "max-age=3600";
+                                    response.vary          = "Accept-Language";
+                                  }
+                                  else
+                                    return false;
+
+                                  return true;
+                                } );
+  if ( _server.start() == false )
+  {
+    std::printf( "unable to start loopback server\n" );
+    return EXIT_FAILURE;
+  }
+
+  ResourcesFetcher::initialize();
+  ResourcesFetcher* pFetcher = ResourcesFetcher::get_instance();
+
+  if ( pFetcher->set_cache( _path.string() ) == false )
+  {
+    std::printf( "unable to open cache in %s\n", _path.string().c_str() );
+    pFetcher->finalize();
+    return EXIT_FAILURE;
+  }
+
+  /* Fresh response */
+  check( get( _server, "/fresh" ) == "fresh body",         "fresh response downloaded" );
+  check( get( _server, "/fresh" ) == "fresh body",         "fresh response served again" );
+  check( _server.get_requests() == 1,                      "fresh response served from disk without requests" );
+  check( pFetcher->get_stats().cache_hits == 1,            "cache hit counted" );
+
+  /* Response to be revalidated on each use */
+  _server.reset_counters();
+  check( get( _server, "/revalidate" ) == "revalidated body", "response downloaded" );
+  check( get( _server, "/revalidate" ) == "revalidated body", "response served after revalidation" );
+  check( ( _server.get_requests() == 2 ) && ( _server.get_not_modified() == 1 ), "revalidation answered with 304" );
+  check( pFetcher->get_stats().cache_revalidations == 1,   "revalidation counted" );
+
+  /* Credentials are part of the key */
+  _server.reset_counters();
+  check( get( _server, "/private", { "Authorization", "Bearer A" } ) == "private bearer a", "response for first credentials" );
+  check( get( _server, "/private", { "Authorization", "Bearer B" } ) == "private bearer b", "response for second credentials not shared" );
+  check( get( _server, "/private", { "Authorization", "Bearer A" } ) == "private bearer a", "response for first credentials served again" );
+  check( _server.get_requests() == 2,                      "responses cached for each credentials" );
+
+  /* Headers listed in Vary select the response */
+  _server.reset_counters();
+  check( get( _server, "/vary", { "Accept-Language", "en" } ) == "vary en", "response for first variant" );
+  check( get( _server, "/vary", { "Accept-Language", "it" } ) == "vary it", "response for second variant not shared" );
+  check( _server.get_requests() == 2,                      "each variant requested" );
+
+  /* Index is saved when the cache is released */
+  pFetcher->finalize();
+  _server.stop();
+
+  {
+    HttpCache                   _cache( _path.string() );
+    HttpCache::mapped_t         _mapped;
+    const HttpCache::headers_t  _headers;
+
+    check( _cache.find( _server.get_url( "/fresh" ), _headers ) != nullptr, "entry found after reopening the cache" );
+    check( _cache.open( _server.get_url( "/fresh" ), _headers, _mapped ) && 
+           ( std::string( reinterpret_cast<const char*>(_mapped.data()), _mapped.size() ) == "fresh body" ), "body read after reopening the cache" );
+  }
+
+  std::filesystem::remove_all( _path, _ec );
+
+  return ( s_failures == 0 )?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -0,0 +1,327 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+#ifndef URE_TEST_HTTP_SERVER_H
+#define URE_TEST_HTTP_SERVER_H
+
+#include "ure_common_defs.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ure {
+
+namespace test {
+
+/**
+ * Minimal HTTP/1.1 server listening on loopback, standing in for remote servers so that
+ * fetcher, cache and tile tests do not depend on the network.
+ * Each connection is served by its own thread and kept alive, responses are produced by
+ * a handler and conditional requests with If-None-Match are answered with 304.
+ */
+class HttpTestServer final
+{
+public:
+  /***/
+  struct response_t {
+    int_t         status;           /* 200 if not changed by the handler */
+    std::string   body;
+    std::string   etag;             /* ETag header, omitted when empty         */
+    std::string   cache_control;    /* Cache-Control header, omitted when empty */
+    std::string   vary;             /* Vary header, omitted when empty          */
+  };
+
+  /**
+   * Called from connection threads with the request path and the headers sent by
+   * the client, lower case names; return false to answer 404.
+   */
+  using handler_t = std::function<bool_t( const std::string& path, const std::string& headers, response_t& response )>;
+
+  /***/
+  explicit HttpTestServer( handler_t handler ) noexcept(true)
+    : m_handler( std::move(handler) ), m_socket( -1 ), m_port( 0 ), m_exit( false ),
+      m_latency_ms( 0 ), m_requests( 0 ), m_not_modified( 0 ), m_active( 0 ), m_max_active( 0 )
+  {}
+  /***/
+  ~HttpTestServer() noexcept(true)
+  { stop(); }
+
+  /**
+   * Listen on 127.0.0.1, \param port 0 selects a free port.
+   */
+  bool_t        start( uint16_t port = 0 ) noexcept(true)
+  {
+    m_socket = ::socket( AF_INET, SOCK_STREAM, 0 );
+    if ( m_socket < 0 )
+      return false;
+
+    int _reuse = 1;
+    ::setsockopt( m_socket, SOL_SOCKET, SO_REUSEADDR, &_reuse, sizeof(_reuse) );
+
+    sockaddr_in _addr = {};
+    _addr.sin_family      = AF_INET;
+    _addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    _addr.sin_port        = htons( port );
+
+    socklen_t _len = sizeof(_addr);
+    if ( ( ::bind( m_socket, reinterpret_cast<sockaddr*>(&_addr), sizeof(_addr) ) != 0 ) ||
+         ( ::listen( m_socket, 128 ) != 0 ) ||
+         ( ::getsockname( m_socket, reinterpret_cast<sockaddr*>(&_addr), &_len ) != 0 ) )
+    {
+      ::close( m_socket );
+      m_socket = -1;
+      return false;
+    }
+
+    m_port     = ntohs( _addr.sin_port );
+    m_exit     = false;
+    m_acceptor = std::thread( &HttpTestServer::acceptor, this );
+    return true;
+  }
+  /**
+   * Close listening socket and connections, then wait for their threads.
+   */
+  void_t        stop() noexcept(true)
+  {
+    if ( m_socket < 0 )
+      return;
+
+    m_exit = true;
+    ::shutdown( m_socket, SHUT_RDWR );
+    if ( m_acceptor.joinable() )
+      m_acceptor.join();
+    ::close( m_socket );
+    m_socket = -1;
+
+    std::vector<std::thread> _threads;
+    {
+      std::lock_guard _mtx( m_mtx );
+      for ( int _fd : m_connections )
+        ::shutdown( _fd, SHUT_RDWR );
+      _threads.swap( m_threads );
+    }
+
+    for ( std::thread& th : _threads )
+      th.join();
+  }
+
+  /**
+   * @return value of header \param name, lower case, in \param headers passed to the handler.
+   */
+  static std::string  get_header( const std::string& headers, const std::string& name ) noexcept(true)
+  {
+    const std::size_t _pos = headers.find( name + ": " );
+    if ( _pos == std::string::npos )
+      return {};
+
+    const std::size_t _value = _pos + name.size() + 2;
+    return headers.substr( _value, headers.find( "\r\n", _value ) - _value );
+  }
+
+  /***/
+  constexpr uint16_t  get_port() const noexcept(true)
+  { return m_port; }
+  /**
+   * @return url for \param path, that must start with '/'.
+   */
+  std::string   get_url( const std::string& path ) const noexcept(true)
+  { return "http://127.0.0.1:" + std::to_string( m_port ) + path; }
+
+  /**
+   * Delay applied to each response, simulating a distant server.
+   */
+  void_t        set_latency( uint32_t ms ) noexcept(true)
+  { m_latency_ms = ms; }
+
+  /***/
+  uint32_t      get_requests() const noexcept(true)
+  { return m_requests; }
+  /***/
+  uint32_t      get_not_modified() const noexcept(true)
+  { return m_not_modified; }
+  /**
+   * @return highest number of requests served at the same time.
+   */
+  uint32_t      get_max_active() const noexcept(true)
+  { return m_max_active; }
+  /***/
+  void_t        reset_counters() noexcept(true)
+  { m_requests = 0; m_not_modified = 0; m_max_active = 0; }
+
+private:
+  /***/
+  void_t        acceptor() noexcept(true)
+  {
+    while ( m_exit == false )
+    {
+      int _fd = ::accept( m_socket, nullptr, nullptr );
+      if ( _fd < 0 )
+        break;
+
+      std::lock_guard _mtx( m_mtx );
+      m_connections.push_back( _fd );
+      m_threads.emplace_back( &HttpTestServer::connection, this, _fd );
+    }
+  }
+
+  /***/
+  void_t        connection( int fd ) noexcept(true)
+  {
+    std::string _buffer;
+    char        _chunk[4096];
+
+    while ( m_exit == false )
+    {
+      std::size_t _end = _buffer.find( "\r\n\r\n" );
+      if ( _end == std::string::npos )
+      {
+        ssize_t _read = ::recv( fd, _chunk, sizeof(_chunk), 0 );
+        if ( _read <= 0 )
+          break;
+
+        _buffer.append( _chunk, std::size_t(_read) );
+        continue;
+      }
+
+      /* Requests sent by the tests have no body */
+      std::string _request = _buffer.substr( 0, _end + 2 );
+      _buffer.erase( 0, _end + 4 );
+
+      if ( serve( fd, _request ) == false )
+        break;
+    }
+
+    std::lock_guard _mtx( m_mtx );
+    m_connections.erase( std::find( m_connections.begin(), m_connections.end(), fd ) );
+    ::close( fd );
+  }
+
+  /***/
+  bool_t        serve( int fd, std::string& request ) noexcept(true)
+  {
+    const uint32_t _active = ++m_active;
+    uint32_t       _max    = m_max_active;
+    while ( ( _active > _max ) && ( m_max_active.compare_exchange_weak( _max, _active ) == false ) )
+    {}
+
+    m_requests++;
+
+    /* Request line, e.g. "GET /path HTTP/1.1", then headers lowered for lookups */
+    const std::size_t _first  = request.find( ' ' );
+    const std::size_t _second = request.find( ' ', _first + 1 );
+    const std::size_t _eol    = request.find( "\r\n" );
+    const std::string _path   = request.substr( _first + 1, _second - _first - 1 );
+    std::string       _headers= request.substr( _eol + 2 );
+
+    std::transform( _headers.begin(), _headers.end(), _headers.begin(), [](unsigned char c) { return std::tolower(c); } );
+
+    response_t _response{ 200, {}, {}, {}, {} };
+    if ( m_handler( _path, _headers, _response ) == false )
+      _response.status = 404;
+
+    if ( m_latency_ms > 0 )
+      std::this_thread::sleep_for( std::chrono::milliseconds( m_latency_ms ) );
+
+    bool_t _not_modified = false;
+    if ( ( _response.status == 200 ) && ( _response.etag.empty() == false ) )
+    {
+      std::string _etag = _response.etag;
+      std::transform( _etag.begin(), _etag.end(), _etag.begin(), [](unsigned char c) { return std::tolower(c); } );
+      _not_modified = ( _headers.find( "if-none-match: " + _etag ) != std::string::npos );
+    }
+
+    std::string _reply;
+    if ( _not_modified )
+    {
+      m_not_modified++;
+      _reply = "HTTP/1.1 304 Not Modified\r\n";
+    }
+    else
+    {
+      _reply = "HTTP/1.1 " + std::to_string( _response.status ) + ( ( _response.status == 200 )?" OK\r\n":" Error\r\n" );
+    }
+
+    if ( _response.etag.empty() == false )
+      _reply += "ETag: " + _response.etag + "\r\n";
+    if ( _response.cache_control.empty() == false )
+      _reply += "Cache-Control: " + _response.cache_control + "\r\n";
+    if ( _response.vary.empty() == false )
+      _reply += "Vary: " + _response.vary + "\r\n";
+
+    const std::size_t _length = ( _not_modified )?0:_response.body.size();
+    _reply += "Content-Length: " + std::to_string( _length ) + "\r\n\r\n";
+    if ( _not_modified == false )
+      _reply += _response.body;
+
+    m_active--;
+
+    return send_all( fd, _reply );
+  }
+
+  /***/
+  static bool_t send_all( int fd, const std::string& data ) noexcept(true)
+  {
+    std::size_t _sent = 0;
+    while ( _sent < data.size() )
+    {
+      ssize_t _count = ::send( fd, data.data() + _sent, data.size() - _sent, MSG_NOSIGNAL );
+      if ( _count <= 0 )
+        return false;
+      _sent += std::size_t(_count);
+    }
+    return true;
+  }
+
+private:
+  handler_t                 m_handler;
+  int                       m_socket;
+  uint16_t                  m_port;
+  std::atomic<bool_t>       m_exit;
+  std::atomic<uint32_t>     m_latency_ms;
+  std::atomic<uint32_t>     m_requests;
+  std::atomic<uint32_t>     m_not_modified;
+  std::atomic<uint32_t>     m_active;
+  std::atomic<uint32_t>     m_max_active;
+  std::thread               m_acceptor;
+  std::mutex                m_mtx;
+  std::vector<int>          m_connections;
+  std::vector<std::thread>  m_threads;
+};
+
+}
+
+}
+
+#endif // URE_TEST_HTTP_SERVER_H
@@ -0,0 +1,324 @@
+/**************************************************************************************************
+ * 
+ * Copyright 2022 https://github.com/fe-dagostino
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this 
+ * software and associated documentation files (the "Software"), to deal in the Software 
+ * without restriction, including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to 
+ * permit persons to whom the Software is furnished to do so, subject to the following 
+ * conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies 
+ * or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR 
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE 
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR 
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *************************************************************************************************/
+
+/**
+ * TileMapLayer test against a local tile server: tiles are generated on request and
+ * some of them fail the first times they are requested, so the layer must load them
+ * again with an increasing delay until every visible tile is resident.
+ * A window with a GL context is required, the test is skipped when it can't be created.
+ */
+
+#include "ure_application.h"
+#include "ure_image_decoder.h"
+#include "ure_resources_fetcher.h"
+#include "ure_scene_camera_node.h"
+#include "ure_scene_graph.h"
+#include "ure_scene_layer_node.h"
+#include "ure_view_port.h"
+#include "ure_window.h"
+#include "ure_window_options.h"
+#include "widgets/ure_tile_map_layer.h"
+#include "ure_test_http_server.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+using namespace ure;
+
+using TileMapLayer = widgets::TileMapLayer;
+
+static constexpr int      k_skipped    = 77;      /* SKIP_RETURN_CODE for ctest */
+static constexpr uint32_t k_failures   = 2;       /* failed responses before a tile is served */
+static constexpr double_t k_timeout_s  = 30.0;
+static constexpr int_t    k_size       = 512;
+
+/**
+ * 24 bits BMP tile filled with a color depending on \param x and \param y.
+ */
+static std::string make_tile( uint32_t x, uint32_t y ) noexcept(true)
+{
+  const uint32_t _image = TileMapLayer::k_tile_size * TileMapLayer::k_tile_size * 3;
+  std::string    _bmp( 54 + _image, '\0' );
+
+  auto put32 = [&_bmp]( std::size_t offset, uint32_t value ) {
+    for ( uint32_t i = 0; i < 4; ++i )
+      _bmp[offset + i] = char( ( value >> ( i * 8 ) ) & 0xFF );
+  };
+
+  _bmp[0] = 'B'; _bmp[1] = 'M';
+  put32(  2, uint32_t(_bmp.size()) );
+  put32( 10, 54 );
+  put32( 14, 40 );
+  put32( 18, TileMapLayer::k_tile_size );
+  put32( 22, TileMapLayer::k_tile_size );
+  put32( 26, 1 | ( 24 << 16 ) );      /* planes and bits per pixel */
+  put32( 34, _image );
+
+  for ( uint32_t i = 0; i < _image; i += 3 )
+  {
+    _bmp[54 + i + 0] = char( 64 + ( x * 50 ) % 192 );
+    _bmp[54 + i + 1] = char( 64 + ( y * 80 ) % 192 );
+    _bmp[54 + i + 2] = char( 128 );
+  }
+
+  return _bmp;
+}
+
+/**
+ * Requests received by the tile server for each tile.
+ */
+class tile_server_t
+{
+public:
+  /***/
+  tile_server_t() noexcept(true)
+    : m_server( [this]( const std::string& path, [[maybe_unused]] const std::string& headers, test::HttpTestServer::response_t& response ) 
+                { return serve( path, response ); } ),
+      m_start( std::chrono::steady_clock::now() )
+  {}
+
+  /***/
+  bool_t              start() noexcept(true)
+  { return m_server.start(); }
+  /***/
+  void_t              stop() noexcept(true)
+  { m_server.stop(); }
+  /***/
+  std::string         get_url() const noexcept(true)
+  { return m_server.get_url( "/{z}/{x}/{y}.bmp" ); }
+
+  /**
+   * Report requests for tiles that failed and check that each retry waited longer than the previous one.
+   */
+  bool_t              report() noexcept(true)
+  {
+    std::lock_guard _mtx( m_mtx );
+
+    bool_t   _backoff = true;
+    uint32_t _failing = 0;
+    for ( const auto& [path, times] : m_requests )
+    {
+      if ( is_failing( path ) == false )
+        continue;
+
+      std::string _intervals;
+      for ( std::size_t i = 1; i < times.size(); ++i )
+      {
+        _intervals += core::utils::format( " %.2fs", times[i] - times[i-1] );
+        if ( ( i >= 2 ) && ( ( times[i] - times[i-1] ) < 1.5 * ( times[i-1] - times[i-2] ) ) )
+          _backoff = false;
+      }
+
+      std::printf( "%-16s %zu requests, retried after%s\n", path.c_str(), times.size(), _intervals.c_str() );
+      _failing += ( times.size() > k_failures )?1:0;
+    }
+
+    std::printf( "%u failing tiles loaded, retry delay %s\n", _failing, _backoff?"doubled":"NOT doubled" );
+    return ( _failing > 0 ) && _backoff;
+  }
+
+private:
+  /* Tiles on even diagonals fail the first k_failures times */
+  static bool_t       is_failing( const std::string& path ) noexcept(true)
+  {
+    uint32_t z = 0, x = 0, y = 0;
+    return ( std::sscanf( path.c_str(), "/%u/%u/%u.bmp", &z, &x, &y ) == 3 ) && ( ( x + y ) % 2 == 0 );
+  }
+
+  /***/
+  bool_t              serve( const std::string& path, test::HttpTestServer::response_t& response ) noexcept(true)
+  {
+    uint32_t z = 0, x = 0, y = 0;
+    if ( std::sscanf( path.c_str(), "/%u/%u/%u.bmp", &z, &x, &y ) != 3 )
+      return false;
+
+    std::size_t _count = 0;
+    {
+      std::lock_guard _mtx( m_mtx );
+      std::vector<double_t>& _times = m_requests[path];
+      _times.push_back( std::chrono::duration<double_t>( std::chrono::steady_clock::now() - m_start ).count() );
+      _count = _times.size();
+    }
+
+    if ( is_failing( path ) && ( _count <= k_failures ) )
+    {
+      response.status = 503;
+      return true;
+    }
+
+    response.body = make_tile( x, y );
+    return true;
+  }
+
+private:
+  test::HttpTestServer                                m_server;
+  const std::chrono::steady_clock::time_point         m_start;
+  std::mutex                                          m_mtx;
+  std::map<std::string, std::vector<double_t>>        m_requests;
+};
+
+/**
+ * Application events, fetcher and decoder follow the application lifetime as in the examples.
+ */
+class tile_map_test_t : public ApplicationEvents
+{
+public:
+  /***/
+  virtual void_t on_initialize() noexcept(true) override
+  {
+    ResourcesFetcher::initialize();
+    ResourcesFetcher::get_instance()->set_dispatch( true );
+    ImageDecoder::initialize();
+  }
+  /***/
+  virtual void_t on_initialized() noexcept(true) override {}
+  /***/
+  virtual void_t on_finalize() noexcept(true) override
+  {
+    m_map.reset();
+    m_view_port.reset();
+
+    ResourcesFetcher::get_instance()->finalize();
+    ImageDecoder::get_instance()->finalize();
+  }
+  /***/
+  virtual void_t on_finalized() noexcept(true) override {}
+  /***/
+  virtual void_t on_run() noexcept(true) override
+  {
+    ResourcesFetcher::get_instance()->dispatch();
+
+    m_view_port->use();
+    m_view_port->clear_buffer( GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT );
+    m_view_port->render();
+
+    m_window->swap_buffers();
+    m_window->process_message();
+
+    Application::get_instance()->poll_events();
+  }
+  /***/
+  virtual void_t on_initialize_error() noexcept(true) override {}
+  /***/
+  virtual void_t on_error( [[maybe_unused]] int32_t error, [[maybe_unused]] std::string_view description ) noexcept(true) override {}
+  /***/
+  virtual void_t on_finalize_error() noexcept(true) override {}
+
+  /***/
+  bool_t        create( const std::string& url ) noexcept(true)
+  {
+    m_window = std::make_unique<Window>();
+    if ( m_window->create( std::make_unique<window_options>( "", "TileMapLayer test", Position{0,0}, Size{k_size,k_size} ) ) == false )
+      return false;
+
+    m_view_port = std::make_unique<ViewPort>( std::make_unique<SceneGraph>(), glm::perspectiveFov( 45.0f, float(k_size), float(k_size), 0.1f, 500.0f ) );
+    m_view_port->set_area( 0, 0, k_size, k_size );
+
+    camera_ptr camera = std::make_shared<Camera>( true );
+    camera->set_view_matrix( glm::lookAt( glm::vec3(0,0,1), glm::vec3(0,0,0), glm::vec3(0,1,0) ) );
+    m_view_port->get_scene().add_scene_node( new SceneCameraNode( "Camera", camera ) );
+
+    m_map = std::make_shared<TileMapLayer>( *m_view_port, url );
+    m_map->set_visible( true );
+    m_map->set_enabled( true );
+    m_map->set_position( -k_size/2, -k_size/2, true );
+    m_map->set_size( k_size, k_size, true );
+    m_map->set_prefetch( 0 );
+    m_map->set_center( 12.4964, 41.9028 );
+    m_map->set_zoom( 3.0 );
+
+    SceneLayerNode* pNode = new(std::nothrow) SceneLayerNode( "Map", m_map );
+    if ( pNode == nullptr )
+      return false;
+
+    pNode->set_model_matrix( glm::ortho( -float(k_size)/2, float(k_size)/2, float(k_size)/2, -float(k_size)/2, 0.1f, 500.0f ) );
+    return ( m_view_port->get_scene().add_scene_node( pNode ) != k_invalid_handle );
+  }
+
+  /***/
+  void_t        destroy() noexcept(true)
+  {
+    if ( m_window != nullptr )
+      m_window->destroy();
+  }
+
+  /**
+   * @return true when every visible tile is drawn with its own image.
+   */
+  bool_t        is_complete() const noexcept(true)
+  {
+    const TileMapLayer::stats_t& stats = m_map->get_stats();
+    return ( stats.visible > 0 ) && ( stats.resident == stats.visible );
+  }
+
+  /***/
+  void_t        report() const noexcept(true)
+  {
+    const TileMapLayer::stats_t& stats = m_map->get_stats();
+    std::printf( "%u visible tiles, %u resident, %u drawn with an ancestor, %u failed loads\n", 
+                 stats.visible, stats.resident, stats.fallback, m_map->get_loader().get_stats().failed );
+  }
+
+private:
+  std::unique_ptr<Window>         m_window;
+  std::unique_ptr<ViewPort>       m_view_port;
+  std::shared_ptr<TileMapLayer>   m_map;
+};
+
+int main( [[maybe_unused]] int argc, [[maybe_unused]] char** argv )
+{
+  tile_server_t _server;
+  if ( _server.start() == false )
+  {
+    std::printf( "unable to start tile server\n" );
+    return EXIT_FAILURE;
+  }
+
+  tile_map_test_t _test;
+  Application::initialize( core::unique_ptr<ApplicationEvents>( &_test, false ), "./resources/shaders/" );
+
+  if ( _test.create( _server.get_url() ) == false )
+  {
+    std::printf( "unable to create a window, test skipped\n" );
+    Application::get_instance()->finalize();
+    return k_skipped;
+  }
+
+  const double_t _start = Application::get_instance()->get_time();
+  while ( ( _test.is_complete() == false ) && ( Application::get_instance()->get_time() - _start < k_timeout_s ) )
+  {
+    _test.on_run();
+  }
+
+  std::printf( "completed in %.2fs\n", Application::get_instance()->get_time() - _start );
+  _test.report();
+
+  const bool_t _passed = _test.is_complete() && _server.report();
+
+  _test.destroy();
+  Application::get_instance()->finalize();
+  _server.stop();
+
+  return _passed?EXIT_SUCCESS:EXIT_FAILURE;
+}